@@ -0,0 +1,99 @@
+#!/bin/sh
+#
+# bench.sh: End-to-end throughput benchmarks of the conversion tools on
+# synthetic corpora, with the results written as JSON.
+#
+# Usage: bench/bench.sh [size_in_MiB ...]
+#
+# Run by `make bench`. For each size (default 1 and 16 MiB of data), a
+# set of IHEX files is generated with `ihexgen`: dense data with 8, 16,
+# 32, and 255 bytes per line, sparse data, blocks out of address order,
+# segmented addresses (type 02 records), CRLF line endings, and noisy
+# whitespace. Then `ihexbench` times ihex2bin on each of them, and
+# bin2ihex, split16bit and merge16bit (both binary and IHEX) on the dense
+# data. The sizes can go up to 4096 MiB, given enough disk space in the
+# corpus directory.
+#
+# The results are written to standard output as a JSON array, one
+# benchmark per line. The environment variables are:
+#
+#   BINPATH     directory of the built programs (default ./)
+#   BENCHPATH   directory of ihexgen and ihexbench (default bench/)
+#   BENCH_DIR   directory for the corpora (default $TMPDIR or /tmp)
+#   BENCH_RUNS  number of runs per benchmark, the median is used (default 3)
+#
+
+BINPATH="${BINPATH:-./}"
+BENCHPATH="${BENCHPATH:-bench/}"
+RUNS="${BENCH_RUNS:-3}"
+DIR="${BENCH_DIR:-${TMPDIR:-/tmp}}/kk_ihex_bench.$$"
+[ $# -eq 0 ] && set -- 1 16
+
+mkdir -p "$DIR" || exit 1
+trap 'rm -rf "$DIR"' EXIT INT TERM
+
+first=1
+
+# bench <name> <input> <records> <command> [<arguments> ...]
+# (sh has no local variables, hence the prefixed names)
+bench() {
+    bench_name="$1"
+    bench_input="$2"
+    bench_records="$3"
+    shift 3
+    result=$("${BENCHPATH}ihexbench" -n "$RUNS" -N "$bench_name" \
+             -i "$bench_input" -r "$bench_records" -- "$@") || exit 1
+    if [ "$first" -eq 1 ]; then
+        printf '[\n%s' "$result"
+        first=0
+    else
+        printf ',\n%s' "$result"
+    fi
+}
+
+# corpus <file> <ihexgen arguments ...>, prints the number of records
+corpus() {
+    file="$1"
+    shift
+    summary=$("${BENCHPATH}ihexgen" -o "$file" "$@" 2>&1) || {
+        echo "$summary" >&2
+        exit 1
+    }
+    echo "${summary%% *}"
+}
+
+for mib in "$@"; do
+    size="${mib}M"
+
+    for spec in dense-8:"-b 8" dense-16:"-b 16" dense-32:"-b 32" \
+                  dense-255:"-b 255" sparse-32:"-k sparse" \
+                  shuffled-32:"-k shuffled" segmented-16:"-k segmented -b 16" \
+                  crlf-32:"-c" noisy-32:"-n"; do
+        name="${spec%%:*}"
+        options="${spec#*:}"
+        hex="$DIR/$name.hex"
+        records=$(corpus "$hex" -s "$size" $options) || exit 1
+        bench "ihex2bin/$name/${mib}M" "$hex" "$records" \
+              "${BINPATH}ihex2bin" -i "$hex" -o "$DIR/out.bin"
+        if [ "$name" = dense-32 ]; then
+            mv "$DIR/out.bin" "$DIR/dense.bin"
+            bench "bin2ihex/dense-32/${mib}M" "$DIR/dense.bin" "$records" \
+                  "${BINPATH}bin2ihex" -i "$DIR/dense.bin" -o "$DIR/out.hex"
+            bench "split16bit/bin/${mib}M" "$DIR/dense.bin" -1 \
+                  "${BINPATH}split16bit" -i "$DIR/dense.bin" \
+                  -h "$DIR/high.bin" -l "$DIR/low.bin"
+            bench "merge16bit/bin/${mib}M" "$DIR/dense.bin" -1 \
+                  "${BINPATH}merge16bit" -h "$DIR/high.bin" -l "$DIR/low.bin" \
+                  -o "$DIR/out.bin"
+            bench "split16bit/hex/${mib}M" "$hex" "$records" \
+                  "${BINPATH}split16bit" -x -i "$hex" \
+                  -h "$DIR/high.hex" -l "$DIR/low.hex"
+            bench "merge16bit/hex/${mib}M" "$hex" "$records" \
+                  "${BINPATH}merge16bit" -x -h "$DIR/high.hex" -l "$DIR/low.hex" \
+                  -o "$DIR/out.hex"
+            rm -f "$DIR/dense.bin" "$DIR"/high.* "$DIR"/low.*
+        fi
+        rm -f "$hex" "$DIR"/out.*
+    done
+done
+printf '\n]\n'
@@ -0,0 +1,381 @@
+/*
+ * ihexbench.c: Time a command and report the results as JSON, or compare
+ * two sets of results.
+ *
+ * Usage: ihexbench [-n <runs>] [-N <name>] [-i <input_file>]
+ *                  [-r <records>] -- <command> [<arguments> ...]
+ *        ihexbench -c <baseline.json> <results.json> [-t <percent>]
+ *
+ * In the first form, the command is run the given number of times
+ * (default 3), with its standard output discarded, and one line of JSON
+ * is written to standard output with the name of the benchmark, the
+ * median and minimum wall-clock time, the throughput of the input file
+ * in MB/s and records per second (if the number of records is given with
+ * `-r`), the peak resident set size (RSS), and the number of read and
+ * write system calls of the command (where supported, i.e., on Linux;
+ * otherwise -1).
+ *
+ * In the second form, two files of such lines are compared by name, and
+ * each benchmark whose throughput is more than the given percentage
+ * (default 5) lower, or whose peak RSS is that much higher, than in the
+ * baseline is flagged as a regression. The exit status is 1 if any
+ * regressions were found.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_RUNS 101
+#define NAME_LENGTH 128
+
+struct result {
+    char    name[NAME_LENGTH];
+    double  mb_per_s;
+    double  max_rss_kb;
+};
+
+static int
+compare_doubles (const void *a, const void *b) {
+    const double da = *(const double *) a;
+    const double db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+// Read the read and write system call counts of the zombie process `pid`
+// (Linux only), returns false if not available.
+//
+static bool
+read_syscalls (const pid_t pid, long long *reads, long long *writes) {
+    char path[64];
+    char line[128];
+    FILE *file;
+    int found = 0;
+
+    (void) snprintf(path, sizeof(path), "/proc/%ld/io", (long) pid);
+    if (!(file = fopen(path, "r"))) {
+        return false;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        found += (sscanf(line, "syscr: %lld", reads) == 1);
+        found += (sscanf(line, "syscw: %lld", writes) == 1);
+    }
+    (void) fclose(file);
+    return found == 2;
+}
+
+// Run `argv` once, returns the wall-clock time in seconds or a negative
+// number on failure.
+//
+static double
+run (char *argv[], long long *reads, long long *writes) {
+    struct timespec start, end;
+    siginfo_t info;
+    int status;
+    pid_t pid;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &start);
+    if ((pid = fork()) < 0) {
+        perror("fork");
+        return -1.0;
+    }
+    if (pid == 0) {
+        const int null = open("/dev/null", O_WRONLY);
+        if (null >= 0) {
+            (void) dup2(null, STDOUT_FILENO);
+        }
+        (void) execvp(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    // wait without reaping, so the counters of the process can be read
+    info.si_pid = 0;
+    while (waitid(P_PID, (id_t) pid, &info, WEXITED | WNOWAIT) && errno == EINTR) { }
+    (void) clock_gettime(CLOCK_MONOTONIC, &end);
+    if (!read_syscalls(pid, reads, writes)) {
+        *reads = -1;
+        *writes = -1;
+    }
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        (void) fprintf(stderr, "%s: failed\n", argv[0]);
+        return -1.0;
+    }
+    return (double) (end.tv_sec - start.tv_sec) +
+           (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Parse a line of JSON output into `result`, returns false if not valid.
+//
+static bool
+parse_result (const char *line, struct result *result) {
+    const char *s;
+    size_t length;
+
+    if (!(s = strstr(line, "\"name\":\""))) {
+        return false;
+    }
+    s += 8;
+    length = strcspn(s, "\"");
+    if (length >= NAME_LENGTH) {
+        return false;
+    }
+    (void) memcpy(result->name, s, length);
+    result->name[length] = '\0';
+    if (!(s = strstr(line, "\"mb_per_s\":")) ||
+        sscanf(s + 11, "%lf", &result->mb_per_s) != 1) {
+        return false;
+    }
+    if (!(s = strstr(line, "\"max_rss_kb\":")) ||
+        sscanf(s + 13, "%lf", &result->max_rss_kb) != 1) {
+        result->max_rss_kb = -1.0;
+    }
+    return true;
+}
+
+static struct result *
+read_results (const char *name, unsigned *count) {
+    struct result *results = NULL;
+    unsigned capacity = 0;
+    char line[1024];
+    FILE *file;
+
+    *count = 0;
+    if (!(file = fopen(name, "r"))) {
+        perror(name);
+        return NULL;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        struct result result;
+        if (!parse_result(line, &result)) {
+            continue;
+        }
+        if (*count == capacity) {
+            struct result *more;
+            capacity = capacity ? capacity * 2U : 64U;
+            if (!(more = realloc(results, capacity * sizeof(*results)))) {
+                perror("realloc");
+                free(results);
+                (void) fclose(file);
+                return NULL;
+            }
+            results = more;
+        }
+        results[(*count)++] = result;
+    }
+    (void) fclose(file);
+    if (!results) {
+        (void) fprintf(stderr, "%s: No results\n", name);
+    }
+    return results;
+}
+
+static int
+compare (const char *baseline_name, const char *results_name, const double threshold) {
+    struct result *baseline, *results;
+    unsigned baseline_count, results_count;
+    unsigned regressions = 0;
+    unsigned i, j;
+
+    if (!(baseline = read_results(baseline_name, &baseline_count)) ||
+        !(results = read_results(results_name, &results_count))) {
+        free(baseline);
+        return 2;
+    }
+    for (i = 0; i < results_count; ++i) {
+        const struct result * const r = &results[i];
+        const struct result *b = NULL;
+        double speed, rss = 0.0;
+        bool regression;
+
+        for (j = 0; j < baseline_count && !b; ++j) {
+            if (!strcmp(baseline[j].name, r->name)) {
+                b = &baseline[j];
+            }
+        }
+        if (!b) {
+            (void) printf("%-40s %10.1f MB/s (new)\n", r->name, r->mb_per_s);
+            continue;
+        }
+        speed = (b->mb_per_s > 0.0) ? (r->mb_per_s / b->mb_per_s - 1.0) * 100.0 : 0.0;
+        if (b->max_rss_kb > 0.0 && r->max_rss_kb > 0.0) {
+            rss = (r->max_rss_kb / b->max_rss_kb - 1.0) * 100.0;
+        }
+        regression = (speed < -threshold || rss > threshold);
+        regressions += regression;
+        (void) printf("%-40s %10.1f MB/s %+7.1f%% RSS %+7.1f%%%s\n",
+                      r->name, r->mb_per_s, speed, rss,
+                      regression ? "  REGRESSION" : "");
+    }
+    (void) printf("%u regressions\n", regressions);
+    free(baseline);
+    free(results);
+    return regressions ? 1 : 0;
+}
+
+int
+main (int argc, char *argv[]) {
+    const char *name = NULL;
+    const char *input = NULL;
+    const char *baseline = NULL;
+    const char *results = NULL;
+    unsigned long runs = 3;
+    double records = -1.0;
+    double threshold = 5.0;
+    double times[MAX_RUNS];
+    double megabytes = 0.0;
+    long long reads = -1, writes = -1;
+    struct rusage usage;
+    unsigned long i;
+    char *arg = NULL;
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] == '-' && arg[2] == '\0') {
+            ++argv;
+            --argc;
+            break;
+        }
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'n':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                runs = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !runs || runs > MAX_RUNS) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'N':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                name = *(++argv);
+                break;
+            case 'i':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                input = *(++argv);
+                break;
+            case 'r':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                records = strtod(*argv, &arg);
+                if (errno || arg == *argv) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'c':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                baseline = *(++argv);
+                break;
+            case 't':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                threshold = strtod(*argv, &arg);
+                if (errno || arg == *argv || threshold < 0.0) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        } else if (baseline && !results) {
+            results = arg;
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "Usage: ihexbench [-n <runs>] [-N <name>] [-i <input_file>]"
+                               " [-r <records>]\n"
+                               "                 -- <command> [<arguments> ...]\n"
+                               "       ihexbench -c <baseline.json> <results.json>"
+                               " [-t <percent>]\n");
+        return arg ? 2 : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return 2;
+    }
+
+    if (baseline) {
+        if (!results || argc) {
+            arg = "";
+            goto usage;
+        }
+        return compare(baseline, results, threshold);
+    }
+    if (!argc) {
+        arg = "";
+        goto usage;
+    }
+    if (input) {
+        struct stat st;
+        if (stat(input, &st)) {
+            perror(input);
+            return 2;
+        }
+        megabytes = (double) st.st_size / 1e6;
+    }
+
+    for (i = 0; i < runs; ++i) {
+        if ((times[i] = run(argv, &reads, &writes)) < 0.0) {
+            return 2;
+        }
+    }
+    if (getrusage(RUSAGE_CHILDREN, &usage)) {
+        usage.ru_maxrss = -1;
+    }
+    qsort(times, runs, sizeof(times[0]), compare_doubles);
+
+    {
+        const double median = (runs & 1U) ? times[runs / 2U] :
+                              (times[runs / 2U - 1U] + times[runs / 2U]) / 2.0;
+        const double seconds = (median > 0.0) ? median : 1e-9;
+        (void) printf("{\"name\":\"%s\",\"runs\":%lu,\"seconds\":%.6f,"
+                      "\"min_seconds\":%.6f,\"input_bytes\":%.0f,"
+                      "\"mb_per_s\":%.2f,\"records\":%.0f,\"records_per_s\":%.0f,"
+                      "\"max_rss_kb\":%ld,\"read_syscalls\":%lld,"
+                      "\"write_syscalls\":%lld}\n",
+                      name ? name : argv[0], runs, median, times[0],
+                      megabytes * 1e6, megabytes / seconds,
+                      records, (records >= 0.0) ? records / seconds : -1.0,
+                      (long) usage.ru_maxrss, reads, writes);
+    }
+    return fflush(stdout) ? 2 : EXIT_SUCCESS;
+}
@@ -0,0 +1,383 @@
+/*
+ * ihexgen.c: Generate deterministic synthetic Intel HEX for benchmarks.
+ *
+ * Usage: ihexgen [-k <kind>] [-s <size>] [-b <length>] [-r <seed>]
+ *                [-c] [-n] [-o <out.hex>]
+ *
+ * The option `-s` sets the number of data bytes (suffixes K, M, and G
+ * are accepted, default 1M), and `-b` the number of data bytes per line
+ * (default 32). The data is pseudorandom from the seed given with `-r`,
+ * i.e., the same options always generate the same file. The kind of the
+ * file is one of:
+ *
+ *      dense       contiguous data from address 0 (the default)
+ *      sparse      256-byte runs of data separated by gaps
+ *      shuffled    contiguous data written as 4 KiB blocks in a
+ *                  pseudorandom order, i.e., out of address order
+ *      segmented   extended segment address (type 02) records; the data
+ *                  wraps around in the 1 MiB segmented address space
+ *      segwrap     the same data as `dense` (at most 1 MiB), but written
+ *                  as 32-byte records whose 16-bit offset wraps around to
+ *                  zero in the middle, each with its own segment, i.e., a
+ *                  test corpus for the segmented address arithmetic
+ *
+ * The option `-c` writes CRLF line endings, and `-n` adds whitespace
+ * noise (spaces and tabs) inside and around the records. The number of
+ * records and data bytes written is printed on standard error.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#include "../kk_ihex_write.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define BLOCK_SIZE          4096U
+#define SPARSE_RUN          256U
+#define SPARSE_MAX_STRIDE   1024U
+#define SEGMENTED_SPACE     0x100000ULL
+#define ADDRESS_SPACE       0x100000000ULL
+
+enum kind {
+    KIND_DENSE,
+    KIND_SPARSE,
+    KIND_SHUFFLED,
+    KIND_SEGMENTED,
+    KIND_SEGWRAP
+};
+
+static const char * const kind_names[] = {
+    "dense", "sparse", "shuffled", "segmented", "segwrap", NULL
+};
+
+static FILE *outfile;
+static bool crlf = false;
+static bool noise = false;
+static unsigned long long records = 0;
+static uint_least64_t random_state;
+static unsigned long noise_state = 1;
+
+// xorshift64*
+static uint_least64_t
+next_random (void) {
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return (random_state * 0x2545F4914F6CDD1DULL) & 0xFFFFFFFFFFFFFFFFULL;
+}
+
+static void
+fill_random (uint8_t *data, size_t count) {
+    while (count) {
+        uint_least64_t r = next_random();
+        unsigned i;
+        for (i = 0; i < 8U && count; ++i, --count) {
+            *data++ = (uint8_t) r;
+            r >>= 8;
+        }
+    }
+}
+
+static unsigned long long
+gcd (unsigned long long a, unsigned long long b) {
+    while (b) {
+        const unsigned long long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Parse a size with an optional K, M, or G suffix.
+//
+static bool
+parse_size (const char *s, unsigned long long *size) {
+    char *end;
+    errno = 0;
+    *size = strtoull(s, &end, 0);
+    if (errno || end == s) {
+        return false;
+    }
+    switch (*end) {
+    case 'G': case 'g':
+        *size <<= 10;
+        // fallthrough
+    case 'M': case 'm':
+        *size <<= 10;
+        // fallthrough
+    case 'K': case 'k':
+        *size <<= 10;
+        ++end;
+        break;
+    default:
+        break;
+    }
+    return *end == '\0';
+}
+
+int
+main (int argc, char *argv[]) {
+    struct ihex_state ihex;
+    enum kind kind = KIND_DENSE;
+    unsigned long long size = 1024ULL * 1024ULL;
+    unsigned long long written = 0;
+    unsigned long line_length = 32;
+    unsigned long long seed = 1;
+    uint8_t block[BLOCK_SIZE];
+    char *arg = NULL;
+
+    outfile = stdout;
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'k': {
+                unsigned i;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                arg = *(++argv);
+                for (i = 0; kind_names[i] && strcmp(arg, kind_names[i]); ++i) { }
+                if (!kind_names[i]) {
+                    goto invalid_argument;
+                }
+                kind = (enum kind) i;
+                break;
+            }
+            case 's':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                arg = *(++argv);
+                if (!parse_size(arg, &size) || !size) {
+                    goto invalid_argument;
+                }
+                break;
+            case 'b':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                line_length = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !line_length ||
+                    line_length > IHEX_MAX_OUTPUT_LINE_LENGTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'r':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                seed = strtoull(*argv, &arg, 0);
+                if (errno || arg == *argv) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'c':
+                crlf = true;
+                break;
+            case 'n':
+                noise = true;
+                break;
+            case 'o':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(outfile = fopen(*argv, "wb"))) {
+                    goto argument_error;
+                }
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "Usage: ihexgen [-k dense|sparse|shuffled|segmented|segwrap]"
+                               " [-s <size>]\n"
+                               "               [-b <length>] [-r <seed>] [-c] [-n]"
+                               " [-o <out.hex>]\n");
+        return arg ? EXIT_FAILURE : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_FAILURE;
+    }
+
+    random_state = (seed * 0x9E3779B97F4A7C15ULL + 1U) & 0xFFFFFFFFFFFFFFFFULL;
+    if (!random_state) {
+        random_state = 1;
+    }
+
+    ihex_init(&ihex);
+    ihex_set_output_line_length(&ihex, (uint8_t) line_length);
+
+    switch (kind) {
+    case KIND_DENSE:
+    case KIND_SEGMENTED:
+        if (kind == KIND_DENSE && size > ADDRESS_SPACE) {
+            (void) fprintf(stderr, "Size does not fit in 32-bit addresses\n");
+            return EXIT_FAILURE;
+        }
+        while (written < size) {
+            const size_t n = (size - written < BLOCK_SIZE) ?
+                             (size_t) (size - written) : BLOCK_SIZE;
+            fill_random(block, n);
+            if (kind == KIND_SEGMENTED) {
+                // a segment per 64 KiB, the blocks never cross its end
+                const unsigned long address =
+                    (unsigned long) (written % SEGMENTED_SPACE);
+                ihex_write_at_segment(&ihex, (ihex_segment_t) ((address >> 4) & 0xF000U),
+                                      (ihex_address_t) (address & 0xFFFFU));
+            }
+            ihex_write_bytes(&ihex, block, (ihex_count_t) n);
+            written += n;
+        }
+        break;
+    case KIND_SEGWRAP: {
+        // Each record at segment S has 16 bytes at the offset 0xFFF0, and
+        // after the wrap, 16 bytes at offset 0, i.e., it covers the 16-byte
+        // blocks S + 0xFFF and S of the image; 0xFFF consecutive segments
+        // thus cover 2 * 0xFFF consecutive blocks once. The rest (block 0
+        // and the blocks after the last such group) are written without wrap.
+        const unsigned long group_blocks = 2UL * 0xFFFUL;
+        const unsigned long blocks = (unsigned long) (size / 16U);
+        unsigned long group, segment;
+        uint8_t *image;
+        if (size > SEGMENTED_SPACE) {
+            (void) fprintf(stderr, "Size does not fit in segmented addresses\n");
+            return EXIT_FAILURE;
+        }
+        if (!(image = malloc((size_t) size))) {
+            perror("malloc");
+            return EXIT_FAILURE;
+        }
+        for (written = 0; written < size; written += BLOCK_SIZE) {
+            fill_random(image + written, (size - written < BLOCK_SIZE) ?
+                                         (size_t) (size - written) : BLOCK_SIZE);
+        }
+        ihex_write_at_segment(&ihex, 0, 0);
+        ihex_write_bytes(&ihex, image, (ihex_count_t) ((size < 16U) ? size : 16U));
+        for (group = 1; group + group_blocks <= blocks; group += group_blocks) {
+            for (segment = group; segment < group + 0xFFFUL; ++segment) {
+                ihex_write_at_segment(&ihex, (ihex_segment_t) segment, 0xFFF0U);
+                // the 16-bit offset wraps, not the linear address
+                ihex.flags &= ~IHEX_FLAG_ADDRESS_OVERFLOW;
+                ihex_write_bytes(&ihex, image + (segment + 0xFFFUL) * 16U, 16);
+                ihex_write_bytes(&ihex, image + segment * 16U, 16);
+            }
+        }
+        for (written = group * 16U; written < size; written += 16U) {
+            ihex_write_at_segment(&ihex, (ihex_segment_t) (written >> 4), 0);
+            ihex.flags &= ~IHEX_FLAG_ADDRESS_OVERFLOW;
+            ihex_write_bytes(&ihex, image + written, (ihex_count_t)
+                             ((size - written < 16U) ? size - written : 16U));
+        }
+        written = size;
+        free(image);
+        break;
+    }
+    case KIND_SPARSE: {
+        unsigned long long stride = SPARSE_MAX_STRIDE;
+        while (stride > SPARSE_RUN &&
+               (size + SPARSE_RUN - 1U) / SPARSE_RUN * stride > ADDRESS_SPACE) {
+            stride -= SPARSE_RUN;
+        }
+        if ((size + SPARSE_RUN - 1U) / SPARSE_RUN * stride > ADDRESS_SPACE) {
+            (void) fprintf(stderr, "Size does not fit in 32-bit addresses\n");
+            return EXIT_FAILURE;
+        }
+        while (written < size) {
+            const size_t n = (size - written < SPARSE_RUN) ?
+                             (size_t) (size - written) : SPARSE_RUN;
+            fill_random(block, n);
+            ihex_write_at_address(&ihex, (ihex_address_t)
+                                  (written / SPARSE_RUN * stride));
+            ihex_write_bytes(&ihex, block, (ihex_count_t) n);
+            written += n;
+        }
+        break;
+    }
+    case KIND_SHUFFLED: {
+        // visit the blocks in the order (i * step) mod count
+        const unsigned long long count = (size + BLOCK_SIZE - 1U) / BLOCK_SIZE;
+        unsigned long long step = (count * 5U) / 8U + 1U;
+        unsigned long long i;
+        if (size > ADDRESS_SPACE) {
+            (void) fprintf(stderr, "Size does not fit in 32-bit addresses\n");
+            return EXIT_FAILURE;
+        }
+        while (gcd(step, count) != 1U) {
+            ++step;
+        }
+        for (i = 0; i < count; ++i) {
+            const unsigned long long index = (i * step) % count;
+            const unsigned long long address = index * BLOCK_SIZE;
+            const size_t n = (size - address < BLOCK_SIZE) ?
+                             (size_t) (size - address) : BLOCK_SIZE;
+            fill_random(block, n);
+            ihex_write_at_address(&ihex, (ihex_address_t) address);
+            ihex_write_bytes(&ihex, block, (ihex_count_t) n);
+            written += n;
+        }
+        break;
+    }
+    }
+    ihex_end_write(&ihex);
+
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("ihexgen");
+        return EXIT_FAILURE;
+    }
+    (void) fprintf(stderr, "%llu records, %llu bytes\n", records, written);
+    return EXIT_SUCCESS;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+void
+ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    ++records;
+    if (noise) {
+        // whitespace before the record, after the length, and at the end
+        static const char * const before[] = { "", " ", "\t", "  " };
+        // separate from the data, so the noise does not change it
+        const unsigned r = (unsigned) ((noise_state = noise_state * 1103515245UL + 12345UL) >> 16);
+        char *end = eptr;
+        while (end > buffer && (end[-1] == '\n' || end[-1] == '\r')) {
+            --end;
+        }
+        (void) fputs(before[r & 3U], outfile);
+        (void) fwrite(buffer, 3, 1, outfile);
+        if (r & 4U) {
+            (void) fputc(' ', outfile);
+        }
+        (void) fwrite(buffer + 3, (size_t) (end - buffer) - 3U, 1, outfile);
+        (void) fputs((r & 8U) ? " \t" : "", outfile);
+        (void) fputs(crlf ? "\r\n" : "\n", outfile);
+        return;
+    }
+    if (crlf) {
+        (void) fwrite(buffer, (size_t) (eptr - buffer) - 1U, 1, outfile);
+        (void) fputs("\r\n", outfile);
+        return;
+    }
+    (void) fwrite(buffer, (size_t) (eptr - buffer), 1, outfile);
+}
@@ -0,0 +1,571 @@
+/*
+ * ihexmicro.c: Microbenchmarks of the hot functions of the IHEX library.
+ *
+ * Usage: ihexmicro [-n <runs>] [-w <warmup>] [-s <size>] [-b <length>]
+ *                  [-c perf|tsc|clock] [-j]
+ *
+ * Each kernel is run over in-memory buffers, i.e., without any I/O:
+ *
+ *      read_byte       `ihex_read_byte` for each character of IHEX text
+ *      read_bytes      `ihex_read_bytes` on the whole IHEX text
+ *      end_read        `ihex_end_read` (checksum) of complete records
+ *      buffer_byte     `hex_buffer_byte` for each byte of data
+ *      write_data      `ihex_write_data` (one record) of full records
+ *      write_bytes     `ihex_write_bytes` on the whole data
+ *
+ * The data is `-s` bytes (suffixes K and M are accepted, default 16K) of
+ * pseudorandom data, in records of `-b` bytes (default 32). Every kernel
+ * is first run `-w` times (default 10) to warm up the caches and branch
+ * predictors, and then timed `-n` times (default 101). The minimum,
+ * median, and 90th and 99th percentile of the time per unit (character,
+ * byte, or record) are reported, as a table or with `-j` as one line of
+ * JSON per kernel.
+ *
+ * Time is measured in CPU cycles with `perf_event_open` (Linux), or in
+ * time stamp counter ticks with `rdtsc` (x86), or in nanoseconds with the
+ * monotonic clock, whichever is available first; `-c` selects one.
+ *
+ * The library is linked from `microlib.c`, compiled with the same options
+ * as this program. `make microbench` builds and runs a program for each
+ * build configuration (see `MICRO_CONFIGS` in the Makefile), the name of
+ * which is defined as `IHEX_MICRO_CONFIG`.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#if !defined(_GNU_SOURCE) && defined(__linux__)
+#define _GNU_SOURCE
+#endif
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "../kk_ihex_read.h"
+#include "../kk_ihex_write.h"
+#include "../kk_hex_codec.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__GNUC__) && defined(__has_include)
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#define MICRO_PERF
+#endif
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MICRO_TSC
+#endif
+
+#ifndef IHEX_MICRO_CONFIG
+#define IHEX_MICRO_CONFIG "default"
+#endif
+
+#define MAX_RUNS 10001
+#define MAX_SIZE (64UL * 1024UL * 1024UL)
+
+// exported from `microlib.c`
+void micro_write_data(struct ihex_state *ihex);
+
+enum counter {
+    COUNTER_PERF,
+    COUNTER_TSC,
+    COUNTER_CLOCK
+};
+
+static const char * const counter_names[] = { "perf", "tsc", "clock", NULL };
+static const char * const counter_units[] = { "cycles", "ticks", "ns" };
+
+static enum counter counter = COUNTER_CLOCK;
+static int perf_fd = -1;
+
+static uint8_t *data;
+static unsigned long size = 16UL * 1024UL;
+static unsigned long line_length = IHEX_DEFAULT_OUTPUT_LINE_LENGTH;
+static char *text;
+static unsigned long text_length = 0;
+static char *hex_output;
+static struct ihex_state *records;
+static unsigned long record_count;
+static struct ihex_state reader;
+static struct ihex_state writer;
+
+// set by the callbacks
+static char *capture = NULL;
+static unsigned long long flushed_bytes = 0;
+static unsigned long long records_read = 0;
+static unsigned long long checksum_errors = 0;
+
+// Returns true if `counter` can be used (opening it if necessary)
+static bool
+open_counter (const enum counter c) {
+    switch (c) {
+#ifdef MICRO_PERF
+    case COUNTER_PERF: {
+        struct perf_event_attr attr;
+        (void) memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        perf_fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return perf_fd >= 0;
+    }
+#endif
+#ifdef MICRO_TSC
+    case COUNTER_TSC:
+        return true;
+#endif
+    case COUNTER_CLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint64_t
+read_counter (void) {
+    switch (counter) {
+#ifdef MICRO_PERF
+    case COUNTER_PERF: {
+        uint64_t value;
+        if (read(perf_fd, &value, sizeof(value)) != (ssize_t) sizeof(value)) {
+            value = 0;
+        }
+        return value;
+    }
+#endif
+#ifdef MICRO_TSC
+    case COUNTER_TSC: {
+        uint32_t low, high;
+        // the lfence keeps rdtsc from being executed ahead of the kernel
+        __asm__ __volatile__ ("lfence\n\trdtsc" : "=a" (low), "=d" (high) :: "memory");
+        return ((uint64_t) high << 32) | low;
+    }
+#endif
+    default: {
+        struct timespec now;
+        (void) clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t) now.tv_sec * 1000000000U + (uint64_t) now.tv_nsec;
+    }
+    }
+}
+
+// The kernels
+
+static void
+prepare_reader (void) {
+    ihex_begin_read(&reader);
+}
+
+static void
+run_read_byte (void) {
+    const char *r = text;
+    const char * const end = text + text_length;
+    while (r != end) {
+        ihex_read_byte(&reader, *r++);
+    }
+}
+
+static void
+run_read_bytes (void) {
+    ihex_read_bytes(&reader, text, (ihex_count_t) text_length);
+}
+
+// Reset each of `records` to hold a complete data record
+static void
+prepare_records (void) {
+    unsigned long i;
+    for (i = 0; i < record_count; ++i) {
+        struct ihex_state * const record = &records[i];
+        record->address = (ihex_address_t) (i * line_length);
+        record->length = record->line_length;
+        record->flags = 0;
+    }
+}
+
+static void
+run_end_read (void) {
+    struct ihex_state *record = records;
+    struct ihex_state * const end = records + record_count;
+    while (record != end) {
+        ihex_end_read(record++);
+    }
+}
+
+static void
+run_buffer_byte (void) {
+    const uint8_t *r = data;
+    const uint8_t * const end = data + size;
+    char *w = hex_output;
+    while (r != end) {
+        w = hex_buffer_byte(w, *r++);
+    }
+}
+
+static void
+run_write_data (void) {
+    struct ihex_state *record = records;
+    struct ihex_state * const end = records + record_count;
+    while (record != end) {
+        micro_write_data(record++);
+    }
+}
+
+static void
+prepare_writer (void) {
+    ihex_init(&writer);
+    ihex_set_output_line_length(&writer, (uint8_t) line_length);
+}
+
+static void
+run_write_bytes (void) {
+    ihex_write_bytes(&writer, data, (ihex_count_t) size);
+}
+
+struct kernel {
+    const char      *name;
+    const char      *unit;
+    void            (*prepare)(void);
+    void            (*run)(void);
+};
+
+static const struct kernel kernels[] = {
+    { "read_byte",      "char",     prepare_reader,     run_read_byte },
+    { "read_bytes",     "char",     prepare_reader,     run_read_bytes },
+    { "end_read",       "record",   prepare_records,    run_end_read },
+    { "buffer_byte",    "byte",     NULL,               run_buffer_byte },
+    { "write_data",     "record",   prepare_records,    run_write_data },
+    { "write_bytes",    "byte",     prepare_writer,     run_write_bytes },
+    { NULL, NULL, NULL, NULL }
+};
+
+static double
+units_of (const struct kernel * const kernel) {
+    switch (kernel->unit[0]) {
+    case 'c':
+        return (double) text_length;
+    case 'r':
+        return (double) record_count;
+    default:
+        return (double) size;
+    }
+}
+
+static int
+compare_doubles (const void *a, const void *b) {
+    const double da = *(const double *) a;
+    const double db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+// The nearest-rank percentile `p` of the `n` sorted `samples`
+static double
+percentile (const double * const samples, const unsigned long n, const unsigned p) {
+    unsigned long rank = (n * p + 99UL) / 100UL;
+    return samples[rank ? rank - 1UL : 0];
+}
+
+// The smallest cost of reading the counter, subtracted from each sample
+static uint64_t
+counter_overhead (void) {
+    uint64_t overhead = UINT64_MAX;
+    unsigned i;
+    for (i = 0; i < 100U; ++i) {
+        const uint64_t start = read_counter();
+        const uint64_t end = read_counter();
+        if (end - start < overhead) {
+            overhead = end - start;
+        }
+    }
+    return overhead;
+}
+
+// Generate the data, its IHEX text, and the complete records
+static bool
+setup (void) {
+    uint_least64_t state = 0x9E3779B97F4A7C15ULL;
+    const unsigned long line_count = size / line_length + 1UL;
+    unsigned long i;
+
+    record_count = (size + line_length - 1UL) / line_length;
+    data = malloc(size);
+    hex_output = malloc(size * 2UL);
+    // each line, plus an extended address record per 64 KiB and the end
+    text = malloc((line_count + size / 0x10000UL + 2UL) * IHEX_WRITE_BUFFER_LENGTH);
+    records = malloc(record_count * sizeof(*records));
+    if (!data || !hex_output || !text || !records) {
+        return false;
+    }
+
+    for (i = 0; i < size; ++i) {
+        // xorshift64*
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        state &= 0xFFFFFFFFFFFFFFFFULL;
+        data[i] = (uint8_t) ((state * 0x2545F4914F6CDD1DULL) >> 56);
+    }
+
+    capture = text;
+    prepare_writer();
+    ihex_write_bytes(&writer, data, (ihex_count_t) size);
+    ihex_end_write(&writer);
+    text_length = (unsigned long) (capture - text);
+    capture = NULL;
+
+    for (i = 0; i < record_count; ++i) {
+        struct ihex_state * const record = &records[i];
+        const unsigned long offset = i * line_length;
+        const unsigned long length = (size - offset < line_length) ?
+                                     size - offset : line_length;
+        const ihex_address_t address = (ihex_address_t) offset;
+        uint8_t sum = (uint8_t) (length + (address & 0xFFU) + ((address >> 8) & 0xFFU));
+        unsigned long j;
+
+        ihex_init(record);
+        record->line_length = (uint8_t) length;
+        for (j = 0; j < length; ++j) {
+            sum = (uint8_t) (sum + (record->data[j] = data[offset + j]));
+        }
+        record->data[length] = (uint8_t) (~sum + 1U);
+    }
+    return true;
+}
+
+// Parse a size with an optional K or M suffix
+static bool
+parse_size (const char *s, unsigned long *value) {
+    char *end;
+    errno = 0;
+    *value = strtoul(s, &end, 0);
+    if (errno || end == s) {
+        return false;
+    }
+    switch (*end) {
+    case 'M': case 'm':
+        *value <<= 10;
+        // fallthrough
+    case 'K': case 'k':
+        *value <<= 10;
+        ++end;
+        break;
+    default:
+        break;
+    }
+    return *end == '\0';
+}
+
+int
+main (int argc, char *argv[]) {
+    static double samples[MAX_RUNS];
+    const struct kernel *kernel;
+    unsigned long runs = 101;
+    unsigned long warmup = 10;
+    bool json = false;
+    bool counter_given = false;
+    uint64_t overhead;
+    char *arg = NULL;
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'n':
+            case 'w': {
+                const char option = arg[1];
+                unsigned long value;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                value = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || value > MAX_RUNS ||
+                    (option == 'n' && !value)) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                *((option == 'n') ? &runs : &warmup) = value;
+                break;
+            }
+            case 's':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                arg = *(++argv);
+                if (!parse_size(arg, &size) || !size || size > MAX_SIZE) {
+                    goto invalid_argument;
+                }
+                break;
+            case 'b':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                line_length = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !line_length ||
+                    line_length > IHEX_MAX_OUTPUT_LINE_LENGTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'c': {
+                unsigned i;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                arg = *(++argv);
+                for (i = 0; counter_names[i] && strcmp(arg, counter_names[i]); ++i) { }
+                if (!counter_names[i]) {
+                    goto invalid_argument;
+                }
+                counter = (enum counter) i;
+                counter_given = true;
+                break;
+            }
+            case 'j':
+                json = true;
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "Usage: ihexmicro [-n <runs>] [-w <warmup>] [-s <size>]"
+                               " [-b <length>]\n"
+                               "                 [-c perf|tsc|clock] [-j]\n");
+        return arg ? EXIT_FAILURE : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_FAILURE;
+    }
+
+    if (counter_given) {
+        if (!open_counter(counter)) {
+            (void) fprintf(stderr, "Counter not available: %s\n",
+                           counter_names[counter]);
+            return EXIT_FAILURE;
+        }
+    } else {
+        counter = COUNTER_PERF;
+        while (!open_counter(counter)) {
+            counter = (enum counter) (counter + 1);
+        }
+    }
+    if (!setup()) {
+        perror("ihexmicro");
+        return EXIT_FAILURE;
+    }
+    overhead = counter_overhead();
+
+    if (!json) {
+        (void) printf("%s: IHEX_LINE_MAX_LENGTH %u, segments %s, %s, "
+                      "state %lu bytes, %lu runs\n",
+                      IHEX_MICRO_CONFIG, (unsigned) IHEX_LINE_MAX_LENGTH,
+#ifdef IHEX_DISABLE_SEGMENTS
+                      "disabled",
+#else
+                      "enabled",
+#endif
+#if defined(__OPTIMIZE_SIZE__)
+                      "optimized for size",
+#elif defined(__OPTIMIZE__)
+                      "optimized for speed",
+#else
+                      "not optimized",
+#endif
+                      (unsigned long) sizeof(struct ihex_state), runs);
+        (void) printf("%-12s %8s %10s %10s %10s %10s\n", "kernel",
+                      counter_units[counter], "min", "median", "p90", "p99");
+    }
+
+    for (kernel = kernels; kernel->name; ++kernel) {
+        const double units = units_of(kernel);
+        unsigned long i;
+
+        for (i = 0; i < warmup + runs; ++i) {
+            uint64_t start, elapsed;
+            if (kernel->prepare) {
+                kernel->prepare();
+            }
+            start = read_counter();
+            kernel->run();
+            elapsed = read_counter() - start;
+            if (i >= warmup) {
+                elapsed = (elapsed > overhead) ? elapsed - overhead : 0;
+                samples[i - warmup] = (double) elapsed / units;
+            }
+        }
+        qsort(samples, runs, sizeof(samples[0]), compare_doubles);
+
+        if (json) {
+            (void) printf("{\"name\":\"%s/%s\",\"config\":\"%s\",\"kernel\":\"%s\","
+                          "\"unit\":\"%s\",\"counter\":\"%s\",\"runs\":%lu,"
+                          "\"min\":%.3f,\"median\":%.3f,\"p90\":%.3f,\"p99\":%.3f,"
+                          "\"line_max_length\":%u,\"state_bytes\":%lu}\n",
+                          IHEX_MICRO_CONFIG, kernel->name, IHEX_MICRO_CONFIG,
+                          kernel->name, kernel->unit, counter_units[counter], runs,
+                          samples[0], percentile(samples, runs, 50),
+                          percentile(samples, runs, 90), percentile(samples, runs, 99),
+                          (unsigned) IHEX_LINE_MAX_LENGTH,
+                          (unsigned long) sizeof(struct ihex_state));
+        } else {
+            (void) printf("%-12s %8s %10.2f %10.2f %10.2f %10.2f\n",
+                          kernel->name, kernel->unit, samples[0],
+                          percentile(samples, runs, 50),
+                          percentile(samples, runs, 90),
+                          percentile(samples, runs, 99));
+        }
+    }
+
+    // check that the kernels actually did the work
+    if (checksum_errors || records_read != (warmup + runs) * 3UL * record_count ||
+        !flushed_bytes) {
+        (void) fprintf(stderr, "ihexmicro: %llu records read, %llu checksum errors\n",
+                       records_read, checksum_errors);
+        return EXIT_FAILURE;
+    }
+    return fflush(stdout) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+ihex_bool_t
+ihex_data_read (struct ihex_state *ihex,
+                ihex_record_type_t type,
+                ihex_bool_t checksum_error) {
+    if (type == IHEX_DATA_RECORD) {
+        ++records_read;
+        checksum_errors += (checksum_error != 0);
+    }
+    return true;
+}
+
+void
+ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    const size_t length = (size_t) (eptr - buffer);
+    if (capture) {
+        (void) memcpy(capture, buffer, length);
+        capture += length;
+    } else {
+        flushed_bytes += length;
+    }
+}
@@ -0,0 +1,22 @@
+/*
+ * microlib.c: The IHEX reader and writer compiled as one object for the
+ * microbenchmark `ihexmicro`, once per build configuration, so that the
+ * size of the object can be compared between the configurations.
+ *
+ * The internal `ihex_write_data` is exported as `micro_write_data`, so
+ * it can be timed on its own.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#include "../kk_ihex_read.c"
+#include "../kk_ihex_write.c"
+
+void micro_write_data(struct ihex_state *ihex);
+
+void
+micro_write_data (struct ihex_state * const ihex) {
+    ihex_write_data(ihex);
+}
@@ -0,0 +1,124 @@
+#!/bin/sh
+#
+# probes.sh: Trace the USDT probes of the IHEX library with bpftrace,
+# showing the throughput once per second, and histograms of the latency
+# of each record at the end.
+#
+# Usage: bench/probes.sh <program> [<arguments> ...]
+#        bench/probes.sh -p <pid> <program>
+#
+# The first form runs the program (e.g., ihex2bin) with the arguments and
+# traces it until it exits, the second attaches to the running process
+# `pid` of the program until interrupted with ^C. The program must have
+# been built with the probes (`make PROBEFLAGS=-DIHEX_ENABLE_PROBES`, see
+# `kk_ihex_probe.h`), and bpftrace usually needs to be run as root.
+#
+# Every second, the number of records and data bytes read, and the number
+# of records and bytes written, are printed. At the end, the histograms
+# show the time in nanoseconds from the start code of each record to its
+# end (reading), of writing each data record, and of each call of
+# `ihex_flush_buffer` (i.e., the output), along with the counts of records
+# read by type, checksum errors, and extended address changes.
+#
+
+pid=
+if [ "$1" = "-p" ] && [ $# -eq 3 ]; then
+    pid="$2"
+    shift 2
+fi
+if [ $# -eq 0 ] || [ "$1" = "-p" ]; then
+    echo "Usage: $0 <program> [<arguments> ...]" >&2
+    echo "       $0 -p <pid> <program>" >&2
+    exit 1
+fi
+
+# the probes are found by the path of the program
+program=$(command -v "$1") || {
+    echo "$1: not found" >&2
+    exit 1
+}
+case "$program" in
+    /*) ;;
+    *) program="$PWD/$program" ;;
+esac
+
+script=$(cat <<EOF
+BEGIN
+{
+    @read_records_s = 0; @read_bytes_s = 0;
+    @written_records_s = 0; @written_bytes_s = 0;
+}
+
+usdt:$program:kk_ihex:record_start
+{
+    @record_start[arg0] = nsecs;
+}
+
+usdt:$program:kk_ihex:end_read
+/@record_start[arg0]/
+{
+    @read_ns = hist(nsecs - @record_start[arg0]);
+    delete(@record_start[arg0]);
+}
+
+usdt:$program:kk_ihex:end_read
+{
+    @records_read_by_type[arg1] = count();
+    @checksum_errors = sum(arg4);
+    @read_records_s += 1;
+    @read_bytes_s += (arg1 == 0) ? arg3 : 0;
+}
+
+usdt:$program:kk_ihex:address_change
+{
+    @address_changes = count();
+}
+
+usdt:$program:kk_ihex:write_data_start
+{
+    @write_start[arg0] = nsecs;
+    @written_bytes_s += arg2;
+}
+
+usdt:$program:kk_ihex:write_data_end
+/@write_start[arg0]/
+{
+    @write_data_ns = hist(nsecs - @write_start[arg0]);
+    delete(@write_start[arg0]);
+}
+
+usdt:$program:kk_ihex:flush_start
+{
+    @flush_start[arg0] = nsecs;
+    @written_records_s += 1;
+}
+
+usdt:$program:kk_ihex:flush_end
+/@flush_start[arg0]/
+{
+    @flush_ns = hist(nsecs - @flush_start[arg0]);
+    delete(@flush_start[arg0]);
+}
+
+interval:s:1
+{
+    printf("read: %d records/s, %d data bytes/s; written: %d records/s, %d data bytes/s\n",
+           @read_records_s, @read_bytes_s, @written_records_s, @written_bytes_s);
+    @read_records_s = 0; @read_bytes_s = 0;
+    @written_records_s = 0; @written_bytes_s = 0;
+}
+
+END
+{
+    clear(@record_start); clear(@write_start); clear(@flush_start);
+    clear(@read_records_s); clear(@read_bytes_s);
+    clear(@written_records_s); clear(@written_bytes_s);
+}
+EOF
+)
+
+if [ -n "$pid" ]; then
+    exec bpftrace -p "$pid" -e "$script"
+fi
+shift
+exec bpftrace -e "$script" -c "$program $*"
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# uring.sh: Compare the standard I/O, `--pipeline`, and `--uring` paths of
+# bin2ihex and ihex2bin on a large file.
+#
+# Usage: bench/uring.sh [size_in_MiB] [runs]
+#
+# Run from the directory containing the built programs. The test files
+# are created in $TMPDIR (default /tmp), which should be on the storage
+# to be measured. The best time of the given number of runs is reported
+# for each tool and mode, along with the throughput in MB/s of binary data.
+#
+
+SIZE_MIB="${1:-256}"
+RUNS="${2:-3}"
+DIR="${TMPDIR:-/tmp}/kk_ihex_bench.$$"
+BIN="$DIR/input.bin"
+HEX="$DIR/input.hex"
+BYTES=$((SIZE_MIB * 1048576))
+
+mkdir -p "$DIR" || exit 1
+trap 'rm -rf "$DIR"' EXIT INT TERM
+
+head -c "$BYTES" /dev/urandom >"$BIN" || exit 1
+./bin2ihex -i "$BIN" -o "$HEX" || exit 1
+
+now() {
+    date +%s%N
+}
+
+# bench <name> <mode> <program> <args...>
+bench() {
+    name="$1"
+    mode="$2"
+    shift 2
+    best=0
+    run=0
+    while [ "$run" -lt "$RUNS" ]; do
+        start=$(now)
+        "$@" || exit 1
+        elapsed=$(( $(now) - start ))
+        if [ "$best" -eq 0 ] || [ "$elapsed" -lt "$best" ]; then
+            best="$elapsed"
+        fi
+        run=$((run + 1))
+    done
+    printf '%-10s %-12s %8d ms %8d MB/s\n' "$name" "$mode" \
+           $((best / 1000000)) $((BYTES * 1000 / (best > 0 ? best : 1)))
+}
+
+for mode in stdio --pipeline --uring; do
+    opt="$mode"
+    [ "$mode" = stdio ] && opt=""
+    bench bin2ihex "$mode" ./bin2ihex $opt -i "$BIN" -o "$DIR/out.hex"
+    cmp -s "$HEX" "$DIR/out.hex" || { echo "bin2ihex $mode: output differs"; exit 1; }
+    bench ihex2bin "$mode" ./ihex2bin $opt -i "$HEX" -o "$DIR/out.bin"
+    cmp -s "$BIN" "$DIR/out.bin" || { echo "ihex2bin $mode: output differs"; exit 1; }
+done
@@ -9,15 +9,67 @@
  * into a single line of output (which will be more than twice
  * that length in bytes) can be given with the argument `-b`.
  *
+ * The command-line option `-m` writes a manifest of per-block CRC-32
+ * hashes of the data (see `kk_manifest.h`) to the given file. The block
+ * size (default 4096) and the fill byte for the parts of blocks not
+ * covered by the input (default 0xFF) can be set with options `-s` and
+ * `-f`, respectively.
+ *
+ * The command-line options `--swap16` and `--swap32` swap the order of
+ * bytes in each 16- or 32-bit word, and `--swapwords` swaps the 16-bit
+ * halves of each 32-bit word (see `kk_swap.h`). The words are aligned by
+ * the output addresses, and any bytes of a partial word at the end of
+ * input are left unswapped.
+ *
+ * Input compressed with gzip, zstd, or xz is recognised and decompressed
+ * automatically, and the option `-z` compresses the output in the given
+ * format (see `kk_zpipe.h`). The codec runs in a thread of its own, and
+ * passes the data to or from the conversion through a ring buffer as with
+ * `--pipeline`.
+ *
+ * The command-line option `--pipeline` reads the input and writes the
+ * output in threads of their own, passing large blocks of data to and
+ * from the conversion through ring buffers (see `kk_ring.h`), so that
+ * the I/O and the conversion run concurrently.
+ *
+ * The command-line option `--uring` reads the input and writes the output
+ * with asynchronous I/O through io_uring on Linux (see `kk_aio.h`), with
+ * several large reads in flight ahead of the conversion. It only applies
+ * to uncompressed regular files; other input and output falls back to
+ * `--pipeline` (if given) or to standard I/O.
+ *
+ * The command-line option `--batch` converts many files in one process,
+ * given as pairs of input and output file names, either as arguments or
+ * listed in a file with the option `-l` (see `kk_batch.h`). The files are
+ * converted concurrently on a pool of threads, the number of which can be
+ * set with the option `-j` (default is the number of processors). A
+ * failure to convert one file does not stop the others, and the status
+ * of each file is reported along with the totals. The options `-a` and
+ * `-b` apply to every file.
+ *
+ * The command-line option `--stats` prints statistics of the conversion
+ * (records by type, data bytes, errors, skipped junk, address changes,
+ * and callback and flush calls) on standard error at the end, or
+ * `--stats=json` as one line of JSON. It requires the library to be built
+ * with `IHEX_ENABLE_STATS` (see `kk_ihex.h` and `kk_ihex_stats.h`).
+ *
  * Copyright (c) 2013-2019 Kimmo Kulovesi, https://arkku.com
  * Provided with absolutely no warranty, use at your own risk only.
  * Distribute freely, mark modified copies as such.
  */
 
 #include "kk_ihex_write.h"
+#include "kk_ihex_stats.h"
+#include "kk_aio.h"
+#include "kk_batch.h"
+#include "kk_manifest.h"
+#include "kk_swap.h"
+#include "kk_ring.h"
+#include "kk_zpipe.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 #ifdef IHEX_EXTERNAL_WRITE_BUFFER
@@ -27,19 +79,170 @@ char *ihex_write_buffer = NULL;
 //#define IHEX_WRITE_INITIAL_EXTENDED_ADDRESS_RECORD
 
 static FILE *outfile;
+static struct ihex_state output;
+static ihex_address_t initial_address = 0;
+static uint8_t line_length = IHEX_DEFAULT_OUTPUT_LINE_LENGTH;
+static bool write_initial_address = 0;
+static FILE *manifest_file = NULL;
+static struct manifest manifest;
+static struct swap_stage swap;
+static bool pipeline = false;
+static bool ring_output = false;
+static struct ring output_ring;
+static struct zpipe output_zpipe;
+static enum zpipe_format compression = ZPIPE_NONE;
+static struct ring_block *output_block = NULL;
+static bool uring = false;
+static struct aio output_aio;
+static unsigned long long output_offset = 0;
+static uint8_t *aio_block = NULL;
+static size_t aio_block_length = 0;
+static bool batch_mode = false;
+static bool print_stats = false;
+static bool stats_json = false;
+
+// The state of one conversion in batch mode
+struct conversion {
+    struct ihex_state   ihex;   // first, so that `ihex_flush_buffer` finds the rest
+    struct batch_job    *job;
+    FILE                *file;
+};
+
+// Pass the current block of output to io_uring to be written.
+//
+static void
+submit_aio_block (void) {
+    aio_write_submit(&output_aio, output_offset, aio_block_length);
+    output_offset += aio_block_length;
+    aio_block = NULL;
+}
+
+// Set up io_uring for `infile` (into `input_aio`, unless `infile` is
+// NULL) and the uncompressed output file, returns whether the input uses
+// it. The output uses it if `uring` is still set afterwards.
+//
+static bool
+begin_uring (FILE *infile, struct aio *input_aio, const bool debug_enabled) {
+    unsigned long long input_offset;
+    bool uring_input = false;
+    int fd;
+
+    if (infile && (fd = aio_file(infile, false, &input_offset)) >= 0 &&
+        aio_init(input_aio, fd, AIO_DEFAULT_DEPTH)) {
+        uring_input = true;
+        aio_begin_read(input_aio, input_offset);
+    }
+    uring = (compression == ZPIPE_NONE &&
+             (fd = aio_file(outfile, true, &output_offset)) >= 0 &&
+             aio_init(&output_aio, fd, AIO_DEFAULT_DEPTH));
+    if (debug_enabled && !(uring_input && uring)) {
+        (void) fprintf(stderr, "io_uring not used for%s%s\n",
+                       uring_input ? "" : " input",
+                       uring ? "" : (uring_input ? " output" : " or output"));
+    }
+    return uring_input;
+}
+
+// Convert the binary file `job->input` to IHEX `job->output`.
+//
+void
+batch_job_run (struct batch *batch, struct batch_job *job, unsigned worker) {
+    struct conversion conversion;
+    uint8_t buf[16384];
+    size_t count;
+    FILE *infile;
+
+    (void) batch;
+    (void) worker;
+    if (!(infile = fopen(job->input, "rb"))) {
+        batch_fail(job, "%s: %s", job->input, strerror(errno));
+        return;
+    }
+    if (!(conversion.file = fopen(job->output, "w"))) {
+        batch_fail(job, "%s: %s", job->output, strerror(errno));
+        (void) fclose(infile);
+        return;
+    }
+    conversion.job = job;
+    ihex_init(&conversion.ihex);
+    ihex_set_output_line_length(&conversion.ihex, line_length);
+    ihex_write_at_address(&conversion.ihex, initial_address);
+    if (write_initial_address) {
+        conversion.ihex.flags |= IHEX_FLAG_ADDRESS_OVERFLOW;
+    }
+    while (!job->failed && (count = fread(buf, 1, sizeof(buf), infile))) {
+        (void) ihex_write_block(&conversion.ihex, buf, count);
+        job->bytes_read += count;
+    }
+    if (ferror(infile)) {
+        batch_fail(job, "%s: %s", job->input, strerror(errno));
+    }
+    ihex_end_write(&conversion.ihex);
+    (void) fclose(infile);
+    if (fclose(conversion.file)) {
+        batch_fail(job, "%s: %s", job->output, strerror(errno));
+    }
+    if (job->failed) {
+        (void) remove(job->output);
+    }
+}
+
+// Run the conversions of `batch` on `workers` threads and report them.
+//
+static int
+run_batch (struct batch *batch, const unsigned workers, const bool debug_enabled) {
+    unsigned threads = workers;
+    int status;
+
+#ifndef IHEX_REENTRANT_WRITE
+    // the writer shares a static buffer, so only one thread can use it
+    if (threads != 1U) {
+        if (debug_enabled) {
+            (void) fprintf(stderr, "Library not reentrant, using one thread\n");
+        }
+        threads = 1U;
+    }
+#else
+    (void) debug_enabled;
+#endif
+    if (!batch_run(batch, threads)) {
+        perror("batch");
+        batch_free(batch);
+        return EXIT_FAILURE;
+    }
+    batch_report(batch, stdout);
+    status = batch->failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    batch_free(batch);
+    if (fflush(stdout)) {
+        perror("batch");
+        return EXIT_FAILURE;
+    }
+    return status;
+}
 
 int
 main (int argc, char *argv[]) {
-    struct ihex_state ihex;
     FILE *infile = stdin;
-    ihex_address_t initial_address = 0;
-    uint8_t line_length = IHEX_DEFAULT_OUTPUT_LINE_LENGTH;
-    bool write_initial_address = 0;
+    struct ring input_ring;
+    struct aio input_aio;
+    bool uring_input = false;
+    bool ring_input = false;
+    struct zpipe input_zpipe;
+    int zpipe_input;
+    struct batch batch;
+    const char *batch_input = NULL;
+    unsigned long workers = 0;
     bool debug_enabled = 0;
     ihex_count_t count;
+    unsigned long block_size = MANIFEST_DEFAULT_BLOCK_SIZE;
+    unsigned long fill = MANIFEST_DEFAULT_FILL;
+    unsigned long input_address;
+    unsigned long long bytes_read = 0;
+    enum swap_mode swap_mode;
     uint8_t buf[1024];
 
     outfile = stdout;
+    batch_init(&batch);
 
     // spaghetti parser of args: -o outfile -i infile -a initial_address
     while (--argc) {
@@ -89,6 +292,81 @@ main (int argc, char *argv[]) {
                     goto argument_error;
                 }
                 break;
+            case 'm':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(manifest_file = fopen(*argv, "w"))) {
+                    goto argument_error;
+                }
+                break;
+            case 's':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                block_size = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !block_size) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'f':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                fill = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || fill > 0xFFU) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'z':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                arg = *(++argv);
+                if ((compression = zpipe_format_option(arg)) == ZPIPE_NONE) {
+                    goto invalid_argument;
+                }
+                if (!zpipe_format_supported(compression)) {
+                    (void) fprintf(stderr, "-z %s is not supported by this build\n", arg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'j':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                workers = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || workers > BATCH_MAX_WORKERS) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'l': {
+                FILE *list;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(list = strcmp(*argv, "-") ? fopen(*argv, "r") : stdin)) {
+                    goto argument_error;
+                }
+                if (!batch_read_list(&batch, list)) {
+                    goto argument_error;
+                }
+                if (list != stdin) {
+                    (void) fclose(list);
+                }
+                break;
+            }
             case 'v':
                 debug_enabled = 1;
                 break;
@@ -100,6 +378,32 @@ main (int argc, char *argv[]) {
                 goto invalid_argument;
             }
             continue;
+        } else if (!strcmp(arg, "--pipeline")) {
+            pipeline = true;
+            continue;
+        } else if (!strcmp(arg, "--uring")) {
+            uring = true;
+            continue;
+        } else if (!strcmp(arg, "--batch")) {
+            batch_mode = true;
+            continue;
+        } else if (!strcmp(arg, "--stats") || !strcmp(arg, "--stats=json")) {
+            print_stats = true;
+            stats_json = (arg[7] == '=');
+            continue;
+        } else if (arg[0] != '-') {
+            // a pair of input and output file names for batch mode
+            if (!batch_input) {
+                batch_input = arg;
+            } else if (batch_add(&batch, batch_input, arg)) {
+                batch_input = NULL;
+            } else {
+                goto argument_error;
+            }
+            continue;
+        } else if ((swap_mode = swap_option(arg)) != SWAP_NONE) {
+            swap_stage_init(&swap, swap_mode);
+            continue;
         }
 invalid_argument:
         (void) fprintf(stderr, "Invalid argument: %s\n", arg);
@@ -107,48 +411,181 @@ usage:
         (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
                                " - Copyright (c) 2013-2019 Kimmo Kulovesi\n");
         (void) fprintf(stderr, "Usage: bin2ihex [-a <address_offset>]"
-                               " [-o <out.hex>] [-i <in.bin>] [-b <length>] [-v]\n");
+                               " [-o <out.hex>] [-i <in.bin>] [-b <length>] [-v]\n"
+                               "                [-z <gzip|zstd|xz>] [--pipeline] [--uring]\n"
+                               "                [-m <manifest>"
+                               " [-s <block_size>] [-f <fill>]]\n"
+                               "                [--swap16|--swap32|--swapwords] [--stats[=json]]\n"
+                               "       bin2ihex --batch [-j <threads>] [-l <list>]"
+                               " [-a <address_offset>] [-b <length>]\n"
+                               "                [<in.bin> <out.hex> ...]\n");
         return arg ? EXIT_FAILURE : EXIT_SUCCESS;
 argument_error:
         perror(*argv);
         return EXIT_FAILURE;
     }
 
+    if (batch_mode || batch.count || batch_input) {
+        if (!batch_mode || batch_input) {
+            (void) fprintf(stderr, "%s\n", batch_mode ?
+                           "Missing output file name" :
+                           "File name arguments require --batch");
+            return EXIT_FAILURE;
+        }
+        if (infile != stdin || outfile != stdout || manifest_file ||
+            compression != ZPIPE_NONE || swap.mode != SWAP_NONE ||
+            pipeline || uring || print_stats) {
+            (void) fprintf(stderr, "Only -a, -b, -j, -l and -v"
+                                   " can be used with --batch\n");
+            return EXIT_FAILURE;
+        }
+        return run_batch(&batch, (unsigned) workers, debug_enabled);
+    }
+
+#ifndef IHEX_ENABLE_STATS
+    if (print_stats) {
+        (void) fprintf(stderr, "--stats requires building with IHEX_ENABLE_STATS\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    if (manifest_file && !manifest_init(&manifest, manifest_file,
+                                        block_size, (uint8_t) fill)) {
+        perror("manifest");
+        return EXIT_FAILURE;
+    }
+
+    if ((zpipe_input = zpipe_open_read(&input_zpipe, infile)) < 0) {
+        perror("input");
+        return EXIT_FAILURE;
+    }
+
+    if (uring) {
+        uring_input = begin_uring(zpipe_input ? NULL : infile, &input_aio, debug_enabled);
+    }
+    ring_input = zpipe_input || (pipeline && !uring_input);
+    ring_output = compression != ZPIPE_NONE || (pipeline && !uring);
+    if ((ring_input && !ring_init(&input_ring, RING_DEFAULT_BLOCK_COUNT)) ||
+        (ring_output && !ring_init(&output_ring, RING_DEFAULT_BLOCK_COUNT))) {
+        if (zpipe_input || compression != ZPIPE_NONE) {
+            (void) fprintf(stderr, "Compression not supported\n");
+            return EXIT_FAILURE;
+        }
+        (void) fprintf(stderr, "Warning: Pipeline not supported\n");
+        ring_input = ring_output = false;
+    } else if ((ring_input && !(zpipe_input ?
+                                zpipe_start_reader(&input_zpipe, &input_ring) :
+                                ring_start_reader(&input_ring, infile))) ||
+               (ring_output && !(compression != ZPIPE_NONE ?
+                                 zpipe_start_writer(&output_zpipe, &output_ring,
+                                                    outfile, compression) :
+                                 ring_start_writer(&output_ring)))) {
+        perror("pipeline");
+        return EXIT_FAILURE;
+    }
+
     {
 #ifdef IHEX_EXTERNAL_WRITE_BUFFER
         // How to provide an external write buffer with limited duration:
         char buffer[IHEX_WRITE_BUFFER_LENGTH];
         ihex_write_buffer = buffer;
 #endif
-        ihex_init(&ihex);
-        ihex_set_output_line_length(&ihex, line_length);
-        ihex_write_at_address(&ihex, initial_address);
+        ihex_init(&output);
+        ihex_set_output_line_length(&output, line_length);
+        ihex_write_at_address(&output, initial_address);
         if (write_initial_address) {
             if (debug_enabled) {
                 (void) fprintf(stderr, "Address offset: 0x%lx\n",
-                        (unsigned long) ihex.address);
+                        (unsigned long) output.address);
             }
-            ihex.flags |= IHEX_FLAG_ADDRESS_OVERFLOW;
+            output.flags |= IHEX_FLAG_ADDRESS_OVERFLOW;
         }
-        while ((count = (ihex_count_t) fread(buf, 1, sizeof(buf), infile))) {
-            ihex_write_bytes(&ihex, buf, count);
+        input_address = (unsigned long) output.address;
+        if (uring_input) {
+            const uint8_t *data;
+            size_t length;
+            while ((length = aio_read_next(&input_aio, &data))) {
+                swap_stage_write(&swap, input_address, data, length);
+                input_address += (unsigned long) length;
+                bytes_read += length;
+            }
+            if (!aio_end(&input_aio)) {
+                errno = input_aio.error;
+                perror("input");
+                return EXIT_FAILURE;
+            }
+            aio_free(&input_aio);
+        } else if (ring_input) {
+            struct ring_block *block;
+            while ((block = ring_next(&input_ring))) {
+                swap_stage_write(&swap, input_address, block->data, block->length);
+                input_address += (unsigned long) block->length;
+                bytes_read += block->length;
+                ring_release(&input_ring);
+            }
+            if (!ring_join(&input_ring)) {
+                errno = zpipe_input ? input_zpipe.error : errno;
+                perror("input");
+                return EXIT_FAILURE;
+            }
+            ring_free(&input_ring);
+        } else {
+            while ((count = (ihex_count_t) fread(buf, 1, sizeof(buf), infile))) {
+                swap_stage_write(&swap, input_address, buf, (size_t) count);
+                input_address += (unsigned long) count;
+                bytes_read += (unsigned long long) count;
+            }
+        }
+        swap_stage_flush(&swap);
+        ihex_end_write(&output);
+        if (uring) {
+            if (aio_block) {
+                submit_aio_block();
+            }
+            if (!aio_end(&output_aio)) {
+                errno = output_aio.error;
+                perror("write");
+                return EXIT_FAILURE;
+            }
+            aio_free(&output_aio);
+        } else if (ring_output) {
+            if (output_block) {
+                ring_commit(&output_ring);
+            }
+            ring_close(&output_ring);
+            if (!ring_join(&output_ring)) {
+                errno = output_zpipe.error;
+                perror("output");
+                return EXIT_FAILURE;
+            }
+            ring_free(&output_ring);
         }
-        ihex_end_write(&ihex);
 #ifdef IHEX_EXTERNAL_WRITE_BUFFER
         ihex_write_buffer = NULL;
 #endif
     }
 
-    if (outfile != stdout) {
-        (void) fclose(outfile);
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("output");
+        return EXIT_FAILURE;
     }
-    if (infile != stdout) {
+    if (infile != stdin) {
         (void) fclose(infile);
     }
 
+    if (manifest_file) {
+        if (!manifest_end(&manifest) || fclose(manifest_file)) {
+            perror("manifest");
+            return EXIT_FAILURE;
+        }
+    }
+
     if (debug_enabled) {
-        (void) fprintf(stderr, "%lu bytes read\n",
-                (unsigned long) ihex.address - initial_address);
+        (void) fprintf(stderr, "%llu bytes read\n", bytes_read);
+    }
+
+    if (print_stats) {
+        (void) ihex_stats_print(&output, stderr, stats_json);
     }
 
     return EXIT_SUCCESS;
@@ -158,6 +595,74 @@ argument_error:
 
 void
 ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    const size_t length = (size_t) (eptr - buffer);
+    if (batch_mode) {
+        struct conversion * const conversion = (struct conversion *) ihex;
+        struct batch_job * const job = conversion->job;
+        if (job->failed) {
+            return;
+        }
+        if (!fwrite(buffer, length, 1, conversion->file)) {
+            batch_fail(job, "%s: %s", job->output, strerror(errno));
+            return;
+        }
+        job->bytes_written += length;
+        return;
+    }
+    if (uring) {
+        // collect the lines into blocks written at consecutive offsets
+        if (aio_block && AIO_BLOCK_SIZE - aio_block_length < length) {
+            submit_aio_block();
+        }
+        if (!aio_block) {
+            if (!(aio_block = aio_write_buffer(&output_aio))) {
+                errno = output_aio.error;
+                perror("write");
+                exit(EXIT_FAILURE);
+            }
+            aio_block_length = 0;
+        }
+        (void) memcpy(aio_block + aio_block_length, buffer, length);
+        aio_block_length += length;
+        return;
+    }
+    if (ring_output) {
+        // collect the lines into blocks for the output thread
+        if (output_block && RING_BLOCK_SIZE - output_block->length < length) {
+            ring_commit(&output_ring);
+            output_block = NULL;
+        }
+        if (!output_block) {
+            output_block = ring_acquire(&output_ring);
+            output_block->length = 0;
+        }
+        (void) memcpy(output_block->data + output_block->length, buffer, length);
+        output_block->length += length;
+        return;
+    }
     *eptr = '\0';
     (void) fputs(buffer, outfile);
 }
+
+void
+ring_block_output (struct ring *ring, struct ring_block *block) {
+    if (!fwrite(block->data, block->length, 1, outfile)) {
+        perror("fwrite");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+swap_stage_output (struct swap_stage *stage,
+                   unsigned long address,
+                   const uint8_t *data,
+                   size_t count) {
+    if (address != (unsigned long) output.address + output.length) {
+        ihex_write_at_address(&output, (ihex_address_t) address);
+    }
+    if (manifest_file && !manifest_write(&manifest, address, data, count)) {
+        perror("manifest");
+        exit(EXIT_FAILURE);
+    }
+    (void) ihex_write_block(&output, data, count);
+}
@@ -0,0 +1,375 @@
+/*
+ * elf2ihex.c: Convert the loadable segments of an ELF file to Intel HEX.
+ *
+ * Usage: elf2ihex -i <in.elf> [-o <out.hex>] [-b <length>] [-p] [-n] [-v]
+ *
+ * The program headers of the ELF file are read, and the contents of each
+ * loadable segment (`PT_LOAD`) are written at its physical address, i.e.,
+ * the load address in ROM. The option `-p` uses the virtual addresses
+ * instead. Only the bytes present in the file are written (not the zero
+ * fill of segments such as `.bss`), and nothing is written for the gaps
+ * between segments, so the conversion takes time in proportion to the
+ * actual data and not the address range it spans.
+ *
+ * The entry point of the ELF file is written as a start linear address
+ * record, unless the option `-n` is given. The number of data bytes per
+ * line can be set with the option `-b`, as with bin2ihex. Both 32- and
+ * 64-bit ELF files of either byte order are supported, but the addresses
+ * must fit in 32 bits.
+ *
+ * The input file is mapped into memory where supported, and read
+ * otherwise, so it can not be read from standard input.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#if !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "kk_ihex_write.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ELF2IHEX_MMAP
+#endif
+
+#define EI_NIDENT       16
+#define EI_CLASS        4
+#define EI_DATA         5
+#define ELFCLASS32      1
+#define ELFCLASS64      2
+#define ELFDATA2LSB     1
+#define ELFDATA2MSB     2
+#define PT_LOAD         1
+
+#define ADDRESS_MAX     0xFFFFFFFFULL
+
+struct segment {
+    unsigned long long  address;
+    unsigned long long  offset;
+    unsigned long long  size;
+};
+
+static FILE *outfile;
+static const uint8_t *elf;
+static size_t elf_size;
+static bool big_endian;
+
+// Read an unsigned integer of `size` bytes at `offset` of the ELF file.
+//
+static unsigned long long
+elf_read (const unsigned long long offset, const unsigned size) {
+    unsigned long long value = 0;
+    unsigned i;
+    for (i = 0; i < size; ++i) {
+        const unsigned byte = elf[offset + (big_endian ? i : size - 1U - i)];
+        value = (value << 8) | byte;
+    }
+    return value;
+}
+
+static int
+compare_segments (const void *a, const void *b) {
+    const struct segment *sa = (const struct segment *) a;
+    const struct segment *sb = (const struct segment *) b;
+    return (sa->address > sb->address) - (sa->address < sb->address);
+}
+
+// Map (or read) the file `name` into `elf`, returns false on error.
+//
+static bool
+load_file (const char *name) {
+#ifdef ELF2IHEX_MMAP
+    struct stat st;
+    void *map;
+    const int fd = open(name, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &st)) {
+        (void) close(fd);
+        return false;
+    }
+    elf_size = (size_t) st.st_size;
+    if (!elf_size) {
+        (void) close(fd);
+        elf = NULL;
+        return true;
+    }
+    map = mmap(NULL, elf_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    (void) close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    elf = (const uint8_t *) map;
+    return true;
+#else
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+    size_t n_read;
+    FILE *file = fopen(name, "rb");
+    if (!file) {
+        return false;
+    }
+    elf_size = 0;
+    do {
+        if (elf_size == capacity) {
+            uint8_t *new_buffer;
+            capacity = capacity ? capacity * 2 : 65536;
+            if (!(new_buffer = realloc(buffer, capacity))) {
+                free(buffer);
+                (void) fclose(file);
+                return false;
+            }
+            buffer = new_buffer;
+        }
+        n_read = fread(buffer + elf_size, 1, capacity - elf_size, file);
+        elf_size += n_read;
+    } while (n_read);
+    if (ferror(file)) {
+        free(buffer);
+        (void) fclose(file);
+        return false;
+    }
+    (void) fclose(file);
+    elf = buffer;
+    return true;
+#endif
+}
+
+int
+main (int argc, char *argv[]) {
+    struct ihex_state ihex;
+    const char *inname = NULL;
+    uint8_t line_length = IHEX_DEFAULT_OUTPUT_LINE_LENGTH;
+    bool debug_enabled = false;
+    bool virtual_addresses = false;
+    bool write_start_address = true;
+    bool is_64bit;
+    unsigned long long entry;
+    unsigned long long phoff;
+    unsigned phentsize;
+    unsigned phnum;
+    struct segment *segments;
+    unsigned segment_count = 0;
+    unsigned long long end_address = 0;
+    unsigned long long total = 0;
+    unsigned i;
+    char *arg = NULL;
+
+    outfile = stdout;
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'i':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                inname = *(++argv);
+                break;
+            case 'o':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(outfile = fopen(*argv, "w"))) {
+                    goto argument_error;
+                }
+                break;
+            case 'b': {
+                unsigned long length;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                length = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !length || length > IHEX_MAX_OUTPUT_LINE_LENGTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                line_length = (uint8_t) length;
+                break;
+            }
+            case 'p':
+                virtual_addresses = true;
+                break;
+            case 'n':
+                write_start_address = false;
+                break;
+            case 'v':
+                debug_enabled = true;
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
+                               " - Copyright (c) 2013-2026 Kimmo Kulovesi\n");
+        (void) fprintf(stderr, "Usage: elf2ihex -i <in.elf> [-o <out.hex>]"
+                               " [-b <length>] [-p] [-n] [-v]\n");
+        return arg ? EXIT_FAILURE : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_FAILURE;
+    }
+
+    if (!inname) {
+        arg = "";
+        goto usage;
+    }
+    if (!load_file(inname)) {
+        perror(inname);
+        return EXIT_FAILURE;
+    }
+
+    // ELF header
+    if (elf_size < EI_NIDENT || memcmp(elf, "\177ELF", 4)) {
+        (void) fprintf(stderr, "%s: Not an ELF file\n", inname);
+        return EXIT_FAILURE;
+    }
+    if ((elf[EI_CLASS] != ELFCLASS32 && elf[EI_CLASS] != ELFCLASS64) ||
+        (elf[EI_DATA] != ELFDATA2LSB && elf[EI_DATA] != ELFDATA2MSB)) {
+        (void) fprintf(stderr, "%s: Unsupported ELF class or byte order\n", inname);
+        return EXIT_FAILURE;
+    }
+    is_64bit = (elf[EI_CLASS] == ELFCLASS64);
+    big_endian = (elf[EI_DATA] == ELFDATA2MSB);
+    if (elf_size < (is_64bit ? 64U : 52U)) {
+        (void) fprintf(stderr, "%s: Truncated ELF header\n", inname);
+        return EXIT_FAILURE;
+    }
+    if (is_64bit) {
+        entry = elf_read(24, 8);
+        phoff = elf_read(32, 8);
+        phentsize = (unsigned) elf_read(54, 2);
+        phnum = (unsigned) elf_read(56, 2);
+    } else {
+        entry = elf_read(24, 4);
+        phoff = elf_read(28, 4);
+        phentsize = (unsigned) elf_read(42, 2);
+        phnum = (unsigned) elf_read(44, 2);
+    }
+    if (phnum && (phentsize < (is_64bit ? 56U : 32U) || phoff > elf_size ||
+                  (elf_size - phoff) / phentsize < phnum)) {
+        (void) fprintf(stderr, "%s: Invalid program headers\n", inname);
+        return EXIT_FAILURE;
+    }
+    if (!(segments = malloc((phnum ? phnum : 1U) * sizeof(*segments)))) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+
+    // program headers
+    for (i = 0; i < phnum; ++i) {
+        const unsigned long long ph = phoff + (unsigned long long) i * phentsize;
+        struct segment * const segment = &segments[segment_count];
+        if (elf_read(ph, 4) != PT_LOAD) {
+            continue;
+        }
+        if (is_64bit) {
+            segment->offset = elf_read(ph + 8, 8);
+            segment->address = elf_read(ph + (virtual_addresses ? 16 : 24), 8);
+            segment->size = elf_read(ph + 32, 8);
+        } else {
+            segment->offset = elf_read(ph + 4, 4);
+            segment->address = elf_read(ph + (virtual_addresses ? 8 : 12), 4);
+            segment->size = elf_read(ph + 16, 4);
+        }
+        if (!segment->size) {
+            continue;
+        }
+        if (segment->offset > elf_size || elf_size - segment->offset < segment->size) {
+            (void) fprintf(stderr, "%s: Segment %u extends past end of file\n",
+                           inname, i);
+            return EXIT_FAILURE;
+        }
+        if (segment->address > ADDRESS_MAX ||
+            ADDRESS_MAX - segment->address < segment->size - 1U) {
+            (void) fprintf(stderr, "%s: Segment %u address 0x%llx"
+                                   " does not fit in 32 bits\n",
+                           inname, i, segment->address);
+            return EXIT_FAILURE;
+        }
+        ++segment_count;
+    }
+    qsort(segments, segment_count, sizeof(*segments), compare_segments);
+
+    ihex_init(&ihex);
+    ihex_set_output_line_length(&ihex, line_length);
+    for (i = 0; i < segment_count; ++i) {
+        const struct segment * const segment = &segments[i];
+        const uint8_t *data = elf + segment->offset;
+        unsigned long long count = segment->size;
+
+        if (segment->address < end_address) {
+            (void) fprintf(stderr, "Warning: segments overlap at 0x%08llx\n",
+                           segment->address);
+        }
+        end_address = segment->address + segment->size;
+        total += segment->size;
+        if (debug_enabled) {
+            (void) fprintf(stderr, "0x%08llx-0x%08llx (%llu bytes)\n",
+                           segment->address, end_address - 1U, segment->size);
+        }
+
+        ihex_write_at_address(&ihex, (ihex_address_t) segment->address);
+        while (count) {
+            const ihex_count_t n = (count < 0x4000U) ? (ihex_count_t) count : 0x4000;
+            ihex_write_bytes(&ihex, data, n);
+            data += n;
+            count -= (unsigned long long) n;
+        }
+    }
+    if (write_start_address) {
+        if (entry > ADDRESS_MAX) {
+            (void) fprintf(stderr, "%s: Entry point 0x%llx"
+                                   " does not fit in 32 bits\n", inname, entry);
+            return EXIT_FAILURE;
+        }
+        ihex_write_start_address(&ihex, (ihex_address_t) entry);
+    }
+    ihex_end_write(&ihex);
+    free(segments);
+
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("elf2ihex");
+        return EXIT_FAILURE;
+    }
+
+    if (debug_enabled) {
+        (void) fprintf(stderr, "%u segments, %llu bytes written\n",
+                       segment_count, total);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+void
+ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    *eptr = '\0';
+    (void) fputs(buffer, outfile);
+}
@@ -16,34 +16,512 @@
  * to the first address that would be written (i.e., first byte of
  * data written will be at address 0).
  *
+ * The command-line option `-m` writes a manifest of per-block CRC-32
+ * hashes of the data (see `kk_manifest.h`) to the given file, e.g., for
+ * comparison against the manifest of a previous image to find which flash
+ * sectors have changed. The block size (default 4096) and the fill byte
+ * used for missing data (default 0xFF) can be set with options `-s` and
+ * `-f`, respectively. The manifest uses the addresses of the IHEX input,
+ * i.e., the address offset is not subtracted from them.
+ *
+ * The command-line options `--swap16` and `--swap32` swap the order of
+ * bytes in each 16- or 32-bit word, and `--swapwords` swaps the 16-bit
+ * halves of each 32-bit word (see `kk_swap.h`). The words are aligned
+ * by the IHEX addresses, any bytes of an incomplete word are left
+ * unswapped, and the swapped data is also used for the manifest.
+ *
+ * Input compressed with gzip, zstd, or xz is recognised and decompressed
+ * automatically, and the option `-z` compresses the output in the given
+ * format (see `kk_zpipe.h`). The codec runs in a thread of its own, and
+ * passes the data to or from the conversion through a ring buffer as with
+ * `--pipeline`. The compressed output can not be written sparsely, i.e.,
+ * gaps are filled with zeros as for standard output.
+ *
+ * The command-line option `--pipeline` reads the input and writes the
+ * output in threads of their own, passing large blocks of data to and
+ * from the conversion through ring buffers (see `kk_ring.h`), so that
+ * the I/O and the conversion run concurrently.
+ *
+ * The command-line option `--uring` reads the input and writes the output
+ * with asynchronous I/O through io_uring on Linux (see `kk_aio.h`), with
+ * several large reads in flight ahead of the conversion, and each run of
+ * contiguous output written at its position in the output file, i.e.,
+ * records out of address order do not require seeking. It only applies
+ * to uncompressed regular files; other input and output falls back to
+ * `--pipeline` (if given) or to standard I/O.
+ *
+ * The command-line option `--batch` converts many files in one process,
+ * given as pairs of input and output file names, either as arguments or
+ * listed in a file with the option `-l` (see `kk_batch.h`). The files are
+ * converted concurrently on a pool of threads, the number of which can be
+ * set with the option `-j` (default is the number of processors). A
+ * failure to convert one file does not stop the others, and the status
+ * of each file is reported along with the totals. The options `-a` and
+ * `-A` apply to each file separately.
+ *
+ * The command-line option `--check-overlaps` reports every range of data
+ * that is written more than once, with the line numbers of both writes,
+ * and whether the data differs from what was written there before, and makes the exit
+ * status indicate failure if there are any (see `kk_overlap.h`). The data
+ * can only be compared when the output is an uncompressed file written
+ * without `--pipeline` or `--uring`.
+ *
+ * The command-line option `--stats` prints statistics of the conversion
+ * (records by type, data bytes, errors, skipped junk, address changes,
+ * and callback and flush calls) on standard error at the end, or
+ * `--stats=json` as one line of JSON. It requires the library to be built
+ * with `IHEX_ENABLE_STATS` (see `kk_ihex.h` and `kk_ihex_stats.h`).
+ *
  * Copyright (c) 2013-2019 Kimmo Kulovesi, https://arkku.com
  * Provided with absolutely no warranty, use at your own risk only.
  * Distribute freely, mark modified copies as such.
  */
 
+#if !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
 #include "kk_ihex_read.h"
+#include "kk_ihex_stats.h"
+#include "kk_aio.h"
+#include "kk_batch.h"
+#include "kk_manifest.h"
+#include "kk_overlap.h"
+#include "kk_swap.h"
+#include "kk_ring.h"
+#include "kk_zpipe.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
+#ifdef _POSIX_C_SOURCE
+#include <sys/types.h>
+#endif
 
 #define AUTODETECT_ADDRESS (~0UL)
 
 static FILE *outfile;
 static unsigned long line_number = 1L;
-static unsigned long file_position = 0L;
+static unsigned long long file_position = 0;
+static unsigned long long bytes_written = 0;
 static unsigned long address_offset = 0UL;
 static bool debug_enabled = 0;
+static struct manifest manifest;
+static FILE *manifest_file = NULL;
+static struct swap_stage swap;
+static bool pipeline = false;
+static bool ring_output = false;
+static struct ring output_ring;
+static struct zpipe output_zpipe;
+static enum zpipe_format compression = ZPIPE_NONE;
+static struct ring_block *output_block = NULL;
+static bool uring = false;
+static struct aio output_aio;
+static unsigned long long output_offset = 0;
+static unsigned long long output_position = 0;
+
+// The addresses written for `--check-overlaps`
+static bool check_overlaps = false;
+static bool compare_overlaps = false;
+static struct overlap_map overlaps;
+static unsigned long overlap_count = 0;
+static unsigned long differing_overlap_count = 0;
+static unsigned long long overlap_bytes = 0;
+
+// The block of output being collected for `--pipeline` or `--uring`
+static uint8_t *block_data = NULL;
+static unsigned long long block_address;
+static size_t block_length;
+static size_t output_block_size;
+
+static bool batch_mode = false;
+static bool print_stats = false;
+static bool stats_json = false;
+
+// The state of one conversion in batch mode
+struct conversion {
+    struct ihex_state   ihex;   // first, so that `ihex_data_read` finds the rest
+    struct batch_job    *job;
+    FILE                *file;
+    unsigned long       line_number;
+    unsigned long       address_offset;
+    unsigned long long  position;
+    bool                end_of_file;
+};
+
+// Read `length` bytes of IHEX from `data` a line at a time, counting lines.
+//
+static void
+read_lines (struct ihex_state * const ihex, const char *data, size_t length) {
+    while (length) {
+        const char * const newline = memchr(data, '\n', length);
+        const size_t count = newline ? (size_t) (newline - data) + 1U : length;
+        (void) ihex_read_block(ihex, data, count);
+        line_number += (newline != NULL);
+        data += count;
+        length -= count;
+    }
+}
+
+// Seek to `position` of `file`, returns zero on success (the position
+// may be beyond 2 GiB, where `off_t` is wider than `long`).
+//
+static int
+seek_to (FILE *file, const unsigned long long position) {
+#ifdef _POSIX_C_SOURCE
+    const off_t offset = (off_t) position;
+    if (offset < 0 || (unsigned long long) offset != position) {
+        errno = ERANGE;
+        return -1;
+    }
+    return fseeko(file, offset, SEEK_SET);
+#else
+    if (position > (unsigned long long) LONG_MAX) {
+        errno = ERANGE;
+        return -1;
+    }
+    return fseek(file, (long) position, SEEK_SET);
+#endif
+}
+
+// Write `count` bytes from `data` at `address` of the output file.
+//
+static void
+write_at (const unsigned long long address, const uint8_t *data, const size_t count) {
+    unsigned long long position = output_position;
+
+    if (address != position) {
+        if (outfile == stdout || seek_to(outfile, address)) {
+            if (position < address) {
+                // "seek" forward in stdout by writing NUL bytes
+                do {
+                    (void) fputc('\0', outfile);
+                } while (++position < address);
+            } else {
+                perror("fseek");
+                exit(EXIT_FAILURE);
+            }
+        }
+        position = address;
+    }
+    if (!fwrite(data, count, 1, outfile)) {
+        perror("fwrite");
+        exit(EXIT_FAILURE);
+    }
+    output_position = position + count;
+}
+
+// Compare `count` bytes of `data` to those at `position` of the output
+// file, returns 1 if they differ, 0 if they are the same, or -1 if the
+// output file could not be read.
+//
+static int
+compare_output (const unsigned long long position, const uint8_t *data, size_t count) {
+    uint8_t buf[256];
+    int differ = 0;
+
+    output_position = ~0ULL; // the next write must seek after reading
+    if (seek_to(outfile, position)) {
+        return -1;
+    }
+    while (count) {
+        const size_t n = (count < sizeof(buf)) ? count : sizeof(buf);
+        if (fread(buf, 1, n, outfile) != n) {
+            clearerr(outfile);
+            return -1;
+        }
+        differ |= (memcmp(buf, data, n) != 0);
+        data += n;
+        count -= n;
+    }
+    return differ;
+}
+
+// Start a new block of output at `address`.
+//
+static void
+begin_block (const unsigned long long address) {
+    if (uring) {
+        if (!(block_data = aio_write_buffer(&output_aio))) {
+            errno = output_aio.error;
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        output_block_size = AIO_BLOCK_SIZE;
+    } else {
+        output_block = ring_acquire(&output_ring);
+        output_block->address = address;
+        block_data = output_block->data;
+        output_block_size = RING_BLOCK_SIZE;
+    }
+    block_address = address;
+    block_length = 0;
+}
+
+// Pass the current block of output on to be written.
+//
+static void
+end_block (void) {
+    if (!block_data) {
+        return;
+    }
+    if (uring) {
+        aio_write_submit(&output_aio, output_offset + block_address, block_length);
+    } else {
+        output_block->length = block_length;
+        ring_commit(&output_ring);
+        output_block = NULL;
+    }
+    block_data = NULL;
+}
+
+// Write `count` bytes from `data` at `address` in blocks for the output
+// thread or io_uring.
+//
+static void
+write_blocks (unsigned long long address, const uint8_t *data, size_t count) {
+    while (count) {
+        size_t n;
+        if (block_data && (block_length == output_block_size ||
+                           block_address + block_length != address)) {
+            end_block();
+        }
+        if (!block_data) {
+            begin_block(address);
+        }
+        n = output_block_size - block_length;
+        n = (n < count) ? n : count;
+        (void) memcpy(block_data + block_length, data, n);
+        block_length += n;
+        address += n;
+        data += n;
+        count -= n;
+    }
+}
+
+// Write `count` bytes from `data` at `address`, either directly or
+// through the output thread or io_uring.
+//
+static void
+write_output (const unsigned long long address, const uint8_t *data, const size_t count) {
+    if (!ring_output && !uring) {
+        write_at(address, data, count);
+        return;
+    }
+    if (compression != ZPIPE_NONE) {
+        // the compressed output is written in order, filling gaps with
+        // zeros as for standard output
+        static const uint8_t zeros[4096];
+        if (address < output_position) {
+            errno = ESPIPE;
+            perror("fseek");
+            exit(EXIT_FAILURE);
+        }
+        while (output_position < address) {
+            const unsigned long long gap = address - output_position;
+            const size_t n = (gap < sizeof(zeros)) ? (size_t) gap : sizeof(zeros);
+            write_blocks(output_position, zeros, n);
+            output_position += n;
+        }
+        output_position += count;
+    }
+    write_blocks(address, data, count);
+}
+
+// Finish writing the output and close the output file.
+//
+static void
+end_output (void) {
+    end_block();
+    if (uring) {
+        if (!aio_end(&output_aio)) {
+            errno = output_aio.error;
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        aio_free(&output_aio);
+        uring = false;
+    } else if (ring_output) {
+        ring_close(&output_ring);
+        if (!ring_join(&output_ring)) {
+            errno = output_zpipe.error;
+            perror("output");
+            exit(EXIT_FAILURE);
+        }
+        ring_free(&output_ring);
+        ring_output = false;
+    }
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("output");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Set up io_uring for `infile` (into `input_aio`, unless `infile` is
+// NULL) and the uncompressed output file, returns whether the input uses
+// it. The output uses it if `uring` is still set afterwards.
+//
+static bool
+begin_uring (FILE *infile, struct aio *input_aio) {
+    unsigned long long input_offset;
+    bool uring_input = false;
+    int fd;
+
+    if (infile && (fd = aio_file(infile, false, &input_offset)) >= 0 &&
+        aio_init(input_aio, fd, AIO_DEFAULT_DEPTH)) {
+        uring_input = true;
+        aio_begin_read(input_aio, input_offset);
+    }
+    uring = (compression == ZPIPE_NONE &&
+             (fd = aio_file(outfile, true, &output_offset)) >= 0 &&
+             aio_init(&output_aio, fd, AIO_DEFAULT_DEPTH));
+    if (debug_enabled && !(uring_input && uring)) {
+        (void) fprintf(stderr, "io_uring not used for%s%s\n",
+                       uring_input ? "" : " input",
+                       uring ? "" : (uring_input ? " output" : " or output"));
+    }
+    return uring_input;
+}
+
+// Convert the IHEX file `job->input` to binary `job->output`.
+//
+void
+batch_job_run (struct batch *batch, struct batch_job *job, unsigned worker) {
+    struct conversion conversion;
+    char buf[256];
+    FILE *infile;
+
+    (void) batch;
+    (void) worker;
+    if (!(infile = fopen(job->input, "r"))) {
+        batch_fail(job, "%s: %s", job->input, strerror(errno));
+        return;
+    }
+    if (!(conversion.file = fopen(job->output, "wb"))) {
+        batch_fail(job, "%s: %s", job->output, strerror(errno));
+        (void) fclose(infile);
+        return;
+    }
+    conversion.job = job;
+    conversion.line_number = 1;
+    conversion.address_offset = address_offset;
+    conversion.position = 0;
+    conversion.end_of_file = false;
+    ihex_read_at_address(&conversion.ihex,
+                         (address_offset != AUTODETECT_ADDRESS) ?
+                         (ihex_address_t) address_offset : 0);
+    while (!job->failed && fgets(buf, sizeof(buf), infile)) {
+        const ihex_count_t count = (ihex_count_t) strlen(buf);
+        ihex_read_bytes(&conversion.ihex, buf, count);
+        conversion.line_number += (count && buf[count - 1] == '\n');
+        job->bytes_read += (unsigned long long) count;
+    }
+    if (!job->failed) {
+        ihex_end_read(&conversion.ihex);
+    }
+    if (ferror(infile)) {
+        batch_fail(job, "%s: %s", job->input, strerror(errno));
+    }
+    (void) fclose(infile);
+    if (fclose(conversion.file)) {
+        batch_fail(job, "%s: %s", job->output, strerror(errno));
+    }
+    if (job->failed) {
+        (void) remove(job->output);
+    }
+}
+
+// Handle a record read in batch mode, as `ihex_data_read` does otherwise.
+//
+static ihex_bool_t
+batch_data_read (struct conversion * const conversion,
+                 const ihex_record_type_t type,
+                 const ihex_bool_t error) {
+    struct ihex_state * const ihex = &conversion->ihex;
+    struct batch_job * const job = conversion->job;
+
+    if (job->failed) {
+        return false;
+    }
+    if (error) {
+        batch_fail(job, "Checksum error on line %lu", conversion->line_number);
+    } else if (ihex->length < ihex->line_length) {
+        batch_fail(job, "Line length error on line %lu", conversion->line_number);
+    } else if (conversion->end_of_file) {
+        batch_fail(job, "Excess data after end of file record");
+    } else if (type == IHEX_END_OF_FILE_RECORD) {
+        conversion->end_of_file = true;
+    } else if (type == IHEX_DATA_RECORD && ihex->length) {
+        unsigned long long address = IHEX_LINEAR_ADDRESS(ihex);
+        if (address < conversion->address_offset) {
+            if (conversion->address_offset != AUTODETECT_ADDRESS) {
+                batch_fail(job, "Address underflow on line %lu",
+                           conversion->line_number);
+                return false;
+            }
+            conversion->address_offset = (unsigned long) address;
+        }
+        address -= conversion->address_offset;
+        if ((address != conversion->position &&
+             seek_to(conversion->file, address)) ||
+            !fwrite(ihex->data, ihex->length, 1, conversion->file)) {
+            batch_fail(job, "%s: %s", job->output, strerror(errno));
+            return false;
+        }
+        conversion->position = address + ihex->length;
+        job->bytes_written += ihex->length;
+    }
+    return !job->failed;
+}
+
+// Run the conversions of `batch` on `workers` threads and report them.
+//
+static int
+run_batch (struct batch *batch, const unsigned workers) {
+    int status;
+
+    if (!batch_run(batch, workers)) {
+        perror("batch");
+        batch_free(batch);
+        return EXIT_FAILURE;
+    }
+    batch_report(batch, stdout);
+    status = batch->failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    batch_free(batch);
+    if (fflush(stdout)) {
+        perror("batch");
+        return EXIT_FAILURE;
+    }
+    return status;
+}
 
 int
 main (int argc, char *argv[]) {
     struct ihex_state ihex;
     FILE *infile = stdin;
+    struct ring input_ring;
+    struct aio input_aio;
+    bool uring_input = false;
+    bool ring_input = false;
+    struct zpipe input_zpipe;
+    int zpipe_input;
+    struct batch batch;
+    const char *batch_input = NULL;
+    const char *outname = NULL;
+    unsigned long workers = 0;
     ihex_count_t count;
+    unsigned long block_size = MANIFEST_DEFAULT_BLOCK_SIZE;
+    unsigned long fill = MANIFEST_DEFAULT_FILL;
+    enum swap_mode swap_mode;
     char buf[256];
 
     outfile = stdout;
+    batch_init(&batch);
 
     while (--argc) {
         char *arg = *(++argv);
@@ -74,14 +552,86 @@ main (int argc, char *argv[]) {
                 }
                 break;
             case 'o':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                outname = *(++argv);
+                break;
+            case 'm':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(manifest_file = fopen(*argv, "w"))) {
+                    goto argument_error;
+                }
+                break;
+            case 's':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                block_size = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !block_size) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'f':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                fill = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || fill > 0xFFU) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'z':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                arg = *(++argv);
+                if ((compression = zpipe_format_option(arg)) == ZPIPE_NONE) {
+                    goto invalid_argument;
+                }
+                if (!zpipe_format_supported(compression)) {
+                    (void) fprintf(stderr, "-z %s is not supported by this build\n", arg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'j':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                workers = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || workers > BATCH_MAX_WORKERS) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'l': {
+                FILE *list;
                 if (--argc == 0) {
                     goto invalid_argument;
                 }
                 ++argv;
-                if (!(outfile = fopen(*argv, "wb"))) {
+                if (!(list = strcmp(*argv, "-") ? fopen(*argv, "r") : stdin)) {
+                    goto argument_error;
+                }
+                if (!batch_read_list(&batch, list)) {
                     goto argument_error;
                 }
+                if (list != stdin) {
+                    (void) fclose(list);
+                }
                 break;
+            }
             case 'v':
                 debug_enabled = 1;
                 break;
@@ -93,6 +643,35 @@ main (int argc, char *argv[]) {
                 goto invalid_argument;
             }
             continue;
+        } else if (!strcmp(arg, "--pipeline")) {
+            pipeline = true;
+            continue;
+        } else if (!strcmp(arg, "--uring")) {
+            uring = true;
+            continue;
+        } else if (!strcmp(arg, "--batch")) {
+            batch_mode = true;
+            continue;
+        } else if (!strcmp(arg, "--check-overlaps")) {
+            check_overlaps = true;
+            continue;
+        } else if (!strcmp(arg, "--stats") || !strcmp(arg, "--stats=json")) {
+            print_stats = true;
+            stats_json = (arg[7] == '=');
+            continue;
+        } else if (arg[0] != '-') {
+            // a pair of input and output file names for batch mode
+            if (!batch_input) {
+                batch_input = arg;
+            } else if (batch_add(&batch, batch_input, arg)) {
+                batch_input = NULL;
+            } else {
+                goto argument_error;
+            }
+            continue;
+        } else if ((swap_mode = swap_option(arg)) != SWAP_NONE) {
+            swap_stage_init(&swap, swap_mode);
+            continue;
         }
 invalid_argument:
         (void) fprintf(stderr, "Invalid argument: %s\n", arg);
@@ -100,27 +679,156 @@ usage:
         (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
                                " - Copyright (c) 2013-2015 Kimmo Kulovesi\n");
         (void) fprintf(stderr, "Usage: ihex2bin ([-a <address_offset>]|[-A])"
-                                " [-o <out.bin>] [-i <in.hex>] [-v]\n");
+                                " [-o <out.bin>] [-i <in.hex>] [-v]\n"
+                               "                [-z <gzip|zstd|xz>] [--pipeline] [--uring]\n"
+                               "                [-m <manifest>"
+                               " [-s <block_size>] [-f <fill>]]\n"
+                               "                [--swap16|--swap32|--swapwords] [--stats[=json]]\n"
+                               "                [--check-overlaps]\n"
+                               "       ihex2bin --batch [-j <threads>] [-l <list>]"
+                               " ([-a <address_offset>]|[-A]) [-v]\n"
+                               "                [<in.hex> <out.bin> ...]\n");
         return arg ? EXIT_FAILURE : EXIT_SUCCESS;
 argument_error:
         perror(*argv);
         return EXIT_FAILURE;
     }
 
+    if (outname && !(outfile = fopen(outname, check_overlaps ? "w+b" : "wb"))) {
+        // read and write for comparing the data of overlaps
+        perror(outname);
+        return EXIT_FAILURE;
+    }
+
+    if (batch_mode || batch.count || batch_input) {
+        if (!batch_mode || batch_input) {
+            (void) fprintf(stderr, "%s\n", batch_mode ?
+                           "Missing output file name" :
+                           "File name arguments require --batch");
+            return EXIT_FAILURE;
+        }
+        if (infile != stdin || outfile != stdout || manifest_file ||
+            compression != ZPIPE_NONE || swap.mode != SWAP_NONE ||
+            pipeline || uring || print_stats || check_overlaps) {
+            (void) fprintf(stderr, "Only -a, -A, -j, -l and -v"
+                                   " can be used with --batch\n");
+            return EXIT_FAILURE;
+        }
+        return run_batch(&batch, (unsigned) workers);
+    }
+
+#ifndef IHEX_ENABLE_STATS
+    if (print_stats) {
+        (void) fprintf(stderr, "--stats requires building with IHEX_ENABLE_STATS\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    if (manifest_file && !manifest_init(&manifest, manifest_file,
+                                        block_size, (uint8_t) fill)) {
+        perror("manifest");
+        return EXIT_FAILURE;
+    }
+
+    if ((zpipe_input = zpipe_open_read(&input_zpipe, infile)) < 0) {
+        perror("input");
+        return EXIT_FAILURE;
+    }
+
+    if (uring) {
+        uring_input = begin_uring(zpipe_input ? NULL : infile, &input_aio);
+    }
+    ring_input = zpipe_input || (pipeline && !uring_input);
+    ring_output = compression != ZPIPE_NONE || (pipeline && !uring);
+    if ((ring_input && !ring_init(&input_ring, RING_DEFAULT_BLOCK_COUNT)) ||
+        (ring_output && !ring_init(&output_ring, RING_DEFAULT_BLOCK_COUNT))) {
+        if (zpipe_input || compression != ZPIPE_NONE) {
+            (void) fprintf(stderr, "Compression not supported\n");
+            return EXIT_FAILURE;
+        }
+        (void) fprintf(stderr, "Warning: Pipeline not supported\n");
+        ring_input = ring_output = false;
+    } else if ((ring_input && !(zpipe_input ?
+                                zpipe_start_reader(&input_zpipe, &input_ring) :
+                                ring_start_reader(&input_ring, infile))) ||
+               (ring_output && !(compression != ZPIPE_NONE ?
+                                 zpipe_start_writer(&output_zpipe, &output_ring,
+                                                    outfile, compression) :
+                                 ring_start_writer(&output_ring)))) {
+        perror("pipeline");
+        return EXIT_FAILURE;
+    }
+    if (check_overlaps) {
+        overlap_init(&overlaps);
+        compare_overlaps = (outfile != stdout && !ring_output && !uring);
+    }
+
     ihex_read_at_address(&ihex, (address_offset != AUTODETECT_ADDRESS) ?
                                 (ihex_address_t) address_offset :
                                 0);
-    while (fgets(buf, sizeof(buf), infile)) {
-        count = (ihex_count_t) strlen(buf);
-        ihex_read_bytes(&ihex, buf, count);
-        line_number += (count && buf[count - 1] == '\n');
+    if (uring_input) {
+        const uint8_t *data;
+        size_t length;
+        while ((length = aio_read_next(&input_aio, &data))) {
+            read_lines(&ihex, (const char *) data, length);
+        }
+        if (!aio_end(&input_aio)) {
+            errno = input_aio.error;
+            perror("input");
+            return EXIT_FAILURE;
+        }
+        aio_free(&input_aio);
+    } else if (ring_input) {
+        struct ring_block *block;
+        while ((block = ring_next(&input_ring))) {
+            read_lines(&ihex, (const char *) block->data, block->length);
+            ring_release(&input_ring);
+        }
+        if (!ring_join(&input_ring)) {
+            errno = zpipe_input ? input_zpipe.error : errno;
+            perror("input");
+            return EXIT_FAILURE;
+        }
+        ring_free(&input_ring);
+    } else {
+        while (fgets(buf, sizeof(buf), infile)) {
+            count = (ihex_count_t) strlen(buf);
+            ihex_read_bytes(&ihex, buf, count);
+            line_number += (count && buf[count - 1] == '\n');
+        }
     }
     ihex_end_read(&ihex);
+    if (outfile) {
+        // no end of file record
+        swap_stage_flush(&swap);
+        end_output();
+    }
 
     if (infile != stdin) {
         (void) fclose(infile);
     }
 
+    if (manifest_file) {
+        if (!manifest_end(&manifest) || fclose(manifest_file)) {
+            perror("manifest");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (print_stats) {
+        (void) ihex_stats_print(&ihex, stderr, stats_json);
+    }
+
+    if (check_overlaps) {
+        overlap_free(&overlaps);
+        if (overlap_count) {
+            (void) fprintf(stderr, "%lu overlaps of %llu bytes, %lu with"
+                                   " different data\n", overlap_count,
+                           overlap_bytes, differing_overlap_count);
+            return EXIT_FAILURE;
+        }
+    }
+
     return EXIT_SUCCESS;
 }
 
@@ -128,6 +836,9 @@ ihex_bool_t
 ihex_data_read (struct ihex_state *ihex,
                 ihex_record_type_t type,
                 ihex_bool_t error) {
+    if (batch_mode) {
+        return batch_data_read((struct conversion *) ihex, type, error);
+    }
     if (error) {
         (void) fprintf(stderr, "Checksum error on line %lu\n", line_number);
         exit(EXIT_FAILURE);
@@ -141,54 +852,97 @@ ihex_data_read (struct ihex_state *ihex,
         exit(EXIT_FAILURE);
     }
     if (type == IHEX_DATA_RECORD) {
-        unsigned long address = (unsigned long) IHEX_LINEAR_ADDRESS(ihex);
-        if (address < address_offset) {
-            if (address_offset == AUTODETECT_ADDRESS) {
-                // autodetect initial address
-                address_offset = address;
-                if (debug_enabled) {
-                    (void) fprintf(stderr, "Address offset: 0x%lx\n",
-                            address_offset);
-                }
-            } else {
-                (void) fprintf(stderr, "Address underflow on line %lu\n",
-                        line_number);
-                exit(EXIT_FAILURE);
-            }
+        swap_stage_write(&swap, (unsigned long) IHEX_LINEAR_ADDRESS(ihex),
+                         ihex->data, ihex->length);
+    } else if (type == IHEX_END_OF_FILE_RECORD) {
+        swap_stage_flush(&swap);
+        if (debug_enabled) {
+            (void) fprintf(stderr, "%llu bytes written\n", bytes_written);
         }
-        address -= address_offset;
-        if (address != file_position) {
+        end_output();
+        outfile = NULL;
+    }
+    return true;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+void
+swap_stage_output (struct swap_stage *stage,
+                   unsigned long address,
+                   const uint8_t *data,
+                   size_t count) {
+    if (address < address_offset) {
+        if (address_offset == AUTODETECT_ADDRESS) {
+            // autodetect initial address
+            address_offset = address;
             if (debug_enabled) {
-                (void) fprintf(stderr,
-                        "Seeking from 0x%lx to 0x%lx on line %lu\n",
-                        file_position, address, line_number);
+                (void) fprintf(stderr, "Address offset: 0x%lx\n",
+                        address_offset);
             }
-            if (outfile == stdout || fseek(outfile, (long) address, SEEK_SET)) {
-                if (file_position < address) {
-                    // "seek" forward in stdout by writing NUL bytes
-                    do {
-                        (void) fputc('\0', outfile);
-                    } while (++file_position < address);
-                } else {
-                    perror("fseek");
-                    exit(EXIT_FAILURE);
-                }
-            }
-            file_position = address;
-        }
-        if (!fwrite(ihex->data, ihex->length, 1, outfile)) {
-            perror("fwrite");
+        } else {
+            (void) fprintf(stderr, "Address underflow on line %lu\n",
+                    line_number);
             exit(EXIT_FAILURE);
         }
-        file_position += ihex->length;
-    } else if (type == IHEX_END_OF_FILE_RECORD) {
+    }
+    if (check_overlaps && !overlap_write(&overlaps, address, data, count,
+                                           line_number)) {
+        perror("overlaps");
+        exit(EXIT_FAILURE);
+    }
+    address -= address_offset;
+    if (address != file_position) {
         if (debug_enabled) {
-            (void) fprintf(stderr, "%lu bytes written\n", file_position);
+            (void) fprintf(stderr,
+                    "Seeking from 0x%llx to 0x%lx on line %lu\n",
+                    file_position, address, line_number);
         }
-        if (outfile != stdout) {
-            (void) fclose(outfile);
+        file_position = address;
+    }
+    write_output(address, data, count);
+    file_position += count;
+    bytes_written += count;
+    if (manifest_file &&
+        !manifest_write(&manifest, address + address_offset,
+                        data, count)) {
+        perror("manifest");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+overlap_found (struct overlap_map *map,
+               unsigned long address,
+               const uint8_t *data,
+               size_t count,
+               unsigned long previous_tag) {
+    const char *result = "not compared";
+
+    if (compare_overlaps) {
+        switch (compare_output(address - address_offset, data, count)) {
+        case 0:
+            result = "same data";
+            break;
+        case 1:
+            result = "different data";
+            ++differing_overlap_count;
+            break;
+        default:
+            // e.g., the output is not a regular file
+            compare_overlaps = false;
+            break;
         }
-        outfile = NULL;
     }
-    return true;
+    ++overlap_count;
+    overlap_bytes += count;
+    (void) fprintf(stderr, "Overlap at 0x%08lx-0x%08lx on line %lu"
+                           " (earlier on line %lu), %s\n",
+                   address, address + (unsigned long) (count - 1U),
+                   line_number, previous_tag, result);
+}
+
+void
+ring_block_output (struct ring *ring, struct ring_block *block) {
+    write_at(block->address, block->data, block->length);
 }
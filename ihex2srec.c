@@ -0,0 +1,242 @@
+/*
+ * ihex2srec.c: Convert Intel HEX to Motorola S-records.
+ *
+ * Usage: ihex2srec [-i <in.hex>] [-o <out.srec>] [-s <1|2|3>] [-b <length>]
+ *                  [-H <header>] [-v]
+ *
+ * The input is converted record by record in a single pass, without
+ * converting it to binary, i.e., gaps in the data are preserved and the
+ * conversion takes time in proportion to the data and not the address
+ * range it spans. Contiguous data is joined into full output records of
+ * the number of bytes set with the option `-b` (default 32).
+ *
+ * The option `-s` selects the data records, and thus the address width:
+ * S1 (16 bits), S2 (24 bits), or S3 (32 bits, the default). It is an
+ * error for the input to contain data at addresses that do not fit in
+ * the chosen width. The termination record matches the data records
+ * (S9, S8, or S7, respectively), and contains the start address of the
+ * input, if any, or zero. The option `-H` writes an S0 header record
+ * with the given text (e.g., the name of the file).
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#include "kk_ihex_read.h"
+#include "kk_srec_write.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+static FILE *outfile;
+static struct srec_state output;
+static unsigned long line_number = 1L;
+static unsigned long long address_limit;
+static srec_address_t start_address = 0;
+static bool end_of_file = false;
+
+// The address at which the next byte would be written without changing
+// the address
+static unsigned long long output_address = ~0ULL;
+
+int
+main (int argc, char *argv[]) {
+    struct ihex_state ihex;
+    FILE *infile = stdin;
+    uint8_t line_length = SREC_DEFAULT_OUTPUT_LINE_LENGTH;
+    srec_record_type_t record_type = SREC_DATA32_RECORD;
+    const char *header = NULL;
+    bool debug_enabled = false;
+    ihex_count_t count;
+    char buf[256];
+    char *arg = NULL;
+
+    outfile = stdout;
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'i':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(infile = fopen(*argv, "r"))) {
+                    goto argument_error;
+                }
+                break;
+            case 'o':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(outfile = fopen(*argv, "w"))) {
+                    goto argument_error;
+                }
+                break;
+            case 's':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                arg = *(++argv);
+                if (arg[0] < '1' || arg[0] > '3' || arg[1]) {
+                    goto invalid_argument;
+                }
+                record_type = (srec_record_type_t) (arg[0] - '0');
+                break;
+            case 'b': {
+                unsigned long length;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                length = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !length || length > SREC_MAX_OUTPUT_LINE_LENGTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                line_length = (uint8_t) length;
+                break;
+            }
+            case 'H':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                header = *(++argv);
+                break;
+            case 'v':
+                debug_enabled = true;
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
+                               " - Copyright (c) 2013-2026 Kimmo Kulovesi\n");
+        (void) fprintf(stderr, "Usage: ihex2srec [-i <in.hex>] [-o <out.srec>]"
+                               " [-s <1|2|3>] [-b <length>] [-H <header>] [-v]\n");
+        return arg ? EXIT_FAILURE : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_FAILURE;
+    }
+
+    address_limit = 1ULL << (SREC_ADDRESS_SIZE(record_type) * 8U);
+
+    srec_init(&output);
+    srec_set_address_width(&output, record_type);
+    srec_set_output_line_length(&output, line_length);
+    if (header) {
+        srec_write_header(&output, header, (srec_count_t) strlen(header));
+    }
+
+    ihex_begin_read(&ihex);
+    while (fgets(buf, sizeof(buf), infile)) {
+        count = (ihex_count_t) strlen(buf);
+        ihex_read_bytes(&ihex, buf, count);
+        line_number += (count && buf[count - 1] == '\n');
+    }
+    ihex_end_read(&ihex);
+    if (ferror(infile)) {
+        perror("fgets");
+        return EXIT_FAILURE;
+    }
+    if (infile != stdin) {
+        (void) fclose(infile);
+    }
+
+    if ((unsigned long long) start_address >= address_limit) {
+        (void) fprintf(stderr, "Start address 0x%08lX does not fit in S%u\n",
+                       (unsigned long) start_address, (unsigned) record_type);
+        return EXIT_FAILURE;
+    }
+    srec_end_write(&output, start_address);
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("ihex2srec");
+        return EXIT_FAILURE;
+    }
+
+    if (debug_enabled) {
+        (void) fprintf(stderr, "%lu lines read\n", line_number - 1);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+ihex_bool_t
+ihex_data_read (struct ihex_state *ihex,
+                ihex_record_type_t type,
+                ihex_bool_t error) {
+    if (error) {
+        (void) fprintf(stderr, "Checksum error on line %lu\n", line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (ihex->length < ihex->line_length) {
+        (void) fprintf(stderr, "Line length error on line %lu\n", line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (end_of_file) {
+        (void) fprintf(stderr, "Excess data after end of file record\n");
+        exit(EXIT_FAILURE);
+    }
+    switch (type) {
+    case IHEX_DATA_RECORD: {
+        const unsigned long long address = IHEX_LINEAR_ADDRESS(ihex);
+        if (!ihex->length) {
+            break;
+        }
+        if (address + ihex->length > address_limit) {
+            (void) fprintf(stderr, "Address 0x%08llX on line %lu does not fit"
+                                   " in the address width\n",
+                           address, line_number);
+            exit(EXIT_FAILURE);
+        }
+        if (address != output_address) {
+            srec_write_at_address(&output, (srec_address_t) address);
+        }
+        output_address = address + ihex->length;
+        srec_write_bytes(&output, ihex->data, ihex->length);
+        break;
+    }
+    case IHEX_END_OF_FILE_RECORD:
+        end_of_file = true;
+        break;
+    case IHEX_START_LINEAR_ADDRESS_RECORD:
+        start_address = (((srec_address_t) ihex->data[0]) << 24) |
+                        (((srec_address_t) ihex->data[1]) << 16) |
+                        (((srec_address_t) ihex->data[2]) << 8) |
+                        ((srec_address_t) ihex->data[3]);
+        break;
+    case IHEX_START_SEGMENT_ADDRESS_RECORD: {
+        const srec_address_t cs = (((srec_address_t) ihex->data[0]) << 8) | ihex->data[1];
+        const srec_address_t ip = (((srec_address_t) ihex->data[2]) << 8) | ihex->data[3];
+        start_address = (cs << 4) + ip;
+        break;
+    }
+    default:
+        // extended addresses are handled by the reader
+        break;
+    }
+    return true;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+void
+srec_flush_buffer(struct srec_state *srec, char *buffer, char *eptr) {
+    *eptr = '\0';
+    (void) fputs(buffer, outfile);
+}
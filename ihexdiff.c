@@ -0,0 +1,411 @@
+/*
+ * ihexdiff.c: Compare two Intel HEX files by address.
+ *
+ * Usage: ihexdiff [-p <patch.hex>] [-s] <old.hex> <new.hex>
+ *
+ * Either of the input files may be given as `-` to read standard input.
+ *
+ * The data of the two files is compared in address order, without
+ * converting it to binary, i.e., any address offsets and gaps in the data
+ * do not matter. The differing address ranges are listed,
+ * along with ranges that are present only in the old file ("removed") or
+ * only in the new file ("added"), followed by a summary. The exit status
+ * is 0 if the files have the same data, 1 if they differ, and 2 on error.
+ *
+ * The command-line option `-p` writes an IHEX patch file containing only
+ * the bytes of the new file that differ from, or are missing in, the old
+ * file. The option `-s` suppresses all output except errors, i.e., only
+ * the exit status tells whether the files differ.
+ *
+ * The data of each file is first collected as extents (contiguous runs of
+ * data) in a balanced tree ordered by address (see `kk_extents.h`), so the
+ * data records may be in any order, and the memory use is proportional to
+ * the amount of data, not the address space. The extents of the two files
+ * are then merged in address order. Where the data records of one file
+ * overlap, the later record is used (as in `ihex2bin`).
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#include "kk_ihex_read.h"
+#include "kk_ihex_write.h"
+#include "kk_extents.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define EXIT_DIFFERENT 1
+#define EXIT_ERROR 2
+
+enum range_type {
+    RANGE_NONE,
+    RANGE_DIFFER,
+    RANGE_REMOVED,
+    RANGE_ADDED
+};
+
+static const char * const range_names[] = { "", "differ", "removed", "added" };
+
+static struct {
+    enum range_type type;
+    unsigned long   first;
+    unsigned long   last;
+} range;
+
+static unsigned long long range_bytes[4];
+static unsigned long range_count[4];
+static bool start_address_differs = false;
+
+// The data of an input file, and the part of it not yet compared
+struct input {
+    struct extent_tree  tree;
+    const char          *name;
+    size_t              index;      // the extent being compared
+    unsigned long       address;    // the address of `data`
+    const uint8_t       *data;      // the data not yet compared
+    size_t              length;     // the length of `data`, 0 at the end
+    uint8_t             start_type; // type of the start address record
+    uint8_t             start_address[4];
+};
+
+static struct input *reading;       // the input being read
+static unsigned long line_number = 1L;
+static bool end_of_file = false;
+
+static bool silent = false;
+static FILE *patch_file = NULL;
+static struct ihex_state patch;
+static unsigned long long patch_address = ~0ULL;
+
+static void
+fatal_error (const char * const message) {
+    (void) fprintf(stderr, "%s:%lu: %s\n", reading->name, line_number, message);
+    exit(EXIT_ERROR);
+}
+
+// Read the IHEX `file` into `input`.
+//
+static void
+read_input (struct input * const input, FILE *file) {
+    struct ihex_state ihex;
+    char buf[256];
+
+    reading = input;
+    line_number = 1;
+    end_of_file = false;
+    ihex_begin_read(&ihex);
+    while (fgets(buf, sizeof(buf), file)) {
+        ihex_count_t count = (ihex_count_t) strlen(buf);
+        ihex_read_bytes(&ihex, buf, count);
+        line_number += (count && buf[count - 1] == '\n');
+    }
+    ihex_end_read(&ihex);
+    if (ferror(file)) {
+        perror(input->name);
+        exit(EXIT_ERROR);
+    }
+}
+
+// Add `count` bytes of `data` at `address` to `input`, replacing any
+// existing data at the same addresses.
+//
+static void
+add_data (struct input * const input, unsigned long address,
+          const uint8_t *data, size_t count) {
+    while (count) {
+        const size_t index = extent_find(&input->tree, address);
+        struct extent * const extent = (index != NO_EXTENT) ?
+                                       &input->tree.extents[index] : NULL;
+        size_t n;
+
+        if (extent && extent->address <= address) {
+            n = (size_t) (extent_end(extent) - address);
+            n = (n < count) ? n : count;
+            (void) memcpy(extent->data + (address - extent->address), data, n);
+        } else {
+            n = count;
+            if (extent && extent->address - address < n) {
+                n = extent->address - address;
+            }
+            if (!extent_insert(&input->tree, address, data, n)) {
+                perror("ihexdiff");
+                exit(EXIT_ERROR);
+            }
+        }
+        address += (unsigned long) n;
+        data += n;
+        count -= n;
+    }
+}
+
+// Begin comparing the data of `input` at the extent `index`.
+//
+static void
+begin_extent (struct input * const input, const size_t index) {
+    input->index = index;
+    if (index == NO_EXTENT) {
+        input->length = 0;
+        return;
+    }
+    input->address = input->tree.extents[index].address;
+    input->data = input->tree.extents[index].data;
+    input->length = input->tree.extents[index].length;
+}
+
+// Mark `count` bytes of the data of `input` as compared.
+//
+static void
+consume (struct input * const input, const size_t count) {
+    input->address += (unsigned long) count;
+    input->data += count;
+    if (!(input->length -= count)) {
+        begin_extent(input, extent_next(&input->tree, input->index));
+    }
+}
+
+static void
+end_range (void) {
+    if (range.type == RANGE_NONE) {
+        return;
+    }
+    range_bytes[range.type] += range.last - range.first + 1UL;
+    ++range_count[range.type];
+    if (!silent) {
+        (void) printf("0x%08lX-0x%08lX %s (%lu bytes)\n",
+                      range.first, range.last, range_names[range.type],
+                      range.last - range.first + 1UL);
+    }
+    range.type = RANGE_NONE;
+}
+
+static void
+add_range (const enum range_type type, const unsigned long address,
+           const size_t count) {
+    if (range.type != type || address != range.last + 1UL) {
+        end_range();
+        range.type = type;
+        range.first = address;
+    }
+    range.last = address + (unsigned long) (count - 1);
+}
+
+static void
+write_patch (const unsigned long address, const uint8_t *data, size_t count) {
+    if (!patch_file) {
+        return;
+    }
+    if (address != patch_address) {
+        ihex_write_at_address(&patch, (ihex_address_t) address);
+    }
+    patch_address = (unsigned long long) address + count;
+    (void) ihex_write_block(&patch, data, count);
+}
+
+// Compare `count` bytes at `address`, from `old_data` and `new_data`.
+//
+static void
+compare (unsigned long address, const uint8_t * restrict old_data,
+         const uint8_t * restrict new_data, size_t count) {
+    size_t i = 0;
+
+    if (!memcmp(old_data, new_data, count)) {
+        return;
+    }
+    while (i < count) {
+        size_t n;
+        while (old_data[i] == new_data[i]) {
+            ++i;
+        }
+        n = i;
+        while (++n < count && old_data[n] != new_data[n]) { }
+        n -= i;
+        add_range(RANGE_DIFFER, address + (unsigned long) i, n);
+        write_patch(address + (unsigned long) i, new_data + i, n);
+        i += n;
+        if (i < count && !memcmp(old_data + i, new_data + i, count - i)) {
+            break;
+        }
+    }
+}
+
+int
+main (int argc, char *argv[]) {
+    static struct input input[2];
+    struct input * const old_input = &input[0];
+    struct input * const new_input = &input[1];
+    FILE *file;
+    int file_count = 0;
+    int i;
+    char *arg = NULL;
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'p':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(patch_file = fopen(*argv, "w"))) {
+                    goto argument_error;
+                }
+                break;
+            case 's':
+                silent = true;
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        } else if ((arg[0] != '-' || arg[1] == '\0') && file_count < 2) {
+            input[file_count++].name = arg;
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
+                               " - Copyright (c) 2013-2026 Kimmo Kulovesi\n");
+        (void) fprintf(stderr, "Usage: ihexdiff [-p <patch.hex>] [-s]"
+                               " <old.hex> <new.hex>\n");
+        return arg ? EXIT_ERROR : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_ERROR;
+    }
+
+    if (file_count != 2) {
+        arg = "";
+        goto usage;
+    }
+
+    for (i = 0; i < 2; ++i) {
+        if (!strcmp(input[i].name, "-")) {
+            file = stdin;
+        } else if (!(file = fopen(input[i].name, "r"))) {
+            perror(input[i].name);
+            return EXIT_ERROR;
+        }
+        extent_tree_init(&input[i].tree);
+        read_input(&input[i], file);
+        if (file != stdin) {
+            (void) fclose(file);
+        }
+        begin_extent(&input[i], extent_first(&input[i].tree));
+    }
+    if (patch_file) {
+        ihex_init(&patch);
+    }
+
+    while (old_input->length || new_input->length) {
+        size_t count;
+        if (!new_input->length ||
+            (old_input->length && old_input->address < new_input->address)) {
+            // old data with no new data at the same address
+            count = old_input->length;
+            if (new_input->length &&
+                new_input->address - old_input->address < count) {
+                count = new_input->address - old_input->address;
+            }
+            add_range(RANGE_REMOVED, old_input->address, count);
+            consume(old_input, count);
+        } else if (!old_input->length || new_input->address < old_input->address) {
+            // new data with no old data at the same address
+            count = new_input->length;
+            if (old_input->length &&
+                old_input->address - new_input->address < count) {
+                count = old_input->address - new_input->address;
+            }
+            add_range(RANGE_ADDED, new_input->address, count);
+            write_patch(new_input->address, new_input->data, count);
+            consume(new_input, count);
+        } else {
+            count = (old_input->length < new_input->length) ?
+                    old_input->length : new_input->length;
+            compare(old_input->address, old_input->data, new_input->data, count);
+            consume(old_input, count);
+            consume(new_input, count);
+        }
+    }
+    end_range();
+
+    if (old_input->start_type != new_input->start_type ||
+        memcmp(old_input->start_address, new_input->start_address, 4)) {
+        start_address_differs = true;
+        if (!silent) {
+            (void) printf("Start address differs\n");
+        }
+    }
+
+    if (!silent) {
+        (void) printf("%llu bytes differ in %lu ranges, "
+                      "%llu bytes removed in %lu ranges, "
+                      "%llu bytes added in %lu ranges\n",
+                      range_bytes[RANGE_DIFFER], range_count[RANGE_DIFFER],
+                      range_bytes[RANGE_REMOVED], range_count[RANGE_REMOVED],
+                      range_bytes[RANGE_ADDED], range_count[RANGE_ADDED]);
+    }
+
+    if (patch_file) {
+        ihex_end_write(&patch);
+        if (fclose(patch_file)) {
+            perror("fclose");
+            return EXIT_ERROR;
+        }
+    }
+    for (i = 0; i < 2; ++i) {
+        extent_tree_free(&input[i].tree);
+    }
+
+    if (start_address_differs || range_count[RANGE_DIFFER] ||
+        range_count[RANGE_REMOVED] || range_count[RANGE_ADDED]) {
+        return EXIT_DIFFERENT;
+    }
+    return EXIT_SUCCESS;
+}
+
+ihex_bool_t
+ihex_data_read (struct ihex_state *ihex,
+                ihex_record_type_t type,
+                ihex_bool_t error) {
+    if (error) {
+        fatal_error("Checksum error");
+    }
+    if (ihex->length < ihex->line_length) {
+        fatal_error("Line length error");
+    }
+    if (end_of_file) {
+        // ignore anything after the end of file
+        return true;
+    }
+    if (type == IHEX_DATA_RECORD) {
+        if (ihex->length) {
+            add_data(reading, (unsigned long) IHEX_LINEAR_ADDRESS(ihex),
+                     ihex->data, ihex->length);
+        }
+    } else if (type == IHEX_END_OF_FILE_RECORD) {
+        end_of_file = true;
+    } else if (type == IHEX_START_SEGMENT_ADDRESS_RECORD ||
+               type == IHEX_START_LINEAR_ADDRESS_RECORD) {
+        reading->start_type = type;
+        (void) memcpy(reading->start_address, ihex->data, 4);
+    }
+    return true;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+void
+ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    *eptr = '\0';
+    (void) fputs(buffer, patch_file);
+}
@@ -0,0 +1,878 @@
+/*
+ * ihexgang.c: Stream an Intel HEX file to many serial ports (or pipes) at
+ * once, or receive and verify Intel HEX from many ports at once, e.g., for
+ * gang programming.
+ *
+ * Usage: ihexgang [-i <in.hex>] [-b <bytes_per_line>] [-B <baud>]
+ *                 [-t <seconds>] [-q] [-v] <port> [<port> ...]
+ *        ihexgang -r [-i <reference.hex>] [-B <baud>] [-t <seconds>]
+ *                 [-q] [-v] <port> [<port> ...]
+ *
+ * Each port is a character device (e.g., a serial port), a pipe, a FIFO,
+ * a pseudo-terminal, or a file, or `-` for standard output (sending) or
+ * standard input (receiving). Terminal devices are set to raw mode, and
+ * to the speed given with `-B`, if any.
+ *
+ * In the first form, the data of the input file is written as IHEX to
+ * every port, with `-b` data bytes per line (default 32). In the second
+ * form (`-r`), IHEX is read from every port until its end of file record,
+ * or the end of the input; if a reference file is given with `-i`, the data
+ * received must be the same as in it, at the same addresses and in the
+ * same order, along with the start address, if any.
+ *
+ * All of the ports are handled by a single thread with an event loop
+ * (epoll on Linux, otherwise poll), and each port has its own IHEX reader
+ * or writer state. The writer uses the non-blocking write mode of the
+ * library (`IHEX_NONBLOCKING_WRITE`), i.e., a slow port never blocks the
+ * others, and the reader stops at the end of file record with
+ * `ihex_pause_read`.
+ *
+ * The progress is written to standard error once per second, unless `-q`
+ * is given (`-v` adds the progress of each port), and finally one line per
+ * port is written to standard output (or standard error, if it is one of
+ * the ports) with the number of data bytes and their CRC-32. A port that
+ * has been idle for longer than the timeout given with `-t` fails. The
+ * exit status is 0 if every port succeeded, 1 if any port failed, and 2
+ * on other errors.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#if !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "kk_ihex_read.h"
+#include "kk_ihex_write.h"
+#include "kk_crc32.h"
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#define GANG_EPOLL
+#else
+#include <poll.h>
+#endif
+
+#ifndef IHEX_NONBLOCKING_WRITE
+#error "ihexgang must be built with IHEX_NONBLOCKING_WRITE (see Makefile)"
+#endif
+
+#define EXIT_FAILED 1
+#define EXIT_ERROR 2
+
+#define MAX_STREAMS 256
+#define IO_CHUNK 4096
+
+struct span {
+    unsigned long   address;
+    size_t          offset;     // in `image`
+    size_t          length;
+};
+
+struct stream {
+    struct ihex_state   ihex;   // first, so that the callbacks find the rest
+    const char          *name;
+    int                 fd;
+    int                 saved_flags;    // of standard input/output
+    bool                always_ready;   // can not be waited for (e.g., a file)
+    bool                done;
+    bool                failed;
+    bool                positioned;     // at the address of the current span
+    bool                end_of_file;    // end of file record received
+    bool                start_sent;
+    uint8_t             start_type;
+    uint8_t             start_address[4];
+    size_t              span;           // the current span of the image
+    size_t              offset;         // in the current span
+    unsigned long long  bytes;
+    uint_least32_t      crc;
+    time_t              last_activity;
+    char                error[96];
+};
+
+// The input or reference file
+static uint8_t *image = NULL;
+static size_t image_length = 0;
+static size_t image_capacity = 0;
+static struct span *spans = NULL;
+static size_t span_count = 0;
+static size_t span_capacity = 0;
+static uint8_t start_type = 0;
+static uint8_t start_address[4];
+static uint_least32_t image_crc;
+static bool loading = false;
+static bool load_error = false;
+
+static struct stream *streams = NULL;
+static unsigned stream_count = 0;
+static unsigned active_count = 0;
+static bool receive = false;
+static bool have_reference = false;
+static bool quiet = false;
+static bool verbose = false;
+static unsigned line_length = 32;
+static long timeout = 0;
+
+#ifdef GANG_EPOLL
+static int epoll_fd = -1;
+#else
+static struct pollfd *poll_fds = NULL;
+static struct stream **poll_streams = NULL;
+#endif
+
+static time_t
+now (void) {
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static double
+seconds_now (void) {
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static bool
+append_data (const unsigned long address, const uint8_t *data, const size_t length) {
+    struct span *span = span_count ? &spans[span_count - 1] : NULL;
+
+    if (image_length + length > image_capacity) {
+        size_t capacity = image_capacity ? image_capacity * 2U : 65536U;
+        uint8_t *more;
+        while (capacity < image_length + length) {
+            capacity *= 2U;
+        }
+        if (!(more = realloc(image, capacity))) {
+            return false;
+        }
+        image = more;
+        image_capacity = capacity;
+    }
+    if (!span || span->address + span->length != address) {
+        if (span_count == span_capacity) {
+            const size_t capacity = span_capacity ? span_capacity * 2U : 64U;
+            struct span *more = realloc(spans, capacity * sizeof(*spans));
+            if (!more) {
+                return false;
+            }
+            spans = more;
+            span_capacity = capacity;
+        }
+        span = &spans[span_count++];
+        span->address = address;
+        span->offset = image_length;
+        span->length = 0;
+    }
+    (void) memcpy(image + image_length, data, length);
+    image_length += length;
+    span->length += length;
+    return true;
+}
+
+// Read the input or reference file `name` into `image` and `spans`.
+//
+static bool
+load_image (const char * const name) {
+    struct ihex_state ihex;
+    char buffer[IO_CHUNK];
+    size_t count;
+    FILE *file;
+
+    if (!(file = fopen(name, "r"))) {
+        perror(name);
+        return false;
+    }
+    loading = true;
+    ihex_begin_read(&ihex);
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        (void) ihex_read_bytes(&ihex, buffer, (ihex_count_t) count);
+    }
+    ihex_end_read(&ihex);
+    loading = false;
+    if (ferror(file)) {
+        perror(name);
+        load_error = true;
+    } else if (load_error) {
+        (void) fprintf(stderr, "%s: Invalid IHEX data\n", name);
+    }
+    (void) fclose(file);
+    image_crc = crc32_final(crc32_update(CRC32_INITIAL, image, image_length));
+    return !load_error;
+}
+
+static void
+stream_fail (struct stream * const s, const char * const format, ...) {
+    va_list args;
+    if (s->failed) {
+        return;
+    }
+    s->failed = true;
+    va_start(args, format);
+    (void) vsnprintf(s->error, sizeof(s->error), format, args);
+    va_end(args);
+}
+
+static bool
+set_terminal (const int fd, const long baud) {
+    struct termios tio;
+    speed_t speed;
+
+    switch (baud) {
+    case 0: speed = B0; break;
+    case 1200: speed = B1200; break;
+    case 2400: speed = B2400; break;
+    case 4800: speed = B4800; break;
+    case 9600: speed = B9600; break;
+    case 19200: speed = B19200; break;
+    case 38400: speed = B38400; break;
+#ifdef B57600
+    case 57600: speed = B57600; break;
+#endif
+#ifdef B115200
+    case 115200: speed = B115200; break;
+#endif
+#ifdef B230400
+    case 230400: speed = B230400; break;
+#endif
+#ifdef B460800
+    case 460800: speed = B460800; break;
+#endif
+#ifdef B921600
+    case 921600: speed = B921600; break;
+#endif
+    default:
+        errno = EINVAL;
+        return false;
+    }
+    if (!isatty(fd)) {
+        return true;
+    }
+    if (tcgetattr(fd, &tio)) {
+        return false;
+    }
+    // raw 8-bit data
+    tio.c_iflag &= ~(tcflag_t) (IGNBRK | BRKINT | PARMRK | ISTRIP |
+                                INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    tio.c_oflag &= ~(tcflag_t) OPOST;
+    tio.c_lflag &= ~(tcflag_t) (ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(tcflag_t) (CSIZE | PARENB);
+    tio.c_cflag |= CS8 | CREAD | CLOCAL;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (baud && (cfsetispeed(&tio, speed) || cfsetospeed(&tio, speed))) {
+        return false;
+    }
+    return !tcsetattr(fd, TCSANOW, &tio);
+}
+
+static bool
+open_stream (struct stream * const s, const long baud) {
+    int flags;
+
+    if (!strcmp(s->name, "-")) {
+        s->fd = receive ? STDIN_FILENO : STDOUT_FILENO;
+    } else if (receive) {
+        s->fd = open(s->name, O_RDONLY | O_NOCTTY);
+    } else {
+        s->fd = open(s->name, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0666);
+    }
+    if (s->fd < 0 || (flags = fcntl(s->fd, F_GETFL)) == -1) {
+        return false;
+    }
+    s->saved_flags = flags;
+    if (fcntl(s->fd, F_SETFL, flags | O_NONBLOCK) == -1 || !set_terminal(s->fd, baud)) {
+        return false;
+    }
+#ifdef GANG_EPOLL
+    {
+        struct epoll_event event;
+        event.events = receive ? EPOLLIN : EPOLLOUT;
+        event.data.ptr = s;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s->fd, &event)) {
+            if (errno != EPERM) {
+                return false;
+            }
+            // regular files can not be polled, but are always ready
+            s->always_ready = true;
+        }
+    }
+#endif
+    if (receive) {
+        ihex_begin_read(&s->ihex);
+    } else {
+        ihex_init(&s->ihex);
+        ihex_set_output_line_length(&s->ihex, (uint8_t) line_length);
+    }
+    s->crc = CRC32_INITIAL;
+    s->last_activity = now();
+    ++active_count;
+    return true;
+}
+
+static void
+close_stream (struct stream * const s) {
+    if (s->done) {
+        return;
+    }
+    s->done = true;
+    --active_count;
+#ifdef GANG_EPOLL
+    if (!s->always_ready) {
+        (void) epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+    }
+#endif
+    if (s->fd == STDIN_FILENO || s->fd == STDOUT_FILENO) {
+        (void) fcntl(s->fd, F_SETFL, s->saved_flags);
+    } else if (close(s->fd) && !s->failed) {
+        stream_fail(s, "%s", strerror(errno));
+    }
+    s->crc = crc32_final(s->crc);
+}
+
+// Write as much as possible to `s` without blocking.
+//
+static void
+send_stream (struct stream * const s) {
+    while (!s->failed) {
+        if (s->span < span_count) {
+            const struct span * const span = &spans[s->span];
+            size_t count = span->length - s->offset;
+            ihex_count_t accepted;
+
+            if (!s->positioned) {
+                if (!ihex_write_at_address(&s->ihex, (ihex_address_t) span->address)) {
+                    return;
+                }
+                s->positioned = true;
+            }
+            count = (count < IO_CHUNK) ? count : IO_CHUNK;
+            accepted = ihex_write_bytes(&s->ihex, image + span->offset + s->offset,
+                                        (ihex_count_t) count);
+            s->crc = crc32_update(s->crc, image + span->offset + s->offset,
+                                  (size_t) accepted);
+            s->bytes += (unsigned long long) accepted;
+            s->offset += (size_t) accepted;
+            if (s->offset == span->length) {
+                ++(s->span);
+                s->offset = 0;
+                s->positioned = false;
+            }
+            if ((size_t) accepted < count || count == IO_CHUNK) {
+                // blocked, or give the other streams a turn
+                return;
+            }
+        } else if (start_type && !s->start_sent) {
+            const uint8_t * const a = start_address;
+            ihex_bool_t written;
+#ifndef IHEX_DISABLE_SEGMENTS
+            if (start_type == IHEX_START_SEGMENT_ADDRESS_RECORD) {
+                written = ihex_write_start_segment_address(&s->ihex,
+                              (ihex_segment_t) ((a[0] << 8) | a[1]),
+                              (uint_least16_t) ((a[2] << 8) | a[3]));
+            } else
+#endif
+            {
+                written = ihex_write_start_address(&s->ihex,
+                              ((ihex_address_t) a[0] << 24) | ((ihex_address_t) a[1] << 16) |
+                              ((ihex_address_t) a[2] << 8) | (ihex_address_t) a[3]);
+            }
+            if (!written) {
+                return;
+            }
+            s->start_sent = true;
+        } else {
+            if (ihex_end_write(&s->ihex)) {
+                close_stream(s);
+            }
+            return;
+        }
+    }
+}
+
+ihex_count_t
+ihex_flush_buffer (struct ihex_state *ihex, char *buffer, char *eptr) {
+    struct stream * const s = (struct stream *) ihex;
+    ssize_t count;
+
+    if (s->failed) {
+        // discard the rest
+        return (ihex_count_t) (eptr - buffer);
+    }
+    do {
+        count = write(s->fd, buffer, (size_t) (eptr - buffer));
+    } while (count < 0 && errno == EINTR);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        stream_fail(s, "%s", strerror(errno));
+        return (ihex_count_t) (eptr - buffer);
+    }
+    if (count) {
+        s->last_activity = now();
+    }
+    return (ihex_count_t) count;
+}
+
+// Compare the data received by `s` to the reference.
+//
+static void
+verify_data (struct stream * const s, unsigned long address,
+             const uint8_t *data, size_t length) {
+    while (length) {
+        const struct span *span;
+        const uint8_t *expected;
+        size_t count;
+
+        if (s->span == span_count) {
+            stream_fail(s, "extra data at 0x%08lX", address);
+            return;
+        }
+        span = &spans[s->span];
+        if (address != span->address + s->offset) {
+            stream_fail(s, "expected data at 0x%08lX, received at 0x%08lX",
+                        span->address + s->offset, address);
+            return;
+        }
+        count = span->length - s->offset;
+        count = (count < length) ? count : length;
+        expected = image + span->offset + s->offset;
+        if (memcmp(expected, data, count)) {
+            while (*expected == *data) {
+                ++expected;
+                ++data;
+                ++address;
+            }
+            stream_fail(s, "data differs at 0x%08lX", address);
+            return;
+        }
+        s->offset += count;
+        if (s->offset == span->length) {
+            ++(s->span);
+            s->offset = 0;
+        }
+        address += count;
+        data += count;
+        length -= count;
+    }
+}
+
+// Check the end of the data received by `s`.
+//
+static void
+end_receive (struct stream * const s) {
+    if (!s->end_of_file) {
+        stream_fail(s, "no end of file record");
+    } else if (have_reference) {
+        if (s->span != span_count) {
+            stream_fail(s, "missing data from 0x%08lX",
+                        spans[s->span].address + s->offset);
+        } else if (start_type != s->start_type ||
+                   (start_type && memcmp(start_address, s->start_address, 4))) {
+            stream_fail(s, "start address differs");
+        }
+    }
+    close_stream(s);
+}
+
+// Read what is available from `s` without blocking.
+//
+static void
+receive_stream (struct stream * const s) {
+    char buffer[IO_CHUNK];
+    ssize_t count;
+
+    do {
+        count = read(s->fd, buffer, sizeof(buffer));
+    } while (count < 0 && errno == EINTR);
+    if (count < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            stream_fail(s, "%s", strerror(errno));
+            close_stream(s);
+        }
+        return;
+    }
+    if (count == 0) {
+        // end of input
+        ihex_end_read(&s->ihex);
+        end_receive(s);
+        return;
+    }
+    s->last_activity = now();
+    (void) ihex_read_bytes(&s->ihex, buffer, (ihex_count_t) count);
+    if (s->failed || s->end_of_file) {
+        // anything after the end of file record is ignored
+        end_receive(s);
+    }
+}
+
+ihex_bool_t
+ihex_data_read (struct ihex_state *ihex,
+                ihex_record_type_t type,
+                ihex_bool_t checksum_error) {
+    struct stream * const s = (struct stream *) ihex;
+
+    if (checksum_error || ihex->length < ihex->line_length) {
+        if (loading) {
+            load_error = true;
+        } else {
+            stream_fail(s, "invalid record at 0x%08lX",
+                        (unsigned long) IHEX_LINEAR_ADDRESS(ihex));
+            ihex_pause_read(ihex);
+        }
+        return false;
+    }
+    if (type == IHEX_DATA_RECORD) {
+        const unsigned long address = (unsigned long) IHEX_LINEAR_ADDRESS(ihex);
+        if (loading) {
+            if (!append_data(address, ihex->data, ihex->length)) {
+                perror("realloc");
+                exit(EXIT_ERROR);
+            }
+            return true;
+        }
+        s->crc = crc32_update(s->crc, ihex->data, ihex->length);
+        s->bytes += ihex->length;
+        if (have_reference) {
+            verify_data(s, address, ihex->data, ihex->length);
+        }
+    } else if (type == IHEX_START_SEGMENT_ADDRESS_RECORD ||
+               type == IHEX_START_LINEAR_ADDRESS_RECORD) {
+        if (ihex->length != 4) {
+            return true;
+        }
+        if (loading) {
+            start_type = type;
+            (void) memcpy(start_address, ihex->data, 4);
+        } else {
+            s->start_type = type;
+            (void) memcpy(s->start_address, ihex->data, 4);
+        }
+    } else if (type == IHEX_END_OF_FILE_RECORD && !loading) {
+        s->end_of_file = true;
+        ihex_pause_read(ihex);
+    }
+    if (!loading && s->failed) {
+        ihex_pause_read(ihex);
+    }
+    return true;
+}
+
+// Wait up to `timeout_ms` for streams to become ready, and store them in
+// `ready`, returns their number or -1 on error.
+//
+static int
+wait_for_streams (struct stream **ready, int timeout_ms) {
+    int count = 0;
+    unsigned i;
+
+    for (i = 0; i < stream_count; ++i) {
+        if (!streams[i].done && streams[i].always_ready) {
+            ready[count++] = &streams[i];
+        }
+    }
+    if (count) {
+        timeout_ms = 0;
+    }
+#ifdef GANG_EPOLL
+    {
+        struct epoll_event events[MAX_STREAMS];
+        int n = epoll_wait(epoll_fd, events, MAX_STREAMS, timeout_ms);
+        if (n < 0) {
+            return (errno == EINTR) ? count : -1;
+        }
+        for (i = 0; i < (unsigned) n; ++i) {
+            ready[count++] = events[i].data.ptr;
+        }
+    }
+#else
+    {
+        nfds_t n = 0;
+        int result;
+        for (i = 0; i < stream_count; ++i) {
+            struct stream * const s = &streams[i];
+            if (!s->done && !s->always_ready) {
+                poll_fds[n].fd = s->fd;
+                poll_fds[n].events = receive ? POLLIN : POLLOUT;
+                poll_fds[n].revents = 0;
+                poll_streams[n++] = s;
+            }
+        }
+        if ((result = poll(poll_fds, n, timeout_ms)) < 0) {
+            return (errno == EINTR) ? count : -1;
+        }
+        for (i = 0; result > 0 && i < (unsigned) n; ++i) {
+            if (poll_fds[i].revents) {
+                ready[count++] = poll_streams[i];
+                --result;
+            }
+        }
+    }
+#endif
+    return count;
+}
+
+static void
+print_progress (const double elapsed, const unsigned long long bytes,
+                const unsigned long long previous_bytes) {
+    const unsigned long long total = (unsigned long long) image_length * stream_count;
+    unsigned i;
+
+    (void) fprintf(stderr, "%u/%u done, %llu", stream_count - active_count,
+                   stream_count, bytes);
+    if (!receive || have_reference) {
+        (void) fprintf(stderr, "/%llu bytes (%.0f%%)", total,
+                       total ? (double) bytes * 100.0 / (double) total : 100.0);
+    } else {
+        (void) fprintf(stderr, " bytes");
+    }
+    (void) fprintf(stderr, ", %.1f kB/s\n",
+                   (double) (bytes - previous_bytes) / 1000.0 / elapsed);
+    if (verbose) {
+        for (i = 0; i < stream_count; ++i) {
+            const struct stream * const s = &streams[i];
+            (void) fprintf(stderr, "  %s: %llu bytes%s\n", s->name, s->bytes,
+                           s->failed ? ", failed" : (s->done ? ", done" : ""));
+        }
+    }
+}
+
+int
+main (int argc, char *argv[]) {
+    static struct stream *ready[MAX_STREAMS];
+    const char *input_name = NULL;
+    const char **names;
+    FILE *report = stdout;
+    long baud = 0;
+    unsigned long long previous_bytes = 0;
+    double previous_time;
+    unsigned failed_count = 0;
+    unsigned i;
+    char *arg = NULL;
+
+    if (!(names = calloc((size_t) argc + 1U, sizeof(*names)))) {
+        perror("calloc");
+        return EXIT_ERROR;
+    }
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'i':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                input_name = *(++argv);
+                break;
+            case 'r':
+                receive = true;
+                break;
+            case 'b':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                line_length = (unsigned) strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !line_length || line_length > 255) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'B':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                baud = strtol(*argv, &arg, 10);
+                if (errno || arg == *argv || baud <= 0) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 't':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                timeout = strtol(*argv, &arg, 10);
+                if (errno || arg == *argv || timeout < 0) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        } else if ((arg[0] != '-' || arg[1] == '\0') && stream_count < MAX_STREAMS) {
+            names[stream_count++] = arg;
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
+                               " - Copyright (c) 2013-2026 Kimmo Kulovesi\n");
+        (void) fprintf(stderr, "Usage: ihexgang [-i <in.hex>] [-b <bytes_per_line>]"
+                               " [-B <baud>] [-t <seconds>]\n"
+                               "                [-q] [-v] <port> [<port> ...]\n"
+                               "       ihexgang -r [-i <reference.hex>] [-B <baud>]"
+                               " [-t <seconds>]\n"
+                               "                [-q] [-v] <port> [<port> ...]\n");
+        return arg ? EXIT_ERROR : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_ERROR;
+    }
+
+    if (!stream_count || (!receive && !input_name)) {
+        arg = "";
+        goto usage;
+    }
+    if (input_name) {
+        if (!load_image(input_name)) {
+            return EXIT_ERROR;
+        }
+        have_reference = receive;
+    }
+
+    // a closed pipe fails only its own stream
+    (void) signal(SIGPIPE, SIG_IGN);
+#ifdef GANG_EPOLL
+    if ((epoll_fd = epoll_create1(0)) < 0) {
+        perror("epoll_create1");
+        return EXIT_ERROR;
+    }
+#else
+    poll_fds = calloc(stream_count, sizeof(*poll_fds));
+    poll_streams = calloc(stream_count, sizeof(*poll_streams));
+    if (!poll_fds || !poll_streams) {
+        perror("calloc");
+        return EXIT_ERROR;
+    }
+#endif
+    if (!(streams = calloc(stream_count, sizeof(*streams)))) {
+        perror("calloc");
+        return EXIT_ERROR;
+    }
+    for (i = 0; i < stream_count; ++i) {
+        streams[i].name = names[i];
+        if (!receive && !strcmp(names[i], "-")) {
+            // standard output is one of the ports
+            report = stderr;
+        }
+        if (!open_stream(&streams[i], baud)) {
+            perror(names[i]);
+            return EXIT_ERROR;
+        }
+    }
+
+    previous_time = seconds_now();
+    while (active_count) {
+        const int timed = (!quiet || timeout);
+        int count = wait_for_streams(ready, timed ? 1000 : -1);
+        double current_time;
+        int n;
+
+        if (count < 0) {
+            perror("wait");
+            return EXIT_ERROR;
+        }
+        for (n = 0; n < count; ++n) {
+            struct stream * const s = ready[n];
+            if (s->done) {
+                continue;
+            }
+            if (receive) {
+                receive_stream(s);
+            } else {
+                send_stream(s);
+            }
+            if (s->failed) {
+                close_stream(s);
+            }
+        }
+
+        if (!timed) {
+            continue;
+        }
+        current_time = seconds_now();
+        if (current_time - previous_time < 1.0) {
+            continue;
+        }
+        if (timeout) {
+            const time_t idle_since = now() - (time_t) timeout;
+            for (i = 0; i < stream_count; ++i) {
+                struct stream * const s = &streams[i];
+                if (!s->done && s->last_activity < idle_since) {
+                    stream_fail(s, "timed out");
+                    close_stream(s);
+                }
+            }
+        }
+        if (!quiet) {
+            unsigned long long bytes = 0;
+            for (i = 0; i < stream_count; ++i) {
+                bytes += streams[i].bytes;
+            }
+            print_progress(current_time - previous_time, bytes, previous_bytes);
+            previous_bytes = bytes;
+        }
+        previous_time = current_time;
+    }
+
+    for (i = 0; i < stream_count; ++i) {
+        const struct stream * const s = &streams[i];
+        (void) fprintf(report, "%s: %s %llu bytes, CRC-32 0x%08lX", s->name,
+                       receive ? "received" : "sent", s->bytes,
+                       (unsigned long) s->crc);
+        if (s->failed) {
+            (void) fprintf(report, ", FAILED: %s\n", s->error);
+            ++failed_count;
+        } else {
+            (void) fputs(have_reference ? ", OK\n" : "\n", report);
+        }
+    }
+    if (input_name && !quiet) {
+        (void) fprintf(stderr, "%s: %lu bytes, CRC-32 0x%08lX\n", input_name,
+                       (unsigned long) image_length, (unsigned long) image_crc);
+    }
+    free(streams);
+    free(names);
+    free(image);
+    free(spans);
+    if (fflush(report)) {
+        perror("stdout");
+        return EXIT_ERROR;
+    }
+    return failed_count ? EXIT_FAILED : EXIT_SUCCESS;
+}
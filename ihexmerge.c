@@ -0,0 +1,395 @@
+/*
+ * ihexmerge.c: Merge multiple Intel HEX files into one.
+ *
+ * Usage: ihexmerge [-o <out.hex>] [-b <length>] [-p <policy>] [-v]
+ *                  <in1.hex> <in2.hex> ...
+ *
+ * The data of all input files is combined into a single IHEX output,
+ * e.g., to create a production image from a bootloader, an application
+ * and calibration data. The output is written in ascending address order
+ * with the line length given with `-b`, preserving any gaps in the data.
+ *
+ * The option `-p` selects what happens when the inputs overlap, i.e.,
+ * specify data for the same address:
+ *      error       - report the overlaps and fail (the default)
+ *      first       - the data from the earlier input is kept
+ *      last        - the data from the later input is kept
+ *      identical   - the data must be identical, otherwise fail
+ * The start address of the output is taken from the first input that has
+ * one (or the last with policy `last`); conflicting start addresses cause
+ * a warning.
+ *
+ * The data is kept in memory as extents (contiguous runs of data) in a
+ * balanced tree ordered by address (see `kk_extents.h`). Hence the memory
+ * use is proportional to the amount of data, not the address space, and
+ * overlaps are found in logarithmic time, so inputs in any order take time
+ * proportional to their size (times the logarithm of the record count).
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#include "kk_ihex_read.h"
+#include "kk_ihex_write.h"
+#include "kk_extents.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define WRITE_CHUNK_SIZE 65536UL
+
+enum overlap_policy {
+    OVERLAP_ERROR,
+    OVERLAP_FIRST,
+    OVERLAP_LAST,
+    OVERLAP_IDENTICAL
+};
+
+static const char * const policy_names[] = {
+    "error", "first", "last", "identical", NULL
+};
+
+// The data of all inputs merged so far
+static struct extent_tree tree;
+
+static enum overlap_policy policy = OVERLAP_ERROR;
+static bool overlap_error = false;
+static bool debug_enabled = false;
+
+static const char *input_name = "-";
+static unsigned long line_number = 1L;
+static bool end_of_file = false;
+
+static uint8_t start_type = 0;
+static uint8_t start_address[4];
+
+static FILE *outfile;
+
+static const char overlapping_data[] = "Overlapping data";
+static const char overlapping_data_differs[] = "Overlapping data differs";
+
+static void
+out_of_memory (void) {
+    perror("ihexmerge");
+    exit(EXIT_FAILURE);
+}
+
+// Overlaps are reported as ranges, coalescing consecutive records
+static struct {
+    const char      *problem;
+    unsigned long   line_number;
+    unsigned long   first;
+    unsigned long   last;
+} overlap;
+
+static void
+end_overlap (void) {
+    if (overlap.problem) {
+        (void) fprintf(stderr, "%s:%lu: %s at 0x%08lX-0x%08lX\n",
+                       input_name, overlap.line_number, overlap.problem,
+                       overlap.first, overlap.last);
+        overlap.problem = NULL;
+    }
+}
+
+static void
+report_overlap (const unsigned long address, const size_t count,
+                const char * const problem) {
+    if (overlap.problem != problem || address != overlap.last + 1UL) {
+        end_overlap();
+        overlap.problem = problem;
+        overlap.line_number = line_number;
+        overlap.first = address;
+    }
+    overlap.last = address + (unsigned long) (count - 1);
+    overlap_error = true;
+}
+
+// Add `count` bytes of `data` at `address`, resolving any overlaps with
+// the existing data according to `policy`.
+//
+static void
+add_data (unsigned long address, const uint8_t *data, size_t count) {
+    while (count) {
+        const size_t index = extent_find(&tree, address);
+        struct extent * const extent = (index != NO_EXTENT) ? &tree.extents[index] : NULL;
+        size_t n;
+
+        if (extent && extent->address <= address) {
+            // overlap with existing data
+            uint8_t * const old_data = extent->data + (address - extent->address);
+            n = (size_t) (extent_end(extent) - address);
+            n = (n < count) ? n : count;
+            switch (policy) {
+            case OVERLAP_ERROR:
+                report_overlap(address, n, overlapping_data);
+                break;
+            case OVERLAP_FIRST:
+                break;
+            case OVERLAP_LAST:
+                (void) memcpy(old_data, data, n);
+                break;
+            case OVERLAP_IDENTICAL:
+                if (memcmp(old_data, data, n)) {
+                    report_overlap(address, n, overlapping_data_differs);
+                }
+                break;
+            }
+        } else {
+            // gap in existing data
+            n = count;
+            if (extent && extent->address - address < n) {
+                n = extent->address - address;
+            }
+            if (!extent_insert(&tree, address, data, n)) {
+                out_of_memory();
+            }
+        }
+
+        address += (unsigned long) n;
+        data += n;
+        count -= n;
+    }
+}
+
+// Write the extents in ascending order of address. Adjacent extents are
+// continued on the same lines.
+//
+static void
+write_extents (struct ihex_state * const ihex) {
+    unsigned long long next_address = ~0ULL;
+    size_t index;
+
+    for (index = extent_first(&tree); index != NO_EXTENT;
+         index = extent_next(&tree, index)) {
+        const struct extent * const extent = &tree.extents[index];
+        size_t offset;
+        if (extent->address != next_address) {
+            ihex_write_at_address(ihex, (ihex_address_t) extent->address);
+        }
+        for (offset = 0; offset < extent->length; offset += WRITE_CHUNK_SIZE) {
+            size_t n = extent->length - offset;
+            n = (n < WRITE_CHUNK_SIZE) ? n : WRITE_CHUNK_SIZE;
+            ihex_write_bytes(ihex, extent->data + offset, (ihex_count_t) n);
+        }
+        next_address = extent_end(extent);
+    }
+}
+
+static void
+read_input (FILE *infile) {
+    struct ihex_state ihex;
+    char buf[256];
+
+    line_number = 1;
+    end_of_file = false;
+    ihex_begin_read(&ihex);
+    while (fgets(buf, sizeof(buf), infile)) {
+        ihex_count_t count = (ihex_count_t) strlen(buf);
+        ihex_read_bytes(&ihex, buf, count);
+        line_number += (count && buf[count - 1] == '\n');
+    }
+    ihex_end_read(&ihex);
+    end_overlap();
+    if (ferror(infile)) {
+        perror(input_name);
+        exit(EXIT_FAILURE);
+    }
+}
+
+int
+main (int argc, char *argv[]) {
+    struct ihex_state ihex;
+    uint8_t line_length = IHEX_DEFAULT_OUTPUT_LINE_LENGTH;
+    char **inputs = NULL;
+    int input_count = 0;
+    size_t i;
+    char *arg = NULL;
+
+    outfile = stdout;
+    extent_tree_init(&tree);
+
+    if (!(inputs = calloc((size_t) argc, sizeof(*inputs)))) {
+        out_of_memory();
+    }
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'o':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(outfile = fopen(*argv, "w"))) {
+                    goto argument_error;
+                }
+                break;
+            case 'b': {
+                unsigned long length;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                length = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !length || length > IHEX_MAX_OUTPUT_LINE_LENGTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                line_length = (uint8_t) length;
+                break;
+            }
+            case 'p': {
+                int p;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                arg = *(++argv);
+                for (p = 0; policy_names[p] && strcmp(arg, policy_names[p]); ++p) { }
+                if (!policy_names[p]) {
+                    goto invalid_argument;
+                }
+                policy = (enum overlap_policy) p;
+                break;
+            }
+            case 'v':
+                debug_enabled = true;
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        } else if (arg[0] != '-' || arg[1] == '\0') {
+            inputs[input_count++] = arg;
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
+                               " - Copyright (c) 2013-2026 Kimmo Kulovesi\n");
+        (void) fprintf(stderr, "Usage: ihexmerge [-o <out.hex>] [-b <length>]"
+                               " [-p error|first|last|identical] [-v]\n"
+                               "                 <in1.hex> <in2.hex> ...\n");
+        return arg ? EXIT_FAILURE : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_FAILURE;
+    }
+
+    if (!input_count) {
+        arg = "";
+        goto usage;
+    }
+
+    for (i = 0; i < (size_t) input_count; ++i) {
+        FILE *infile = stdin;
+        input_name = inputs[i];
+        if (strcmp(input_name, "-") && !(infile = fopen(input_name, "r"))) {
+            perror(input_name);
+            return EXIT_FAILURE;
+        }
+        read_input(infile);
+        if (infile != stdin) {
+            (void) fclose(infile);
+        }
+        if (debug_enabled) {
+            (void) fprintf(stderr, "%s: %lu extents after merging\n",
+                           input_name, (unsigned long) tree.count);
+        }
+    }
+    free(inputs);
+
+    if (overlap_error) {
+        (void) fprintf(stderr, "Overlapping inputs, no output written "
+                               "(see option -p)\n");
+        return EXIT_FAILURE;
+    }
+
+    ihex_init(&ihex);
+    ihex_set_output_line_length(&ihex, line_length);
+    write_extents(&ihex);
+    if (start_type == IHEX_START_LINEAR_ADDRESS_RECORD) {
+        ihex_write_start_address(&ihex,
+                                 (((ihex_address_t) start_address[0]) << 24) |
+                                 (((ihex_address_t) start_address[1]) << 16) |
+                                 (((ihex_address_t) start_address[2]) << 8) |
+                                 ((ihex_address_t) start_address[3]));
+#ifndef IHEX_DISABLE_SEGMENTS
+    } else if (start_type == IHEX_START_SEGMENT_ADDRESS_RECORD) {
+        ihex_write_start_segment_address(&ihex,
+                                 (ihex_segment_t) ((start_address[0] << 8) | start_address[1]),
+                                 (uint_least16_t) ((start_address[2] << 8) | start_address[3]));
+#endif
+    }
+    ihex_end_write(&ihex);
+
+    if (debug_enabled) {
+        (void) fprintf(stderr, "%lu extents written\n", (unsigned long) tree.count);
+    }
+    extent_tree_free(&tree);
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("ihexmerge");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+ihex_bool_t
+ihex_data_read (struct ihex_state *ihex,
+                ihex_record_type_t type,
+                ihex_bool_t error) {
+    if (error) {
+        (void) fprintf(stderr, "%s:%lu: Checksum error\n", input_name, line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (ihex->length < ihex->line_length) {
+        (void) fprintf(stderr, "%s:%lu: Line length error\n", input_name, line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (end_of_file) {
+        (void) fprintf(stderr, "%s:%lu: Excess data after end of file record\n",
+                       input_name, line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (type == IHEX_DATA_RECORD) {
+        if (ihex->length) {
+            add_data((unsigned long) IHEX_LINEAR_ADDRESS(ihex),
+                     ihex->data, ihex->length);
+        }
+    } else if (type == IHEX_END_OF_FILE_RECORD) {
+        end_of_file = true;
+    } else if (type == IHEX_START_SEGMENT_ADDRESS_RECORD ||
+               type == IHEX_START_LINEAR_ADDRESS_RECORD) {
+        if (start_type && (start_type != type ||
+                           memcmp(start_address, ihex->data, 4))) {
+            (void) fprintf(stderr, "%s:%lu: Warning: conflicting start address"
+                                   " (%s one is used)\n",
+                           input_name, line_number,
+                           (policy == OVERLAP_LAST) ? "the last" : "the first");
+        }
+        if (!start_type || policy == OVERLAP_LAST) {
+            start_type = type;
+            (void) memcpy(start_address, ihex->data, 4);
+        }
+    }
+    return true;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+void
+ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    *eptr = '\0';
+    (void) fputs(buffer, outfile);
+}
@@ -0,0 +1,292 @@
+/*
+ * ihexreflow.c: Rewrite Intel HEX with a different record layout.
+ *
+ * Usage: ihexreflow [-i <in.hex>] [-o <out.hex>] [-b <length>]
+ *                   [-n <alignment>] [-l] [-v]
+ *
+ * The input is read and written back out in a single pass, without
+ * converting it to binary, i.e., gaps in the data are preserved as is.
+ * The option `-b` sets the number of data bytes per output line (default
+ * 32), and `-n` makes every record start at a multiple of the given
+ * alignment in the address space, e.g., `-b 16 -n 16` writes records of
+ * 16 bytes all aligned to 16-byte boundaries, regardless of how the input
+ * was split into records.
+ *
+ * Segmented addressing (extended segment address records and start
+ * segment address records) is preserved by default, but the option `-l`
+ * converts them to the equivalent linear addresses, i.e., extended linear
+ * address records and a start linear address record.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#include "kk_ihex_read.h"
+#include "kk_ihex_write.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+static FILE *outfile;
+static struct ihex_state output;
+static unsigned long line_number = 1L;
+static unsigned long alignment = 0;
+static bool linearize = false;
+static bool end_of_file = false;
+
+// The address (and segment) at which the next byte would be written
+// without changing the address
+static unsigned long long output_address = ~0ULL;
+#ifndef IHEX_DISABLE_SEGMENTS
+static ihex_segment_t output_segment = 0;
+#endif
+
+int
+main (int argc, char *argv[]) {
+    struct ihex_state ihex;
+    FILE *infile = stdin;
+    uint8_t line_length = IHEX_DEFAULT_OUTPUT_LINE_LENGTH;
+    bool debug_enabled = false;
+    ihex_count_t count;
+    char buf[256];
+    char *arg = NULL;
+
+    outfile = stdout;
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'i':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(infile = fopen(*argv, "r"))) {
+                    goto argument_error;
+                }
+                break;
+            case 'o':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(outfile = fopen(*argv, "w"))) {
+                    goto argument_error;
+                }
+                break;
+            case 'b': {
+                unsigned long length;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                length = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !length || length > IHEX_MAX_OUTPUT_LINE_LENGTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                line_length = (uint8_t) length;
+                break;
+            }
+            case 'n':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                alignment = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                break;
+            case 'l':
+                linearize = true;
+                break;
+            case 'v':
+                debug_enabled = true;
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
+                               " - Copyright (c) 2013-2026 Kimmo Kulovesi\n");
+        (void) fprintf(stderr, "Usage: ihexreflow [-i <in.hex>] [-o <out.hex>]"
+                               " [-b <length>] [-n <alignment>] [-l] [-v]\n");
+        return arg ? EXIT_FAILURE : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_FAILURE;
+    }
+
+#ifdef IHEX_DISABLE_SEGMENTS
+    linearize = true;
+#endif
+
+    ihex_init(&output);
+    ihex_set_output_line_length(&output, line_length);
+
+    ihex_begin_read(&ihex);
+    while (fgets(buf, sizeof(buf), infile)) {
+        count = (ihex_count_t) strlen(buf);
+        ihex_read_bytes(&ihex, buf, count);
+        line_number += (count && buf[count - 1] == '\n');
+    }
+    ihex_end_read(&ihex);
+    if (ferror(infile)) {
+        perror("fgets");
+        return EXIT_FAILURE;
+    }
+    if (infile != stdin) {
+        (void) fclose(infile);
+    }
+
+    ihex_end_write(&output);
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("ihexreflow");
+        return EXIT_FAILURE;
+    }
+
+    if (debug_enabled) {
+        (void) fprintf(stderr, "%lu lines read\n", line_number - 1);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// Start a new output record at `address` (which includes the high 16 bits
+// of a linear address, but not the segment).
+//
+static void
+write_at (const ihex_address_t address) {
+#ifndef IHEX_DISABLE_SEGMENTS
+    if (!linearize) {
+        if (!output_segment) {
+            ihex_write_at_segment(&output, output_segment, address);
+            return;
+        }
+        // Within a segment the address is a 16-bit offset, so keep the
+        // writer from following a record that ended at 64 KiB with an
+        // extended linear address record.
+        ihex_write_at_segment(&output, output_segment, address & 0xFFFFU);
+        output.flags &= ~IHEX_FLAG_ADDRESS_OVERFLOW;
+        return;
+    }
+#endif
+    ihex_write_at_address(&output, address);
+}
+
+// Write `count` bytes of `data` at `address`, breaking records at every
+// multiple of `alignment`.
+//
+static void
+write_data (ihex_address_t address, const uint8_t *data, uint_fast8_t count) {
+    if ((unsigned long long) address != output_address) {
+        write_at(address);
+    }
+    output_address = (unsigned long long) address + count;
+
+    while (alignment) {
+        const unsigned long boundary = alignment - ((unsigned long) address % alignment);
+        uint_fast8_t n;
+        if (boundary >= count) {
+            if (boundary == count) {
+                // end exactly at a boundary, the next byte begins a new record
+                output_address = ~0ULL;
+            }
+            break;
+        }
+        n = (uint_fast8_t) boundary;
+        ihex_write_bytes(&output, data, n);
+        data += n;
+        count -= n;
+        address += n;
+        write_at(address);
+    }
+    ihex_write_bytes(&output, data, count);
+}
+
+ihex_bool_t
+ihex_data_read (struct ihex_state *ihex,
+                ihex_record_type_t type,
+                ihex_bool_t error) {
+    if (error) {
+        (void) fprintf(stderr, "Checksum error on line %lu\n", line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (ihex->length < ihex->line_length) {
+        (void) fprintf(stderr, "Line length error on line %lu\n", line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (end_of_file) {
+        (void) fprintf(stderr, "Excess data after end of file record\n");
+        exit(EXIT_FAILURE);
+    }
+    switch (type) {
+    case IHEX_DATA_RECORD:
+        if (!ihex->length) {
+            break;
+        }
+#ifndef IHEX_DISABLE_SEGMENTS
+        if (!linearize) {
+            if (ihex->segment != output_segment) {
+                output_segment = ihex->segment;
+                output_address = ~0ULL;
+            }
+            write_data(ihex->address, ihex->data, ihex->length);
+            break;
+        }
+#endif
+        write_data(IHEX_LINEAR_ADDRESS(ihex), ihex->data, ihex->length);
+        break;
+    case IHEX_END_OF_FILE_RECORD:
+        end_of_file = true;
+        break;
+    case IHEX_START_LINEAR_ADDRESS_RECORD:
+        ihex_write_start_address(&output,
+                                 (((ihex_address_t) ihex->data[0]) << 24) |
+                                 (((ihex_address_t) ihex->data[1]) << 16) |
+                                 (((ihex_address_t) ihex->data[2]) << 8) |
+                                 ((ihex_address_t) ihex->data[3]));
+        break;
+    case IHEX_START_SEGMENT_ADDRESS_RECORD: {
+        const ihex_address_t cs = (((ihex_address_t) ihex->data[0]) << 8) | ihex->data[1];
+        const ihex_address_t ip = (((ihex_address_t) ihex->data[2]) << 8) | ihex->data[3];
+#ifndef IHEX_DISABLE_SEGMENTS
+        if (!linearize) {
+            ihex_write_start_segment_address(&output, (ihex_segment_t) cs,
+                                             (uint_least16_t) ip);
+            break;
+        }
+#endif
+        ihex_write_start_address(&output, (cs << 4) + ip);
+        break;
+    }
+    default:
+        // extended addresses are handled by the reader and the writer
+        break;
+    }
+    return true;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+void
+ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    *eptr = '\0';
+    (void) fputs(buffer, outfile);
+}
@@ -0,0 +1,479 @@
+/*
+ * kk_aio.c: Asynchronous block I/O using Linux io_uring.
+ *
+ * See the header `kk_aio.h` for instructions. The io_uring interface is
+ * used directly through system calls, i.e., liburing is not needed.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#if !defined(_GNU_SOURCE) && defined(__linux__)
+#define _GNU_SOURCE
+#endif
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "kk_aio.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__) && defined(__GNUC__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define AIO_IO_URING
+#endif
+#endif
+
+enum aio_state {
+    AIO_FREE,
+    AIO_READING,    // read in flight
+    AIO_READ,       // read complete, not yet consumed
+    AIO_CONSUMING,  // returned by `aio_read_next`
+    AIO_FILLING,    // returned by `aio_write_buffer`
+    AIO_WRITING     // write in flight
+};
+
+#ifdef AIO_IO_URING
+
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+struct aio_ring {
+    int                 fd;
+    bool                fixed;  // buffers are registered
+    void                *sq_ptr;
+    void                *cq_ptr;
+    size_t              sq_size;
+    size_t              cq_size;
+    struct io_uring_sqe *sqes;
+    size_t              sqes_size;
+    unsigned            *sq_tail;
+    unsigned            *sq_mask;
+    unsigned            *sq_array;
+    unsigned            *cq_head;
+    unsigned            *cq_tail;
+    unsigned            *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+static int
+io_uring_setup (const unsigned entries, struct io_uring_params *params) {
+    return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int
+io_uring_enter (const int fd, const unsigned to_submit,
+                const unsigned min_complete, const unsigned flags) {
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                         flags, NULL, 0);
+}
+
+static int
+io_uring_register (const int fd, const unsigned opcode,
+                   const void *arg, const unsigned count) {
+    return (int) syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+static void
+aio_ring_free (struct aio_ring * const ring) {
+    if (ring->sqes && ring->sqes != MAP_FAILED) {
+        (void) munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ptr && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr) {
+        (void) munmap(ring->cq_ptr, ring->cq_size);
+    }
+    if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED) {
+        (void) munmap(ring->sq_ptr, ring->sq_size);
+    }
+    if (ring->fd >= 0) {
+        (void) close(ring->fd);
+    }
+    free(ring);
+}
+
+static struct aio_ring *
+aio_ring_init (const unsigned entries) {
+    struct io_uring_params params;
+    struct aio_ring *ring = calloc(1, sizeof(*ring));
+    if (!ring) {
+        return NULL;
+    }
+    (void) memset(&params, 0, sizeof(params));
+    if ((ring->fd = io_uring_setup(entries, &params)) < 0) {
+        free(ring);
+        return NULL;
+    }
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size) {
+            ring->sq_size = ring->cq_size;
+        }
+        ring->cq_size = ring->sq_size;
+    }
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        aio_ring_free(ring);
+        return NULL;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            aio_ring_free(ring);
+            return NULL;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        aio_ring_free(ring);
+        return NULL;
+    }
+    ring->sq_tail = (unsigned *) ((char *) ring->sq_ptr + params.sq_off.tail);
+    ring->sq_mask = (unsigned *) ((char *) ring->sq_ptr + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *) ((char *) ring->sq_ptr + params.sq_off.array);
+    ring->cq_head = (unsigned *) ((char *) ring->cq_ptr + params.cq_off.head);
+    ring->cq_tail = (unsigned *) ((char *) ring->cq_ptr + params.cq_off.tail);
+    ring->cq_mask = (unsigned *) ((char *) ring->cq_ptr + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) ((char *) ring->cq_ptr + params.cq_off.cqes);
+    return ring;
+}
+
+static void
+aio_set_error (struct aio * const aio, const int error) {
+    if (!aio->error) {
+        aio->error = error ? error : EIO;
+    }
+}
+
+// Submit the operation for the remaining part of buffer `index`.
+//
+static void
+aio_submit (struct aio * const aio, const unsigned index) {
+    struct aio_ring * const ring = aio->ring;
+    const unsigned tail = *ring->sq_tail;
+    const unsigned slot = tail & *ring->sq_mask;
+    struct io_uring_sqe * const sqe = &ring->sqes[slot];
+    const bool write = (aio->state[index] == AIO_WRITING);
+    const size_t done = aio->done[index];
+
+    (void) memset(sqe, 0, sizeof(*sqe));
+    if (ring->fixed) {
+        sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->buf_index = (uint16_t) index;
+    } else {
+        sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    sqe->fd = aio->fd;
+    sqe->addr = (uint64_t) (uintptr_t) (aio->buffers + index * AIO_BLOCK_SIZE + done);
+    sqe->len = (uint32_t) (aio->length[index] - done);
+    sqe->off = aio->position[index] + done;
+    sqe->user_data = index;
+    ring->sq_array[slot] = slot;
+    __atomic_store_n(ring->sq_tail, tail + 1U, __ATOMIC_RELEASE);
+
+    while (io_uring_enter(ring->fd, 1, 0, 0) < 0) {
+        if (errno != EINTR && errno != EAGAIN) {
+            aio_set_error(aio, errno);
+            aio->state[index] = AIO_FREE;
+            // the entry remains queued, but is not waited for
+            return;
+        }
+    }
+    ++aio->in_flight;
+}
+
+// Handle completed operations, waiting for at least one if `wait` is set.
+//
+static void
+aio_reap (struct aio * const aio, const bool wait) {
+    struct aio_ring * const ring = aio->ring;
+    unsigned head = *ring->cq_head;
+
+    if (wait && head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        while (io_uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+            if (errno != EINTR) {
+                aio_set_error(aio, errno);
+                aio->in_flight = 0;
+                return;
+            }
+        }
+    }
+    while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        const struct io_uring_cqe * const cqe = &ring->cqes[head & *ring->cq_mask];
+        const unsigned index = (unsigned) cqe->user_data;
+        const int result = cqe->res;
+        ++head;
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+        --aio->in_flight;
+
+        if (result < 0) {
+            if (result == -EINTR || result == -EAGAIN) {
+                aio_submit(aio, index);
+                continue;
+            }
+            aio_set_error(aio, -result);
+            aio->state[index] = (aio->state[index] == AIO_READING) ? AIO_READ : AIO_FREE;
+            continue;
+        }
+        aio->done[index] += (size_t) result;
+        if (result == 0 || aio->done[index] == aio->length[index]) {
+            if (aio->state[index] == AIO_READING) {
+                aio->state[index] = AIO_READ;
+            } else {
+                if (result == 0 && aio->done[index] != aio->length[index]) {
+                    aio_set_error(aio, EIO);
+                }
+                aio->state[index] = AIO_FREE;
+            }
+        } else {
+            // short transfer, continue with the rest
+            aio_submit(aio, index);
+        }
+    }
+}
+
+int
+aio_file (FILE *file, const bool write, unsigned long long *offset) {
+    struct stat st;
+    off_t position;
+    int flags;
+    const int fd = fileno(file);
+
+    if (fd < 0 || (write && fflush(file)) || fstat(fd, &st) ||
+        !(S_ISREG(st.st_mode) || S_ISBLK(st.st_mode))) {
+        return -1;
+    }
+    if ((flags = fcntl(fd, F_GETFL)) < 0 || (flags & O_APPEND)) {
+        return -1;
+    }
+    if ((position = ftello(file)) < 0) {
+        return -1;
+    }
+    *offset = (unsigned long long) position;
+    return fd;
+}
+
+bool
+aio_init (struct aio * const aio, const int fd, unsigned depth) {
+    struct iovec iov[AIO_MAX_DEPTH];
+    unsigned i;
+
+    if (depth > AIO_MAX_DEPTH) {
+        depth = AIO_MAX_DEPTH;
+    } else if (!depth) {
+        depth = AIO_DEFAULT_DEPTH;
+    }
+    (void) memset(aio, 0, sizeof(*aio));
+    aio->fd = fd;
+    aio->depth = depth;
+    if (!(aio->buffers = malloc(depth * AIO_BLOCK_SIZE))) {
+        return false;
+    }
+    if (!(aio->ring = aio_ring_init(depth))) {
+        const int error = errno;
+        free(aio->buffers);
+        aio->buffers = NULL;
+        errno = error;
+        return false;
+    }
+    for (i = 0; i < depth; ++i) {
+        iov[i].iov_base = aio->buffers + i * AIO_BLOCK_SIZE;
+        iov[i].iov_len = AIO_BLOCK_SIZE;
+    }
+    // registration may fail due to the limit of locked memory, in which
+    // case the buffers are passed with every operation instead
+    aio->ring->fixed = !io_uring_register(aio->ring->fd, IORING_REGISTER_BUFFERS,
+                                          iov, depth);
+    return true;
+}
+
+void
+aio_free (struct aio * const aio) {
+    if (aio->ring) {
+        aio_ring_free(aio->ring);
+        aio->ring = NULL;
+    }
+    free(aio->buffers);
+    aio->buffers = NULL;
+}
+
+// Submit a read of the next block of the file into buffer `index`.
+//
+static void
+aio_submit_read (struct aio * const aio, const unsigned index) {
+    aio->position[index] = aio->offset;
+    aio->length[index] = AIO_BLOCK_SIZE;
+    aio->done[index] = 0;
+    aio->state[index] = AIO_READING;
+    aio->offset += AIO_BLOCK_SIZE;
+    aio_submit(aio, index);
+}
+
+bool
+aio_begin_read (struct aio * const aio, const unsigned long long offset) {
+    unsigned i;
+    aio->offset = offset;
+    aio->next = 0;
+    aio->end_of_file = false;
+    for (i = 0; i < aio->depth && !aio->error; ++i) {
+        aio_submit_read(aio, i);
+    }
+    return !aio->error;
+}
+
+size_t
+aio_read_next (struct aio * const aio, const uint8_t **data) {
+    const unsigned previous = (aio->next + aio->depth - 1U) % aio->depth;
+    unsigned index;
+
+    if (aio->state[previous] == AIO_CONSUMING) {
+        // the previous block has been processed, reuse its buffer
+        if (aio->end_of_file || aio->error) {
+            aio->state[previous] = AIO_FREE;
+        } else {
+            aio_submit_read(aio, previous);
+        }
+    }
+    if (aio->end_of_file || aio->error) {
+        return 0;
+    }
+    index = aio->next;
+    while (aio->state[index] == AIO_READING && !aio->error) {
+        aio_reap(aio, true);
+    }
+    if (aio->error || aio->state[index] != AIO_READ) {
+        return 0;
+    }
+    if (aio->done[index] < aio->length[index]) {
+        // a short block is the last one
+        aio->end_of_file = true;
+    }
+    aio->state[index] = AIO_CONSUMING;
+    aio->next = (index + 1U) % aio->depth;
+    *data = aio->buffers + index * AIO_BLOCK_SIZE;
+    return aio->done[index];
+}
+
+uint8_t *
+aio_write_buffer (struct aio * const aio) {
+    for (;;) {
+        unsigned i;
+        if (aio->error) {
+            return NULL;
+        }
+        for (i = 0; i < aio->depth; ++i) {
+            if (aio->state[i] == AIO_FREE) {
+                aio->state[i] = AIO_FILLING;
+                aio->next = i;
+                return aio->buffers + i * AIO_BLOCK_SIZE;
+            }
+        }
+        aio_reap(aio, true);
+    }
+}
+
+void
+aio_write_submit (struct aio * const aio, const unsigned long long offset,
+                  const size_t length) {
+    const unsigned index = aio->next;
+    if (aio->state[index] != AIO_FILLING) {
+        return;
+    }
+    if (!length) {
+        aio->state[index] = AIO_FREE;
+        return;
+    }
+    aio->position[index] = offset;
+    aio->length[index] = length;
+    aio->done[index] = 0;
+    aio->state[index] = AIO_WRITING;
+    aio_submit(aio, index);
+    // collect any completions without waiting
+    aio_reap(aio, false);
+}
+
+bool
+aio_end (struct aio * const aio) {
+    while (aio->in_flight) {
+        aio_reap(aio, true);
+    }
+    if (aio->error) {
+        errno = aio->error;
+        return false;
+    }
+    return true;
+}
+
+#else // !AIO_IO_URING
+
+int
+aio_file (FILE *file, const bool write, unsigned long long *offset) {
+    (void) file;
+    (void) write;
+    (void) offset;
+    return -1;
+}
+
+bool
+aio_init (struct aio * const aio, const int fd, const unsigned depth) {
+    (void) fd;
+    (void) depth;
+    (void) memset(aio, 0, sizeof(*aio));
+    errno = ENOSYS;
+    return false;
+}
+
+void
+aio_free (struct aio * const aio) {
+    (void) aio;
+}
+
+bool
+aio_begin_read (struct aio * const aio, const unsigned long long offset) {
+    (void) aio;
+    (void) offset;
+    return false;
+}
+
+size_t
+aio_read_next (struct aio * const aio, const uint8_t **data) {
+    (void) aio;
+    (void) data;
+    return 0;
+}
+
+uint8_t *
+aio_write_buffer (struct aio * const aio) {
+    (void) aio;
+    return NULL;
+}
+
+void
+aio_write_submit (struct aio * const aio, const unsigned long long offset,
+                  const size_t length) {
+    (void) aio;
+    (void) offset;
+    (void) length;
+}
+
+bool
+aio_end (struct aio * const aio) {
+    (void) aio;
+    return false;
+}
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * kk_aio.h: Asynchronous block I/O on a file descriptor using Linux
+ * io_uring, for the command-line tools.
+ *
+ * A `struct aio` has `depth` buffers of `AIO_BLOCK_SIZE` bytes, which are
+ * registered with the kernel once so that they need not be mapped for
+ * every operation. For reading, all of the buffers are kept in flight,
+ * reading consecutive blocks of the file, and the blocks are returned in
+ * order by `aio_read_next`. For writing, each buffer is filled by the
+ * caller and submitted as a positioned write with `aio_write_submit`; the
+ * writes may complete in any order, so data need not be written in order
+ * of its offset.
+ *
+ * The sequence to read a file is:
+ *      struct aio aio;
+ *      const uint8_t *data;
+ *      size_t length;
+ *      if (aio_init(&aio, fd, AIO_DEFAULT_DEPTH) && aio_begin_read(&aio, 0)) {
+ *          while ((length = aio_read_next(&aio, &data))) {
+ *              process(data, length);
+ *          }
+ *          error = !aio_end(&aio);
+ *          aio_free(&aio);
+ *      }
+ *
+ * The sequence to write a file is:
+ *      uint8_t *buffer = aio_write_buffer(&aio);
+ *      // fill up to AIO_BLOCK_SIZE bytes of buffer
+ *      aio_write_submit(&aio, offset, length); // repeat both as needed
+ *      error = !aio_end(&aio);
+ *
+ * The file must be seekable (i.e., a regular file or a block device), as
+ * all operations are positioned. On other systems, or if io_uring is not
+ * available (e.g., an old kernel or disabled by a security policy),
+ * `aio_init` fails, and the caller should use ordinary I/O instead.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_AIO_H
+#define KK_AIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define AIO_BLOCK_SIZE (128UL * 1024UL)
+#define AIO_DEFAULT_DEPTH 8
+#define AIO_MAX_DEPTH 32
+
+struct aio_ring;
+
+typedef struct aio {
+    struct aio_ring     *ring;
+    uint8_t             *buffers;
+    int                 fd;
+    int                 error;      // errno of the first error, or 0
+    unsigned            depth;
+    unsigned            in_flight;
+    unsigned            next;       // the next buffer in order
+    bool                end_of_file;
+    unsigned long long  offset;     // the offset of the next read
+    unsigned long long  position[AIO_MAX_DEPTH];
+    size_t              length[AIO_MAX_DEPTH];
+    size_t              done[AIO_MAX_DEPTH];
+    uint8_t             state[AIO_MAX_DEPTH];
+} kk_aio_t;
+
+// Returns the file descriptor of `file` if it can be used with `aio`, i.e.,
+// it is seekable and not in append mode, or -1 otherwise. The current
+// position of `file` is stored in `*offset`. If `write` is set, any
+// buffered output of `file` is flushed first.
+int aio_file(FILE *file, bool write, unsigned long long *offset);
+
+// Initialise `aio` with `depth` buffers (at most `AIO_MAX_DEPTH`) for I/O
+// on the file descriptor `fd`. Returns false, with `errno` set, if io_uring
+// is not available.
+bool aio_init(struct aio *aio, int fd, unsigned depth);
+
+// Free the resources of `aio` (after `aio_end`)
+void aio_free(struct aio *aio);
+
+// Begin reading the file from `offset`, returns false on error
+bool aio_begin_read(struct aio *aio, unsigned long long offset);
+
+// Return the length of the next block of the file read, and set `*data`
+// to point to it. The data remains valid until the next call. Returns 0
+// at the end of the file or on error (see `aio->error`).
+size_t aio_read_next(struct aio *aio, const uint8_t **data);
+
+// Return a free buffer of `AIO_BLOCK_SIZE` bytes to fill with data to
+// write, waiting for an earlier write to complete if necessary, or NULL
+// on error (see `aio->error`)
+uint8_t *aio_write_buffer(struct aio *aio);
+
+// Write the first `length` bytes of the buffer returned by the previous
+// call to `aio_write_buffer` at `offset` of the file
+void aio_write_submit(struct aio *aio, unsigned long long offset, size_t length);
+
+// Wait for all operations to complete, returns false if any failed (with
+// `errno` set to that of the first error)
+bool aio_end(struct aio *aio);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_AIO_H
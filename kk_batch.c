@@ -0,0 +1,316 @@
+/*
+ * kk_batch.c: Run a batch of file conversions on a pool of threads.
+ *
+ * See the header `kk_batch.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#if !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "kk_batch.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__unix__) || defined(__APPLE__)) && defined(__GNUC__)
+#include <pthread.h>
+#include <unistd.h>
+#define BATCH_THREADS
+#endif
+
+// The jobs of a worker are the indices `head` to `tail - 1` of `jobs`.
+struct batch_queue {
+    struct batch    *batch;
+    unsigned        index;
+    unsigned        head;
+    unsigned        tail;
+#ifdef BATCH_THREADS
+    pthread_mutex_t mutex;
+    pthread_t       thread;
+    bool            running;
+#endif
+};
+
+void
+batch_init (struct batch * const batch) {
+    batch->jobs = NULL;
+    batch->queues = NULL;
+    batch->count = 0;
+    batch->capacity = 0;
+    batch->workers = 0;
+    batch->failed = 0;
+    batch->steals = 0;
+}
+
+static char *
+batch_copy_name (const char *name) {
+    const size_t length = strlen(name) + 1;
+    char * const copy = malloc(length);
+    if (copy) {
+        (void) memcpy(copy, name, length);
+    }
+    return copy;
+}
+
+bool
+batch_add (struct batch * const batch, const char *input, const char *output) {
+    struct batch_job *job;
+
+    if (batch->count == batch->capacity) {
+        const unsigned capacity = batch->capacity ? batch->capacity * 2U : 64U;
+        struct batch_job * const jobs = realloc(batch->jobs,
+                                                capacity * sizeof(*jobs));
+        if (!jobs) {
+            return false;
+        }
+        batch->jobs = jobs;
+        batch->capacity = capacity;
+    }
+    job = &batch->jobs[batch->count];
+    job->input = batch_copy_name(input);
+    job->output = batch_copy_name(output);
+    if (!job->input || !job->output) {
+        free(job->input);
+        free(job->output);
+        return false;
+    }
+    job->bytes_read = 0;
+    job->bytes_written = 0;
+    job->worker = 0;
+    job->failed = false;
+    job->error[0] = '\0';
+    ++batch->count;
+    return true;
+}
+
+bool
+batch_read_list (struct batch * const batch, FILE *file) {
+    char line[4096];
+
+    while (fgets(line, sizeof(line), file)) {
+        char *name[3] = { NULL, NULL, NULL };
+        char *s = line;
+        unsigned count = 0;
+
+        while (count < 3) {
+            while (isspace((unsigned char) *s)) {
+                ++s;
+            }
+            if (!*s || (*s == '#' && !count)) {
+                break;
+            }
+            name[count++] = s;
+            while (*s && !isspace((unsigned char) *s)) {
+                ++s;
+            }
+            if (*s) {
+                *s++ = '\0';
+            }
+        }
+        if (!count) {
+            continue;
+        }
+        if (count != 2) {
+            errno = EINVAL;
+            return false;
+        }
+        if (!batch_add(batch, name[0], name[1])) {
+            return false;
+        }
+    }
+    return !ferror(file);
+}
+
+void
+batch_fail (struct batch_job * const job, const char *format, ...) {
+    va_list args;
+
+    if (job->failed) {
+        return;
+    }
+    job->failed = true;
+    va_start(args, format);
+    (void) vsnprintf(job->error, sizeof(job->error), format, args);
+    va_end(args);
+}
+
+#ifdef BATCH_THREADS
+
+#define INCREMENT(x) ((void) __atomic_add_fetch(&(x), 1U, __ATOMIC_SEQ_CST))
+
+// Take the next job for the worker of `queue` into `*job`, stealing from
+// the other workers if its own queue is empty. Returns false when there
+// are no jobs left in any queue.
+//
+static bool
+batch_take (struct batch_queue * const queue, unsigned *job) {
+    struct batch * const batch = queue->batch;
+    unsigned i;
+
+    (void) pthread_mutex_lock(&queue->mutex);
+    if (queue->head != queue->tail) {
+        *job = queue->head++;
+        (void) pthread_mutex_unlock(&queue->mutex);
+        return true;
+    }
+    (void) pthread_mutex_unlock(&queue->mutex);
+
+    for (i = 1; i < batch->workers; ++i) {
+        struct batch_queue * const victim =
+            &batch->queues[(queue->index + i) % batch->workers];
+        unsigned first, last;
+
+        // steal the back half (rounded up) of the victim's jobs
+        (void) pthread_mutex_lock(&victim->mutex);
+        last = victim->tail;
+        first = last - (last - victim->head + 1U) / 2U;
+        victim->tail = first;
+        (void) pthread_mutex_unlock(&victim->mutex);
+
+        if (first != last) {
+            (void) pthread_mutex_lock(&queue->mutex);
+            queue->head = first + 1U;
+            queue->tail = last;
+            (void) pthread_mutex_unlock(&queue->mutex);
+            INCREMENT(batch->steals);
+            *job = first;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *
+batch_worker (void *argument) {
+    struct batch_queue * const queue = (struct batch_queue *) argument;
+    unsigned job;
+
+    while (batch_take(queue, &job)) {
+        queue->batch->jobs[job].worker = queue->index;
+        batch_job_run(queue->batch, &queue->batch->jobs[job], queue->index);
+    }
+    return NULL;
+}
+
+bool
+batch_run (struct batch * const batch, unsigned workers) {
+    unsigned i;
+
+    if (!workers) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = (online > 0) ? (unsigned) online : 1U;
+    }
+    if (workers > batch->count) {
+        workers = batch->count ? batch->count : 1U;
+    }
+    if (workers > BATCH_MAX_WORKERS) {
+        workers = BATCH_MAX_WORKERS;
+    }
+    if (!(batch->queues = malloc(workers * sizeof(*batch->queues)))) {
+        return false;
+    }
+    batch->workers = workers;
+
+    for (i = 0; i < workers; ++i) {
+        struct batch_queue * const queue = &batch->queues[i];
+        queue->batch = batch;
+        queue->index = i;
+        queue->head = (unsigned) ((unsigned long long) batch->count * i / workers);
+        queue->tail = (unsigned) ((unsigned long long) batch->count * (i + 1U) / workers);
+        queue->running = false;
+        if (pthread_mutex_init(&queue->mutex, NULL)) {
+            while (i--) {
+                (void) pthread_mutex_destroy(&batch->queues[i].mutex);
+            }
+            free(batch->queues);
+            batch->queues = NULL;
+            return false;
+        }
+    }
+
+    // the calling thread is worker 0; if some threads can not be started,
+    // their jobs are stolen by the others
+    for (i = 1; i < workers; ++i) {
+        struct batch_queue * const queue = &batch->queues[i];
+        queue->running = !pthread_create(&queue->thread, NULL,
+                                         batch_worker, queue);
+    }
+    (void) batch_worker(&batch->queues[0]);
+    for (i = 1; i < workers; ++i) {
+        if (batch->queues[i].running) {
+            (void) pthread_join(batch->queues[i].thread, NULL);
+        }
+    }
+    for (i = 0; i < workers; ++i) {
+        (void) pthread_mutex_destroy(&batch->queues[i].mutex);
+    }
+
+    batch->failed = 0;
+    for (i = 0; i < batch->count; ++i) {
+        batch->failed += batch->jobs[i].failed;
+    }
+    return true;
+}
+
+#else // !BATCH_THREADS
+
+bool
+batch_run (struct batch * const batch, const unsigned workers) {
+    unsigned i;
+
+    (void) workers;
+    batch->workers = 1;
+    batch->failed = 0;
+    for (i = 0; i < batch->count; ++i) {
+        batch_job_run(batch, &batch->jobs[i], 0);
+        batch->failed += batch->jobs[i].failed;
+    }
+    return true;
+}
+
+#endif // BATCH_THREADS
+
+void
+batch_report (const struct batch * const batch, FILE *file) {
+    unsigned long long bytes_read = 0;
+    unsigned long long bytes_written = 0;
+    unsigned i;
+
+    for (i = 0; i < batch->count; ++i) {
+        const struct batch_job * const job = &batch->jobs[i];
+        if (job->failed) {
+            (void) fprintf(file, "FAIL %s -> %s: %s\n",
+                           job->input, job->output, job->error);
+        } else {
+            (void) fprintf(file, "OK   %s -> %s (%llu bytes read, %llu written)\n",
+                           job->input, job->output,
+                           job->bytes_read, job->bytes_written);
+        }
+        bytes_read += job->bytes_read;
+        bytes_written += job->bytes_written;
+    }
+    (void) fprintf(file, "%u files, %u failed, %llu bytes read, %llu written"
+                         " (%u workers, %lu steals)\n",
+                   batch->count, batch->failed, bytes_read, bytes_written,
+                   batch->workers, batch->steals);
+}
+
+void
+batch_free (struct batch * const batch) {
+    unsigned i;
+
+    for (i = 0; i < batch->count; ++i) {
+        free(batch->jobs[i].input);
+        free(batch->jobs[i].output);
+    }
+    free(batch->jobs);
+    free(batch->queues);
+    batch_init(batch);
+}
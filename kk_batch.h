@@ -0,0 +1,103 @@
+/*
+ * kk_batch.h: Run a batch of file conversions (input and output file
+ * pairs) in one process on a pool of worker threads, e.g., to convert
+ * thousands of small files without starting a process for each.
+ *
+ * The jobs are divided evenly between the workers up front, and each
+ * worker takes jobs from the front of its own queue. A worker that runs
+ * out of jobs steals the back half of the queue of another worker, so
+ * the load stays balanced even if the files differ greatly in size.
+ *
+ * Each job is passed to `batch_job_run`, which is provided by the caller
+ * and must only use state of its own (e.g., a `struct ihex_state` on its
+ * stack), since jobs run concurrently. A failure is recorded in the job
+ * with `batch_fail`, and does not affect the other jobs.
+ *
+ * The sequence to run a batch is:
+ *      struct batch batch;
+ *      batch_init(&batch);
+ *      batch_add(&batch, "a.hex", "a.bin"); // and/or batch_read_list
+ *      batch_run(&batch, 0);
+ *      batch_report(&batch, stdout);
+ *      batch_free(&batch);
+ *
+ * Threads are supported on POSIX systems with a GCC-compatible compiler;
+ * elsewhere the jobs are run one at a time in the calling thread.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_BATCH_H
+#define KK_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define BATCH_ERROR_LENGTH 128
+#define BATCH_MAX_WORKERS 256
+
+typedef struct batch_job {
+    char                *input;
+    char                *output;
+    unsigned long long  bytes_read;
+    unsigned long long  bytes_written;
+    unsigned            worker;     // index of the worker that ran the job
+    bool                failed;
+    char                error[BATCH_ERROR_LENGTH];
+} kk_batch_job_t;
+
+struct batch_queue;
+
+typedef struct batch {
+    struct batch_job    *jobs;
+    struct batch_queue  *queues;
+    unsigned            count;
+    unsigned            capacity;
+    unsigned            workers;
+    unsigned            failed;     // number of failed jobs after the run
+    unsigned long       steals;     // number of times work was stolen
+} kk_batch_t;
+
+// Initialise an empty `batch`
+void batch_init(struct batch *batch);
+
+// Add a job to convert `input` to `output` (the names are copied),
+// returns false on error (out of memory)
+bool batch_add(struct batch *batch, const char *input, const char *output);
+
+// Add the jobs listed in `file`, one pair of input and output file names
+// separated by whitespace per line; empty lines and lines beginning with
+// `#` are ignored. Returns false on error, with `errno` set (`EINVAL` if
+// a line does not have exactly two names).
+bool batch_read_list(struct batch *batch, FILE *file);
+
+// Run all jobs of `batch` on `workers` threads (0 for the number of
+// processors online), returns false if the workers could not be started
+bool batch_run(struct batch *batch, unsigned workers);
+
+// Mark `job` as failed with an error message (only the first is kept)
+void batch_fail(struct batch_job *job, const char *format, ...);
+
+// Write the status of each job of `batch` and the totals to `file`
+void batch_report(const struct batch *batch, FILE *file);
+
+// Free the memory of `batch`
+void batch_free(struct batch *batch);
+
+// Called by a worker of `batch` to run `job`. The implementation is
+// NOT provided by this library. It may be called concurrently from
+// several threads (with different jobs), and `worker` is the index of the
+// calling worker.
+extern void batch_job_run(struct batch *batch, struct batch_job *job,
+                          unsigned worker);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_BATCH_H
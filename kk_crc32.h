@@ -0,0 +1,32 @@
+/*
+ * kk_crc32.h: CRC-32 (IEEE 802.3, as used by zip, gzip, PNG, etc.)
+ * for checksumming image data in the utilities.
+ *
+ * The CRC of a complete buffer is obtained as follows:
+ *      uint_least32_t crc = crc32_update(CRC32_INITIAL, data, length);
+ *      crc = crc32_final(crc);
+ *
+ * The function `crc32_update` may be called any number of times to pass
+ * the data in parts.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_CRC32_H
+#define KK_CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC32_INITIAL ((uint_least32_t) 0xFFFFFFFFUL)
+
+#define crc32_final(crc) ((uint_least32_t) ((crc) ^ 0xFFFFFFFFUL))
+
+// Update `crc` with `length` bytes from `data`
+uint_least32_t crc32_update(uint_least32_t crc,
+                            const void *data,
+                            size_t length);
+
+#endif // !KK_CRC32_H
@@ -0,0 +1,218 @@
+/*
+ * kk_extents.c: Data kept in memory as extents in a balanced tree.
+ *
+ * See the header `kk_extents.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_extents.h"
+#include <stdlib.h>
+#include <string.h>
+
+void
+extent_tree_init (struct extent_tree * const tree) {
+    tree->extents = NULL;
+    tree->count = 0;
+    tree->capacity = 0;
+    tree->root = NO_EXTENT;
+    tree->last = NO_EXTENT;
+}
+
+void
+extent_tree_free (struct extent_tree * const tree) {
+    size_t i;
+    for (i = 0; i < tree->count; ++i) {
+        free(tree->extents[i].data);
+    }
+    free(tree->extents);
+    extent_tree_init(tree);
+}
+
+// Append `count` bytes from `data` to the end of `extent`, returns false
+// if memory could not be allocated.
+//
+static bool
+extent_append (struct extent * const extent, const uint8_t *data,
+               const size_t count) {
+    if (extent->capacity - extent->length < count) {
+        size_t capacity = extent->capacity ? extent->capacity : 256;
+        uint8_t *p;
+        while (capacity - extent->length < count) {
+            capacity *= 2;
+        }
+        if (!(p = realloc(extent->data, capacity))) {
+            return false;
+        }
+        extent->data = p;
+        extent->capacity = capacity;
+    }
+    (void) memcpy(extent->data + extent->length, data, count);
+    extent->length += count;
+    return true;
+}
+
+size_t
+extent_find (const struct extent_tree * const tree, const unsigned long address) {
+    const struct extent * const extents = tree->extents;
+    size_t index = tree->root;
+    size_t found = NO_EXTENT;
+    if (tree->last == NO_EXTENT || extent_end(&extents[tree->last]) <= address) {
+        // fast path for appending
+        return NO_EXTENT;
+    }
+    while (index != NO_EXTENT) {
+        if (extent_end(&extents[index]) > address) {
+            found = index;
+            index = extents[index].left;
+        } else {
+            index = extents[index].right;
+        }
+    }
+    return found;
+}
+
+size_t
+extent_first (const struct extent_tree * const tree) {
+    size_t index = tree->root;
+    if (index != NO_EXTENT) {
+        while (tree->extents[index].left != NO_EXTENT) {
+            index = tree->extents[index].left;
+        }
+    }
+    return index;
+}
+
+size_t
+extent_next (const struct extent_tree * const tree, const size_t index) {
+    const unsigned long long end = extent_end(&tree->extents[index]);
+    // the extents do not overlap, so the next one is the first to end
+    // after this one ends (the end of the address space has no next)
+    if (end > (unsigned long long) (unsigned long) ~0UL) {
+        return NO_EXTENT;
+    }
+    return extent_find(tree, (unsigned long) end);
+}
+
+// Return the index of the extent that ends at `address`, or `NO_EXTENT`.
+//
+static size_t
+find_extent_ending_at (const struct extent_tree * const tree,
+                       const unsigned long address) {
+    const struct extent * const extents = tree->extents;
+    size_t index = tree->root;
+    if (tree->last != NO_EXTENT && extent_end(&extents[tree->last]) == address) {
+        return tree->last;
+    }
+    while (index != NO_EXTENT) {
+        const unsigned long long end = extent_end(&extents[index]);
+        if (end == address) {
+            return index;
+        }
+        index = (end < address) ? extents[index].right : extents[index].left;
+    }
+    return NO_EXTENT;
+}
+
+static unsigned
+extent_height (const struct extent * const extents, const size_t index) {
+    return (index == NO_EXTENT) ? 0 : extents[index].height;
+}
+
+static void
+update_height (struct extent * const extents, const size_t index) {
+    const unsigned left = extent_height(extents, extents[index].left);
+    const unsigned right = extent_height(extents, extents[index].right);
+    extents[index].height = ((left > right) ? left : right) + 1U;
+}
+
+static size_t
+rotate_right (struct extent * const extents, const size_t index) {
+    const size_t left = extents[index].left;
+    extents[index].left = extents[left].right;
+    extents[left].right = index;
+    update_height(extents, index);
+    update_height(extents, left);
+    return left;
+}
+
+static size_t
+rotate_left (struct extent * const extents, const size_t index) {
+    const size_t right = extents[index].right;
+    extents[index].right = extents[right].left;
+    extents[right].left = index;
+    update_height(extents, index);
+    update_height(extents, right);
+    return right;
+}
+
+// Insert the extent `new_index` into the subtree at `index`, returns the
+// index of the new (rebalanced) root of the subtree.
+//
+static size_t
+insert_extent (struct extent * const extents, const size_t index,
+               const size_t new_index) {
+    unsigned left, right;
+    if (index == NO_EXTENT) {
+        return new_index;
+    }
+    if (extents[new_index].address < extents[index].address) {
+        extents[index].left = insert_extent(extents, extents[index].left, new_index);
+    } else {
+        extents[index].right = insert_extent(extents, extents[index].right, new_index);
+    }
+    update_height(extents, index);
+    left = extent_height(extents, extents[index].left);
+    right = extent_height(extents, extents[index].right);
+    if (left > right + 1U) {
+        const size_t child = extents[index].left;
+        if (extent_height(extents, extents[child].left) <
+            extent_height(extents, extents[child].right)) {
+            extents[index].left = rotate_left(extents, child);
+        }
+        return rotate_right(extents, index);
+    }
+    if (right > left + 1U) {
+        const size_t child = extents[index].right;
+        if (extent_height(extents, extents[child].right) <
+            extent_height(extents, extents[child].left)) {
+            extents[index].right = rotate_right(extents, child);
+        }
+        return rotate_left(extents, index);
+    }
+    return index;
+}
+
+bool
+extent_insert (struct extent_tree * const tree, const unsigned long address,
+               const uint8_t *data, const size_t count) {
+    size_t index = find_extent_ending_at(tree, address);
+    struct extent *extent;
+
+    if (index == NO_EXTENT) {
+        if (tree->count == tree->capacity) {
+            const size_t capacity = tree->capacity ? tree->capacity * 2 : 64;
+            if (!(extent = realloc(tree->extents, capacity * sizeof(*extent)))) {
+                return false;
+            }
+            tree->extents = extent;
+            tree->capacity = capacity;
+        }
+        index = tree->count++;
+        extent = &tree->extents[index];
+        extent->address = address;
+        extent->length = 0;
+        extent->capacity = 0;
+        extent->data = NULL;
+        extent->left = NO_EXTENT;
+        extent->right = NO_EXTENT;
+        extent->height = 1;
+        tree->root = insert_extent(tree->extents, tree->root, index);
+        if (tree->last == NO_EXTENT || tree->extents[tree->last].address < address) {
+            tree->last = index;
+        }
+    }
+    return extent_append(&tree->extents[index], data, count);
+}
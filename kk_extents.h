@@ -0,0 +1,94 @@
+/*
+ * kk_extents.h: Data kept in memory as extents (contiguous runs of data)
+ * in a balanced tree ordered by address, e.g., to collect the data of IHEX
+ * files whose records are not in ascending address order.
+ *
+ * The memory use is proportional to the amount of data, not the address
+ * space, and the extent at any address is found in logarithmic time. Data
+ * that continues an extent is appended to it, but extents are never joined
+ * by copying, so data in any order takes time proportional to its size
+ * (times the logarithm of the number of extents).
+ *
+ * The sequence to use an extent tree is:
+ *      struct extent_tree tree;
+ *      size_t i;
+ *      extent_tree_init(&tree);
+ *      extent_insert(&tree, address, data, count); // any number of times
+ *      for (i = extent_first(&tree); i != NO_EXTENT; i = extent_next(&tree, i)) {
+ *          // use tree.extents[i].address, .data, and .length
+ *      }
+ *      extent_tree_free(&tree);
+ *
+ * The data inserted must not overlap existing extents, i.e., the caller
+ * resolves any overlap first with the help of `extent_find`.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_EXTENTS_H
+#define KK_EXTENTS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NO_EXTENT (~(size_t) 0)
+
+struct extent {
+    unsigned long   address;
+    size_t          length;
+    size_t          capacity;
+    uint8_t         *data;
+    size_t          left;   // the subtree of extents at lower addresses
+    size_t          right;  // the subtree of extents at higher addresses
+    unsigned        height;
+};
+
+// The extents are allocated from the array `extents`, and kept in an AVL
+// tree ordered by address, rooted at `root`
+struct extent_tree {
+    struct extent   *extents;
+    size_t          count;
+    size_t          capacity;
+    size_t          root;
+    size_t          last;   // the extent with the highest address
+};
+
+// Initialise `tree` as empty
+void extent_tree_init(struct extent_tree *tree);
+
+// Free the memory used by `tree`
+void extent_tree_free(struct extent_tree *tree);
+
+// Returns the end address (exclusive) of `extent`
+#define extent_end(extent) ((unsigned long long) (extent)->address + (extent)->length)
+
+// Returns the index of the first extent of `tree` that ends after
+// `address`, or `NO_EXTENT` if there is none
+size_t extent_find(const struct extent_tree *tree, unsigned long address);
+
+// Returns the index of the extent with the lowest address in `tree`, or
+// `NO_EXTENT` if `tree` is empty
+size_t extent_first(const struct extent_tree *tree);
+
+// Returns the index of the extent following `index` in address order, or
+// `NO_EXTENT` if it is the last
+size_t extent_next(const struct extent_tree *tree, size_t index);
+
+// Add `count` bytes of `data` at `address`, which must not overlap any
+// existing extent. The data is appended to the extent ending at `address`,
+// if any, otherwise a new extent is created for it. Returns false on error
+// (see `errno`), i.e., if memory could not be allocated.
+bool extent_insert(struct extent_tree *tree, unsigned long address,
+                   const uint8_t *data, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_EXTENTS_H
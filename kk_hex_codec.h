@@ -0,0 +1,46 @@
+/*
+ * kk_hex_codec.h: Hexadecimal encoding and decoding shared by the IHEX
+ * and S-record readers and writers. This is an internal header of the
+ * library, i.e., not needed to use it.
+ *
+ * Copyright (c) 2013-2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_HEX_CODEC_H
+#define KK_HEX_CODEC_H
+
+#include <stdint.h>
+
+#define HEX_DIGIT(n) ((char)((n) + (((n) < 10) ? '0' : ('A' - 10))))
+
+// The value of a hexadecimal digit, returned as greater than 15 if `c` is
+// not a hexadecimal digit
+#define HEX_INVALID_DIGIT 0xFFU
+
+// Write `byte` as two hexadecimal digits at `w`, returns the pointer past
+// the digits written
+static inline char *
+hex_buffer_byte (char * restrict w, const uint8_t byte) {
+    uint8_t n = (byte & 0xF0U) >> 4; // high nybble
+    *w++ = HEX_DIGIT(n);
+    n = byte & 0x0FU; // low nybble
+    *w++ = HEX_DIGIT(n);
+    return w;
+}
+
+// Returns the value of the hexadecimal digit `c`, or `HEX_INVALID_DIGIT`
+static inline uint_fast8_t
+hex_digit_value (uint_fast8_t c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'A' && c <= 'F') {
+        return c - ('A' - 10);
+    } else if (c >= 'a' && c <= 'f') {
+        return c - ('a' - 10);
+    }
+    return HEX_INVALID_DIGIT;
+}
+
+#endif // !KK_HEX_CODEC_H
@@ -65,7 +65,8 @@
  * The same `struct ihex_state` may be used either for reading or writing,
  * but NOT both at the same time. Furthermore, a global output buffer is
  * used for writing, i.e., multiple threads must not write simultaneously
- * (but multiple writes may be interleaved).
+ * (but multiple writes may be interleaved), unless the library is built
+ * with `IHEX_REENTRANT_WRITE` defined (see `kk_ihex_write.h`).
  *
  *
  *      CONSERVING MEMORY
@@ -98,6 +99,27 @@
  * this is a fairly pointless optimisation.
  *
  *
+ *      STATISTICS
+ *      ----------
+ *
+ * If the library is built with `IHEX_ENABLE_STATS` defined, every
+ * `struct ihex_state` has a `struct ihex_stats` named `stats`, which counts
+ * the records by type, the data bytes, the checksum and length errors, the
+ * characters skipped as junk by `ihex_read_byte`, the changes of the
+ * extended address, and the calls of `ihex_data_read` and
+ * `ihex_flush_buffer`. The counters are reset by `ihex_init` and
+ * `ihex_begin_read` (and the functions that call it), and can be printed
+ * with `ihex_stats_print` (see `kk_ihex_stats.h`). Without the option the
+ * counters do not exist, i.e., they cost nothing.
+ *
+ * To also sum the time spent in the callbacks, define `IHEX_STATS_CLOCK`
+ * as the name of a function (or function-like macro) without arguments
+ * that returns the current time as `unsigned long long` in any unit and
+ * needs no declaration, e.g., `__builtin_ia32_rdtsc` for the time stamp
+ * counter of x86 with GCC or Clang. All modules need to be built with the
+ * same options, since the size of `struct ihex_state` depends on them.
+ *
+ *
  * Copyright (c) 2013-2019 Kimmo Kulovesi, https://arkku.com/
  * Provided with absolutely no warranty, use at your own risk only.
  * Use and distribute freely, mark modified copies as such.
@@ -108,6 +130,7 @@
 
 #define KK_IHEX_VERSION "2019-08-07"
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef IHEX_USE_STDBOOL
@@ -130,10 +153,39 @@ typedef int ihex_count_t;
 #endif
 
 enum ihex_flags {
-    IHEX_FLAG_ADDRESS_OVERFLOW = 0x80   // 16-bit address overflow
+    IHEX_FLAG_ADDRESS_OVERFLOW = 0x80,  // 16-bit address overflow
+    IHEX_FLAG_END_WRITTEN = 0x40,       // end of file record written
+    IHEX_FLAG_READ_PAUSED = 0x80        // reading paused (reading only)
 };
 typedef uint8_t ihex_flags_t;
 
+// The newline string (appended to every output line, e.g., "\r\n")
+#ifndef IHEX_NEWLINE_STRING
+#define IHEX_NEWLINE_STRING "\n"
+#endif
+
+#ifdef IHEX_NONBLOCKING_WRITE
+// Space for the output not yet sent by a non-blocking write: at most one
+// data record and two short records (see `kk_ihex_write.h`)
+#define IHEX_PENDING_LENGTH ((IHEX_LINE_MAX_LENGTH * 2) + 3 * (15 + sizeof(IHEX_NEWLINE_STRING)))
+#endif
+
+#ifdef IHEX_ENABLE_STATS
+typedef struct ihex_stats {
+    unsigned long long  records[8];         // indexed by record type
+    unsigned long long  data_bytes;
+    unsigned long long  checksum_errors;
+    unsigned long long  length_errors;      // too long or cut short
+    unsigned long long  junk_bytes;         // skipped, other than newlines
+    unsigned long long  address_changes;
+    unsigned long long  callbacks;          // calls of `ihex_data_read`
+    unsigned long long  flushes;            // calls of `ihex_flush_buffer`
+#ifdef IHEX_STATS_CLOCK
+    unsigned long long  callback_time;      // in the unit of the clock
+#endif
+} kk_ihex_stats_t;
+#endif
+
 typedef struct ihex_state {
     ihex_address_t  address;
 #ifndef IHEX_DISABLE_SEGMENTS
@@ -143,8 +195,38 @@ typedef struct ihex_state {
     uint8_t         line_length;
     uint8_t         length;
     uint8_t         data[IHEX_LINE_MAX_LENGTH + 1];
+#ifdef IHEX_NONBLOCKING_WRITE
+    uint16_t        pending_length;
+    char            pending[IHEX_PENDING_LENGTH];
+#endif
+#ifdef IHEX_ENABLE_STATS
+    struct ihex_stats stats;
+#endif
 } kk_ihex_t;
 
+// Counting of the statistics, used by the library
+#ifdef IHEX_ENABLE_STATS
+#define IHEX_STATS_RESET(ihex) ((ihex)->stats = (struct ihex_stats) { 0 })
+#define IHEX_STATS_ADD(ihex, counter, n) ((void) ((ihex)->stats.counter += (n)))
+#ifdef IHEX_STATS_CLOCK
+#define IHEX_STATS_CALL(ihex, counter, call) do { \
+        const unsigned long long ihex_stats_start = IHEX_STATS_CLOCK(); \
+        ++(ihex)->stats.counter; \
+        call; \
+        (ihex)->stats.callback_time += IHEX_STATS_CLOCK() - ihex_stats_start; \
+    } while (0)
+#else
+#define IHEX_STATS_CALL(ihex, counter, call) do { \
+        ++(ihex)->stats.counter; \
+        call; \
+    } while (0)
+#endif
+#else
+#define IHEX_STATS_RESET(ihex) ((void) 0)
+#define IHEX_STATS_ADD(ihex, counter, n) ((void) 0)
+#define IHEX_STATS_CALL(ihex, counter, call) call
+#endif
+
 enum ihex_record_type {
     IHEX_DATA_RECORD,
     IHEX_END_OF_FILE_RECORD,
@@ -163,14 +245,18 @@ typedef uint8_t ihex_record_type_t;
 //
 #define IHEX_LINEAR_ADDRESS(ihex) ((ihex)->address + (((ihex_address_t)((ihex)->segment)) << 4))
 //
-// Note that segmented addressing with the above macro is not strictly adherent
-// to the IHEX specification, which mandates that the lowest 16 bits of the
-// address and the index of the data byte must be added modulo 64K (i.e.,
-// at 16 bits precision with wraparound) and the segment address only added
-// afterwards.
+// The IHEX specification mandates that the lowest 16 bits of the address
+// and the index of the data byte must be added modulo 64K (i.e., at 16 bits
+// precision with wraparound) and the segment address only added afterwards.
+// The reader takes care of this: if the 16-bit offset of a data record wraps
+// around while a non-zero segment is in effect, the record is passed to
+// `ihex_data_read` as two records, the second one at offset zero, i.e., the
+// data of each record is always contiguous at `IHEX_LINEAR_ADDRESS`. (With
+// segment zero, the address continues linearly past 64K, as in the output
+// of the write functions without an extended address record.)
 //
-// To implement fully correct segmented addressing, compute the address
-// of _each byte_ with its index in `data` as follows:
+// The address of _each byte_ with its index in `data` can also be computed
+// as follows, with the wraparound applied even when the segment is zero:
 //
 #define IHEX_BYTE_ADDRESS(ihex, byte_index) ((((ihex)->address + (byte_index)) & 0xFFFFU) + (((ihex_address_t)((ihex)->segment)) << 4))
 
@@ -181,11 +267,6 @@ typedef uint8_t ihex_record_type_t;
 
 #endif
 
-// The newline string (appended to every output line, e.g., "\r\n")
-#ifndef IHEX_NEWLINE_STRING
-#define IHEX_NEWLINE_STRING "\n"
-#endif
-
 // See kk_ihex_read.h and kk_ihex_write.h for function declarations!
 
 #endif // !KK_IHEX_H
@@ -0,0 +1,138 @@
+/*
+ * kk_ihex_cursor.c: Read IHEX data records one at a time from a file.
+ *
+ * See the header `kk_ihex_cursor.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_ihex_cursor.h"
+#include <string.h>
+#include <errno.h>
+
+void
+ihex_cursor_init (struct ihex_cursor * const cursor, FILE *file,
+                  const char *name, const bool ascending) {
+    cursor->file = file;
+    cursor->name = name;
+    cursor->error = NULL;
+    cursor->line_number = 1;
+    cursor->end_address = 0;
+    cursor->address = 0;
+    cursor->data = cursor->record;
+    cursor->length = 0;
+    cursor->wrap_address = 0;
+    cursor->wrap_length = 0;
+    cursor->has_record = false;
+    cursor->end_of_file = false;
+    cursor->ascending = ascending;
+    cursor->start_type = 0;
+    (void) memset(cursor->start_address, 0, sizeof(cursor->start_address));
+    cursor->buffer_position = 0;
+    cursor->buffer_length = 0;
+    ihex_begin_read(&cursor->ihex);
+    ihex_cursor_next(cursor);
+}
+
+static void
+ihex_cursor_error (struct ihex_cursor * const cursor, const char * const message) {
+    if (!cursor->error) {
+        cursor->error = message;
+    }
+    cursor->has_record = false;
+    cursor->end_of_file = true;
+}
+
+void
+ihex_cursor_next (struct ihex_cursor * const cursor) {
+    while (!cursor->has_record && !cursor->end_of_file) {
+        char c;
+        if (cursor->buffer_position == cursor->buffer_length) {
+            if (!fgets(cursor->buffer, sizeof(cursor->buffer), cursor->file)) {
+                if (ferror(cursor->file)) {
+                    ihex_cursor_error(cursor, strerror(errno));
+                    break;
+                }
+                ihex_end_read(&cursor->ihex);
+                cursor->end_of_file = true;
+                break;
+            }
+            cursor->buffer_position = 0;
+            cursor->buffer_length = strlen(cursor->buffer);
+        }
+        c = cursor->buffer[cursor->buffer_position++];
+        ihex_read_byte(&cursor->ihex, c);
+        cursor->line_number += (c == '\n');
+    }
+}
+
+void
+ihex_cursor_consume (struct ihex_cursor * const cursor, const size_t count) {
+    cursor->address += (unsigned long) count;
+    cursor->data += count;
+    if (!(cursor->length -= count)) {
+        if (cursor->wrap_length) {
+            // the part after the wrap follows in `record`
+            cursor->address = cursor->wrap_address;
+            cursor->length = cursor->wrap_length;
+            cursor->wrap_length = 0;
+            return;
+        }
+        cursor->has_record = false;
+        ihex_cursor_next(cursor);
+    }
+}
+
+ihex_bool_t
+ihex_data_read (struct ihex_state *ihex,
+                ihex_record_type_t type,
+                ihex_bool_t error) {
+    struct ihex_cursor * const cursor = (struct ihex_cursor *) ihex;
+
+    if (cursor->end_of_file) {
+        // ignore anything after the end of file or an error
+        return false;
+    }
+    if (error) {
+        ihex_cursor_error(cursor, "Checksum error");
+        return false;
+    }
+    if (ihex->length < ihex->line_length) {
+        ihex_cursor_error(cursor, "Line length error");
+        return false;
+    }
+    if (type == IHEX_DATA_RECORD) {
+        const unsigned long address = (unsigned long) IHEX_LINEAR_ADDRESS(ihex);
+        if (!ihex->length) {
+            return true;
+        }
+        if (cursor->has_record) {
+            // the part of the same record after its offset wrapped around
+            // within the segment (see `ihex_end_read`)
+            (void) memcpy(cursor->record + cursor->length, ihex->data, ihex->length);
+            cursor->wrap_address = address;
+            cursor->wrap_length = ihex->length;
+            cursor->end_address = (unsigned long long) address + ihex->length;
+            return true;
+        }
+        if (cursor->ascending && address < cursor->end_address) {
+            ihex_cursor_error(cursor, "Data is not in ascending address order");
+            return false;
+        }
+        cursor->end_address = (unsigned long long) address + ihex->length;
+        (void) memcpy(cursor->record, ihex->data, ihex->length);
+        cursor->address = address;
+        cursor->data = cursor->record;
+        cursor->length = ihex->length;
+        cursor->has_record = true;
+    } else if (type == IHEX_END_OF_FILE_RECORD) {
+        cursor->end_of_file = true;
+    } else if (type == IHEX_START_SEGMENT_ADDRESS_RECORD ||
+               type == IHEX_START_LINEAR_ADDRESS_RECORD) {
+        cursor->start_type = type;
+        (void) memcpy(cursor->start_address, ihex->data, 4);
+    }
+    return true;
+}
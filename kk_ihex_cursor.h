@@ -0,0 +1,87 @@
+/*
+ * kk_ihex_cursor.h: Read IHEX data records one at a time from a file, i.e.,
+ * "pull" the data instead of having it pushed to `ihex_data_read`. This
+ * allows reading several IHEX files in lockstep, e.g., to compare or to
+ * merge them in address order without converting them to binary.
+ *
+ * The sequence to use a cursor is:
+ *      struct ihex_cursor cursor;
+ *      ihex_cursor_init(&cursor, file, "file.hex", true);
+ *      while (cursor.has_record) {
+ *          // use cursor.address, cursor.data, cursor.length
+ *          ihex_cursor_consume(&cursor, cursor.length);
+ *      }
+ *      if (cursor.error) {
+ *          // report cursor.error at cursor.line_number
+ *      }
+ *
+ * A record may be consumed partially, in which case the remaining bytes
+ * (and their address) are available from the cursor. The addresses are
+ * linear, i.e., any segment is already added to them. A record whose
+ * offset wraps around within its segment is returned as two records, the
+ * second of which is at a lower address than the first; such a wrap does
+ * not violate the ascending address order.
+ *
+ * This module provides the implementation of `ihex_data_read`, so it can
+ * not be used in the same program with other readers.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_IHEX_CURSOR_H
+#define KK_IHEX_CURSOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "kk_ihex_read.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+struct ihex_cursor {
+    struct ihex_state   ihex;
+    FILE                *file;
+    const char          *name;
+    const char          *error;         // error message, NULL if none
+    unsigned long       line_number;
+    unsigned long long  end_address;
+    unsigned long       address;        // address of `data`
+    uint8_t             *data;          // the unconsumed data of the record
+    size_t              length;         // the length of `data`
+    unsigned long       wrap_address;   // address of the part after a wrap
+    size_t              wrap_length;    // the length of that part, or 0
+    bool                has_record;
+    bool                end_of_file;
+    bool                ascending;      // require ascending address order
+    uint8_t             start_type;     // type of the start address record
+    uint8_t             start_address[4];
+    uint8_t             record[IHEX_LINE_MAX_LENGTH + 1];
+    size_t              buffer_position;
+    size_t              buffer_length;
+    char                buffer[256];
+};
+
+// Initialise `cursor` to read IHEX from `file`, and read the first record.
+// The `name` of the file is only used in error messages. If `ascending` is
+// true, the data records must be in ascending address order, otherwise
+// reading stops with an error.
+void ihex_cursor_init(struct ihex_cursor *cursor, FILE *file,
+                      const char *name, bool ascending);
+
+// Read the next data record, unless the cursor already has one. On error
+// or at the end of file, `cursor->has_record` is false and the error is
+// indicated by `cursor->error`.
+void ihex_cursor_next(struct ihex_cursor *cursor);
+
+// Consume `count` bytes of the current record, reading the next record
+// once the current one is consumed entirely.
+void ihex_cursor_consume(struct ihex_cursor *cursor, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_IHEX_CURSOR_H
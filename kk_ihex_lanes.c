@@ -0,0 +1,262 @@
+/*
+ * kk_ihex_lanes.c: Split IHEX data into byte lanes and merge them back.
+ *
+ * See the header `kk_ihex_lanes.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_ihex_lanes.h"
+#include "kk_ihex_cursor.h"
+#include "kk_ihex_write.h"
+#include "kk_lanes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define ADDRESS_MAX 0xFFFFFFFFULL
+
+// An IHEX output, the writer state must be the first member
+struct lane_output {
+    struct ihex_state   ihex;
+    FILE                *file;
+    unsigned long long  next_address;   // address of the next byte
+};
+
+// The swap stage between the input and the outputs, the stage must be
+// the first member
+struct lanes_swap {
+    struct swap_stage   stage;
+    struct lane_output  *output;
+    unsigned long       group_size;     // 0 when merging
+    unsigned            lane_width;
+};
+
+static void
+lane_output_init (struct lane_output * const output, FILE * const file) {
+    ihex_init(&output->ihex);
+    output->file = file;
+    output->next_address = ~0ULL;
+}
+
+// Write `count` bytes of `data` at `address` of `output`.
+//
+static void
+lane_output_write (struct lane_output * const output,
+                   const unsigned long long address,
+                   const uint8_t *data, const size_t count) {
+    if (address != output->next_address) {
+        ihex_write_at_address(&output->ihex, (ihex_address_t) address);
+    }
+    output->next_address = address + count;
+    ihex_write_bytes(&output->ihex, data, (ihex_count_t) count);
+}
+
+// End the output, returns false on write error.
+//
+static bool
+lane_output_end (struct lane_output * const output) {
+    ihex_end_write(&output->ihex);
+    return !ferror(output->file) && !fflush(output->file);
+}
+
+static bool
+valid_lanes (const unsigned lane_count, const unsigned lane_width) {
+    if (!lane_count || lane_count > LANES_MAX_COUNT ||
+        !lane_width || lane_width > LANES_MAX_WIDTH) {
+        (void) fprintf(stderr, "Invalid lanes: %u x %u bytes\n",
+                       lane_count, lane_width);
+        return false;
+    }
+    return true;
+}
+
+static void
+cursor_error (const struct ihex_cursor * const cursor) {
+    (void) fprintf(stderr, "%s:%lu: %s\n", cursor->name, cursor->line_number,
+                   cursor->error);
+}
+
+// Split `count` bytes of `data` at `address` into the lanes of `lanes`.
+//
+static void
+split_data (const struct lanes_swap * const lanes, unsigned long address,
+            const uint8_t *data, size_t count) {
+    const unsigned long lane_width = lanes->lane_width;
+
+    while (count) {
+        // one lane's part of a group, at most
+        const unsigned long offset = address % lane_width;
+        const unsigned long lane = (address % lanes->group_size) / lane_width;
+        size_t n = lane_width - offset;
+        if (n > count) {
+            n = count;
+        }
+        lane_output_write(&lanes->output[lane],
+                          (address / lanes->group_size) * lane_width + offset,
+                          data, n);
+        address += n;
+        data += n;
+        count -= n;
+    }
+}
+
+bool
+ihex_lanes_split (FILE *infile, const char *name,
+                  FILE * const *outfile,
+                  const unsigned lane_count, const unsigned lane_width,
+                  const enum swap_mode swap) {
+    struct split_state {
+        struct ihex_cursor  input;
+        struct lanes_swap   lanes;
+        struct lane_output  output[LANES_MAX_COUNT];
+    } *state;
+    struct ihex_cursor *input;
+    struct lanes_swap *lanes;
+    bool success = true;
+    unsigned n;
+
+    if (!valid_lanes(lane_count, lane_width)) {
+        return false;
+    }
+    if (!(state = malloc(sizeof(*state)))) {
+        perror(name);
+        return false;
+    }
+    input = &state->input;
+    lanes = &state->lanes;
+    lanes->output = state->output;
+    lanes->group_size = (unsigned long) lane_count * lane_width;
+    lanes->lane_width = lane_width;
+    swap_stage_init(&lanes->stage, swap);
+    for (n = 0; n < lane_count; ++n) {
+        lane_output_init(&lanes->output[n], outfile[n]);
+    }
+
+    ihex_cursor_init(input, infile, name, false);
+    while (input->has_record) {
+        swap_stage_write(&lanes->stage, input->address, input->data, input->length);
+        ihex_cursor_consume(input, input->length);
+    }
+    swap_stage_flush(&lanes->stage);
+    if (input->error) {
+        cursor_error(input);
+        success = false;
+    }
+
+    for (n = 0; n < lane_count; ++n) {
+        if (!lane_output_end(&lanes->output[n])) {
+            perror("Error");
+            success = false;
+        }
+    }
+    free(state);
+    return success;
+}
+
+bool
+ihex_lanes_merge (FILE * const *infile, const char * const *name,
+                  FILE *outfile,
+                  const unsigned lane_count, const unsigned lane_width,
+                  const enum swap_mode swap) {
+    const unsigned long long group_size = (unsigned long long) lane_count * lane_width;
+    struct ihex_cursor *input;
+    struct lane_output output;
+    struct lanes_swap lanes;
+    bool success = true;
+    unsigned n;
+
+    if (!valid_lanes(lane_count, lane_width)) {
+        return false;
+    }
+    if (!(input = malloc(lane_count * sizeof(*input)))) {
+        perror("Error");
+        return false;
+    }
+    lane_output_init(&output, outfile);
+    lanes.output = &output;
+    lanes.group_size = 0;
+    lanes.lane_width = lane_width;
+    swap_stage_init(&lanes.stage, swap);
+    for (n = 0; n < lane_count; ++n) {
+        ihex_cursor_init(&input[n], infile[n], name[n], true);
+    }
+
+    for (;;) {
+        // merge the part of a group that comes first in the output
+        struct ihex_cursor *first = NULL;
+        unsigned long long first_address = 0;
+        unsigned offset = 0;
+        size_t count;
+
+        for (n = 0; n < lane_count; ++n) {
+            unsigned long long address;
+            if (!input[n].has_record) {
+                continue;
+            }
+            offset = (unsigned) (input[n].address % lane_width);
+            address = (input[n].address / lane_width) * group_size +
+                      (unsigned long long) n * lane_width + offset;
+            if (!first || address < first_address) {
+                first = &input[n];
+                first_address = address;
+            }
+        }
+        if (!first) {
+            break;
+        }
+        if (first_address > ADDRESS_MAX) {
+            (void) fprintf(stderr, "%s:%lu: Merged address out of range\n",
+                           first->name, first->line_number);
+            success = false;
+            break;
+        }
+        offset = (unsigned) (first->address % lane_width);
+        count = lane_width - offset;
+        if (count > first->length) {
+            count = first->length;
+        }
+        swap_stage_write(&lanes.stage, (unsigned long) first_address,
+                         first->data, count);
+        ihex_cursor_consume(first, count);
+        if (first->error) {
+            break;
+        }
+    }
+    swap_stage_flush(&lanes.stage);
+    for (n = 0; n < lane_count; ++n) {
+        if (input[n].error) {
+            cursor_error(&input[n]);
+            success = false;
+        }
+    }
+
+    if (!lane_output_end(&output)) {
+        perror("Error");
+        success = false;
+    }
+    free(input);
+    return success;
+}
+
+void
+ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    struct lane_output * const output = (struct lane_output *) ihex;
+    *eptr = '\0';
+    (void) fputs(buffer, output->file);
+}
+
+void
+swap_stage_output (struct swap_stage *stage,
+                   unsigned long address,
+                   const uint8_t *data,
+                   size_t count) {
+    const struct lanes_swap * const lanes = (const struct lanes_swap *) stage;
+    if (lanes->group_size) {
+        split_data(lanes, address, data, count);
+    } else {
+        lane_output_write(lanes->output, address, data, count);
+    }
+}
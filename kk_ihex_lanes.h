@@ -0,0 +1,61 @@
+/*
+ * kk_ihex_lanes.h: Split IHEX data into byte lanes and merge them back
+ * without converting to binary, i.e., the IHEX equivalent of `kk_lanes.h`.
+ *
+ * The lanes are numbered and have the same width as in `kk_lanes.h`, and
+ * the addresses are mapped accordingly: with `L` lanes of width `w`, the
+ * byte at address `x` is in lane `(x / w) % L` at the address
+ * `(x / (L * w)) * w + x % w` of that lane. For example, with two lanes
+ * of 8 bits, the bytes at addresses 0x100 and 0x101 are at address 0x80
+ * of lanes 0 and 1, respectively.
+ *
+ * Only the data is split or merged, so any gaps in the data remain gaps,
+ * i.e., sparse data stays sparse. The output uses linear addresses, and
+ * start address records are not written.
+ *
+ * The functions report errors to `stderr` and return false on error.
+ * This module provides the implementations of `ihex_flush_buffer` and
+ * `swap_stage_output`, and uses `kk_ihex_cursor.h` for reading, which
+ * provides `ihex_data_read`.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_IHEX_LANES_H
+#define KK_IHEX_LANES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "kk_swap.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// Read IHEX from `infile` and write each of its lanes as IHEX into the
+// corresponding file of `outfile`. The input does not need to be in any
+// particular order. The `name` of the input is used in error messages.
+// The input is swapped according to `swap` (see `kk_swap.h`) before
+// splitting.
+bool ihex_lanes_split(FILE *infile, const char *name,
+                      FILE * const *outfile,
+                      unsigned lane_count, unsigned lane_width,
+                      enum swap_mode swap);
+
+// Read IHEX lanes from the files of `infile` and write them merged as IHEX
+// into `outfile`, i.e., the inverse of `ihex_lanes_split`. The data records
+// of each input must be in ascending address order. The output is written
+// in ascending address order. The `name` array contains the names of the
+// inputs for error messages. The output is swapped according to `swap`
+// (see `kk_swap.h`) after merging.
+bool ihex_lanes_merge(FILE * const *infile, const char * const *name,
+                      FILE *outfile,
+                      unsigned lane_count, unsigned lane_width,
+                      enum swap_mode swap);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_IHEX_LANES_H
@@ -0,0 +1,118 @@
+/*
+ * kk_ihex_page.c: Assemble data into fixed-size, aligned pages.
+ *
+ * See the header `kk_ihex_page.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_ihex_page.h"
+#include <string.h>
+
+void
+ihex_page_init (struct ihex_page_sink * const sink,
+                struct ihex_page *page,
+                uint8_t *buffer,
+                uint_fast8_t page_count,
+                const ihex_address_t page_size,
+                const uint8_t fill) {
+    sink->pages = page;
+    sink->page_size = page_size;
+    sink->write_count = 0;
+    sink->page_count = (uint8_t) page_count;
+    sink->fill = fill;
+    while (page_count--) {
+        page->address = 0;
+        page->filled = 0;
+        page->last_write = 0;
+        page->data = buffer;
+        buffer += page_size;
+        ++page;
+    }
+}
+
+static void
+ihex_page_output (struct ihex_page_sink * const sink,
+                  struct ihex_page * const page) {
+    ihex_page_ready(sink, page->address, page->data);
+    page->filled = 0;
+}
+
+// Find the open page for `address`, or open a new one.
+//
+static struct ihex_page *
+ihex_page_find (struct ihex_page_sink * const sink, const ihex_address_t address) {
+    struct ihex_page *page = sink->pages;
+    struct ihex_page * const end = page + sink->page_count;
+    struct ihex_page *oldest = page;
+    struct ihex_page *unused = NULL;
+
+    do {
+        if (!page->filled) {
+            unused = page;
+        } else if (page->address == address) {
+            return page;
+        } else if ((uint_least16_t) (sink->write_count - page->last_write) >
+                   (uint_least16_t) (sink->write_count - oldest->last_write)) {
+            oldest = page;
+        }
+    } while (++page != end);
+
+    if (!unused) {
+        // all pages are in use, output the least recently written
+        ihex_page_output(sink, oldest);
+        unused = oldest;
+    }
+    unused->address = address;
+    (void) memset(unused->data, sink->fill, sink->page_size);
+    return unused;
+}
+
+void
+ihex_page_write (struct ihex_page_sink * restrict const sink,
+                 ihex_address_t address,
+                 const uint8_t * restrict data,
+                 ihex_count_t count) {
+    const ihex_address_t offset_mask = sink->page_size - 1U;
+
+    while (count > 0) {
+        const ihex_address_t offset = address & offset_mask;
+        struct ihex_page * const page = ihex_page_find(sink, address - offset);
+        ihex_address_t n = sink->page_size - offset;
+
+        if (n > (ihex_address_t) count) {
+            n = (ihex_address_t) count;
+        }
+        (void) memcpy(page->data + offset, data, n);
+        data += n;
+        address += n;
+        count -= (ihex_count_t) n;
+
+        page->last_write = ++(sink->write_count);
+        if ((page->filled += n) >= sink->page_size) {
+            ihex_page_output(sink, page);
+        }
+    }
+}
+
+void
+ihex_page_flush (struct ihex_page_sink * const sink) {
+    for (;;) {
+        struct ihex_page *page = sink->pages;
+        struct ihex_page * const end = page + sink->page_count;
+        struct ihex_page *lowest = NULL;
+
+        do {
+            if (page->filled && (!lowest || page->address < lowest->address)) {
+                lowest = page;
+            }
+        } while (++page != end);
+
+        if (!lowest) {
+            break;
+        }
+        ihex_page_output(sink, lowest);
+    }
+}
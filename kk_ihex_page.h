@@ -0,0 +1,128 @@
+/*
+ * kk_ihex_page.h: Assemble data into fixed-size, aligned pages, e.g.,
+ * for writing to flash memory. This is intended to be used with the
+ * read functions of kk_ihex_read.h, but it does not depend on them.
+ *
+ *
+ *      PAGE AGGREGATION
+ *      ----------------
+ *
+ * Flash memory is typically erased and programmed a page at a time (e.g.,
+ * 256 bytes, 2 KiB, 4 KiB), whereas IHEX records are usually 16 or 32
+ * bytes and often straddle page boundaries. The functions declared here
+ * collect the data into page buffers and call `ihex_page_ready` once for
+ * each page, with the parts not covered by the data set to a fill byte
+ * (e.g., 0xFF, the erased state of flash).
+ *
+ * The storage for the pages is provided by the caller: `page_count` page
+ * structures and a buffer of `page_count * page_size` bytes. A page is
+ * passed to `ihex_page_ready` as soon as it has been completely filled
+ * with data. If data arrives for a page while all pages are open, the
+ * least recently written page is passed on partially filled to make room.
+ * Hence data that is out of order only within the span of `page_count`
+ * pages does not cause any page to be output more than once.
+ *
+ * The sequence to use a page sink is:
+ *      static struct ihex_page pages[4];
+ *      static uint8_t buffer[4 * 256];
+ *      struct ihex_page_sink sink;
+ *      ihex_page_init(&sink, pages, buffer, 4, 256, 0xFF);
+ *      ihex_page_write(&sink, address, data, length); // any number of times
+ *      ihex_page_flush(&sink);
+ *
+ * For example, with IHEX input:
+ *
+ *      ihex_bool_t ihex_data_read(struct ihex_state *ihex,
+ *                                 ihex_record_type_t type,
+ *                                 ihex_bool_t error) {
+ *          error = error || (ihex->length < ihex->line_length);
+ *          if (type == IHEX_DATA_RECORD && !error) {
+ *              ihex_page_write(&sink, IHEX_LINEAR_ADDRESS(ihex),
+ *                              ihex->data, ihex->length);
+ *          } else if (type == IHEX_END_OF_FILE_RECORD) {
+ *              ihex_page_flush(&sink);
+ *          }
+ *          return !error;
+ *      }
+ *
+ * Completeness of a page is determined by counting the bytes written to it,
+ * so if the same address is written more than once, a page may be output
+ * before all of its data has arrived (and then output again for the rest).
+ *
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_IHEX_PAGE_H
+#define KK_IHEX_PAGE_H
+
+#ifdef __cplusplus
+#ifndef restrict
+#define restrict
+#endif
+extern "C" {
+#endif
+
+#include "kk_ihex.h"
+
+typedef struct ihex_page {
+    ihex_address_t  address;
+    ihex_address_t  filled;     // number of bytes written, 0 if unused
+    uint_least16_t  last_write;
+    uint8_t         *data;
+} kk_ihex_page_t;
+
+typedef struct ihex_page_sink {
+    struct ihex_page    *pages;
+    ihex_address_t      page_size;
+    uint_least16_t      write_count;
+    uint8_t             page_count;
+    uint8_t             fill;
+} kk_ihex_page_sink_t;
+
+// Initialise `sink` to use the `page_count` elements of `pages`, and
+// `buffer` for their data, which must have space for `page_count` times
+// `page_size` bytes. The `page_size` must be a power of two. The parts of
+// the pages not covered by data are set to `fill`.
+void ihex_page_init(struct ihex_page_sink *sink,
+                    struct ihex_page *pages,
+                    uint8_t *buffer,
+                    uint_fast8_t page_count,
+                    ihex_address_t page_size,
+                    uint8_t fill);
+
+// Write `count` bytes from `data` at `address`
+void ihex_page_write(struct ihex_page_sink * restrict sink,
+                     ihex_address_t address,
+                     const uint8_t * restrict data,
+                     ihex_count_t count);
+
+// Pass all partially filled pages to `ihex_page_ready` in ascending address
+// order (i.e., call this after the last write)
+void ihex_page_flush(struct ihex_page_sink *sink);
+
+// Called with each page of data, `sink->page_size` bytes from `data`. The
+// `address` is that of the first byte of the page (i.e., it is a multiple
+// of the page size). The implementation is NOT provided by this library.
+//
+// Example implementation:
+//
+//      void ihex_page_ready(struct ihex_page_sink *sink,
+//                           ihex_address_t address,
+//                           uint8_t *data) {
+//          flash_erase_page(address);
+//          flash_write_page(address, data, sink->page_size);
+//      }
+//
+// Note that `data` is reused as soon as this function returns.
+//
+extern void ihex_page_ready(struct ihex_page_sink *sink,
+                            ihex_address_t address,
+                            uint8_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_IHEX_PAGE_H
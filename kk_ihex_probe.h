@@ -0,0 +1,51 @@
+/*
+ * kk_ihex_probe.h: Static tracepoints of the IHEX library. This is an
+ * internal header of the library, i.e., not needed to use it.
+ *
+ * If the library is built with `IHEX_ENABLE_PROBES` defined, the read and
+ * write functions contain USDT probes (from `<sys/sdt.h>` of SystemTap,
+ * e.g., the package `systemtap-sdt-dev`), which tools such as `perf` and
+ * `bpftrace` can attach to in a running program. A probe is a single
+ * no-op instruction while nothing is attached. The probes of the provider
+ * `kk_ihex` are, with their arguments:
+ *
+ *      record_start(ihex)
+ *          the start code `:` of a record was read
+ *      end_read(ihex, type, address, length, checksum_error)
+ *          a record was read, before it is passed to `ihex_data_read`
+ *      address_change(ihex, type, value)
+ *          an extended linear or segment address record was read or
+ *          written, `value` is the upper 16 bits of the address or the
+ *          segment, respectively
+ *      write_data_start(ihex, address, length)
+ *      write_data_end(ihex)
+ *          around writing a data record (including its flush)
+ *      flush_start(ihex, type, length)
+ *      flush_end(ihex)
+ *          around each call of `ihex_flush_buffer`, `type` is 255 when
+ *          resending pending output with `IHEX_NONBLOCKING_WRITE`
+ *
+ * The argument `ihex` is the address of the `struct ihex_state`, e.g., to
+ * tell apart concurrent conversions. Without `IHEX_ENABLE_PROBES` the
+ * probes do not exist.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_IHEX_PROBE_H
+#define KK_IHEX_PROBE_H
+
+#ifdef IHEX_ENABLE_PROBES
+#include <sys/sdt.h>
+#define IHEX_PROBE1(name, a) DTRACE_PROBE1(kk_ihex, name, a)
+#define IHEX_PROBE3(name, a, b, c) DTRACE_PROBE3(kk_ihex, name, a, b, c)
+#define IHEX_PROBE5(name, a, b, c, d, e) DTRACE_PROBE5(kk_ihex, name, a, b, c, d, e)
+#else
+#define IHEX_PROBE1(name, a) ((void) 0)
+#define IHEX_PROBE3(name, a, b, c) ((void) 0)
+#define IHEX_PROBE5(name, a, b, c, d, e) ((void) 0)
+#endif
+
+#endif // !KK_IHEX_PROBE_H
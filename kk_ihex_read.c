@@ -9,6 +9,8 @@
  */
 
 #include "kk_ihex_read.h"
+#include "kk_hex_codec.h"
+#include "kk_ihex_probe.h"
 
 #define IHEX_START ':'
 
@@ -41,6 +43,7 @@ ihex_begin_read (struct ihex_state * const ihex) {
     ihex->flags = 0;
     ihex->line_length = 0;
     ihex->length = 0;
+    IHEX_STATS_RESET(ihex);
 }
 
 void
@@ -61,6 +64,7 @@ void
 ihex_end_read (struct ihex_state * const ihex) {
     uint_fast8_t type = ihex->flags & IHEX_READ_RECORD_TYPE_MASK;
     uint_fast8_t sum;
+    ihex_bool_t handled;
     if ((sum = ihex->length) == 0 && type == IHEX_DATA_RECORD) {
         return;
     }
@@ -74,19 +78,56 @@ ihex_end_read (struct ihex_state * const ihex) {
         }
         sum = (~sum + 1U) ^ *eptr; // *eptr is the received checksum
     }
-    if (ihex_data_read(ihex, type, (uint8_t) sum)) {
+    IHEX_STATS_ADD(ihex, records[type], 1U);
+    IHEX_STATS_ADD(ihex, data_bytes, (type == IHEX_DATA_RECORD) ? ihex->length : 0U);
+    IHEX_STATS_ADD(ihex, checksum_errors, (sum != 0U));
+    IHEX_STATS_ADD(ihex, length_errors, (ihex->length < ihex->line_length));
+    IHEX_PROBE5(end_read, ihex, type, ihex->address, ihex->length, (sum != 0U));
+#ifndef IHEX_DISABLE_SEGMENTS
+    if (type == IHEX_DATA_RECORD && ihex->segment &&
+        (ihex->address & 0xFFFFU) + ihex->length > 0x10000UL &&
+        ihex->length == ihex->line_length) {
+        // The 16-bit offset wraps around within the segment: deliver the
+        // data before the wrap and after it as separate records, so that
+        // each of them is contiguous at `IHEX_LINEAR_ADDRESS`.
+        const uint8_t first = (uint8_t) (0x10000UL - (ihex->address & 0xFFFFU));
+        const uint8_t * const eptr = ihex->data + ihex->length;
+        const uint8_t *r = ihex->data + first;
+        uint8_t *w = ihex->data;
+        ihex->length = ihex->line_length = first;
+        IHEX_STATS_CALL(ihex, callbacks, (void) ihex_data_read(ihex, type, (uint8_t) sum));
+        ihex->length = ihex->line_length = (uint8_t) (eptr - r);
+        while (r != eptr) {
+            *w++ = *r++;
+        }
+        ihex->address &= ADDRESS_HIGH_MASK;
+    }
+#endif
+    IHEX_STATS_CALL(ihex, callbacks, handled = ihex_data_read(ihex, type, (uint8_t) sum));
+    if (handled) {
         if (type == IHEX_EXTENDED_LINEAR_ADDRESS_RECORD) {
+            IHEX_STATS_ADD(ihex, address_changes, ((ihex->address >> 16) !=
+                           (ihex_address_t) ((ihex->data[0] << 8) | ihex->data[1])));
             ihex->address &= 0xFFFFU;
             ihex->address |= (((ihex_address_t) ihex->data[0]) << 24) |
                              (((ihex_address_t) ihex->data[1]) << 16);
+            IHEX_PROBE3(address_change, ihex, type, ihex->address >> 16);
 #ifndef IHEX_DISABLE_SEGMENTS
         } else if (type == IHEX_EXTENDED_SEGMENT_ADDRESS_RECORD) {
+            IHEX_STATS_ADD(ihex, address_changes, (ihex->segment !=
+                           (ihex_segment_t) ((ihex->data[0] << 8) | ihex->data[1])));
             ihex->segment = (ihex_segment_t) ((ihex->data[0] << 8) | ihex->data[1]);
+            IHEX_PROBE3(address_change, ihex, type, ihex->segment);
 #endif
         }
     }
     ihex->length = 0;
-    ihex->flags = 0;
+    ihex->flags &= IHEX_FLAG_READ_PAUSED;
+}
+
+void
+ihex_pause_read (struct ihex_state * const ihex) {
+    ihex->flags |= IHEX_FLAG_READ_PAUSED;
 }
 
 void
@@ -97,18 +138,16 @@ ihex_read_byte (struct ihex_state * const ihex, const char byte) {
     ihex->flags ^= state; // turn off the old state
     state >>= IHEX_READ_STATE_OFFSET;
 
-    if (b >= '0' && b <= '9') {
-        b -= '0';
-    } else if (b >= 'A' && b <= 'F') {
-        b -= 'A' - 10;
-    } else if (b >= 'a' && b <= 'f') {
-        b -= 'a' - 10;
-    } else if (b == IHEX_START) {
+    if ((b = hex_digit_value(b)) != HEX_INVALID_DIGIT) {
+        // hexadecimal digit
+    } else if (byte == IHEX_START) {
         // sync to a new record at any state
+        IHEX_PROBE1(record_start, ihex);
         state = READ_COUNT_HIGH;
         goto end_read;
     } else {
         // ignore unknown characters (e.g., extra whitespace)
+        IHEX_STATS_ADD(ihex, junk_bytes, (byte != '\n' && byte != '\r'));
         goto save_read_state;
     }
 
@@ -124,12 +163,14 @@ ihex_read_byte (struct ihex_state * const ihex, const char byte) {
         switch (state >> 1) {
         default:
             // remain in initial state while waiting for :
+            IHEX_STATS_ADD(ihex, junk_bytes, 1U);
             return;
         case (READ_COUNT_LOW >> 1):
             // data length
             ihex->line_length = b;
 #if IHEX_LINE_MAX_LENGTH < 255
             if (b > IHEX_LINE_MAX_LENGTH) {
+                IHEX_STATS_ADD(ihex, length_errors, 1U);
                 ihex_end_read(ihex);
                 return;
             }
@@ -169,13 +210,26 @@ save_read_state:
     ihex->flags |= state << IHEX_READ_STATE_OFFSET;
 }
 
-void
-ihex_read_bytes (struct ihex_state * restrict ihex,
+size_t
+ihex_read_block (struct ihex_state * restrict ihex,
                  const char * restrict data,
-                 ihex_count_t count) {
-    while (count > 0) {
+                 size_t count) {
+    const size_t total = count;
+    ihex->flags &= ~IHEX_FLAG_READ_PAUSED; // resume
+    while (count) {
         ihex_read_byte(ihex, *data++);
         --count;
+        if (ihex->flags & IHEX_FLAG_READ_PAUSED) {
+            break;
+        }
     }
+    return total - count;
+}
+
+ihex_count_t
+ihex_read_bytes (struct ihex_state * restrict ihex,
+                 const char * restrict data,
+                 ihex_count_t count) {
+    return (count > 0) ? (ihex_count_t) ihex_read_block(ihex, data, (size_t) count) : 0;
 }
 
@@ -20,6 +20,27 @@
  *      ihex_end_read(&ihex);
  *
  *
+ *      PAUSING
+ *      -------
+ *
+ * If the data can not be processed as fast as it arrives (e.g., a flash
+ * page must be erased first), `ihex_data_read` can call `ihex_pause_read`,
+ * and `ihex_read_bytes` then returns right after the character that ended
+ * the record, with the number of characters it consumed. The state is
+ * kept, so reading is resumed later by passing the rest of the input to
+ * `ihex_read_bytes` again, e.g.:
+ *
+ *      ihex_count_t done = 0;
+ *      while (done < length) {
+ *          done += ihex_read_bytes(&ihex, input + done, length - done);
+ *          if (done < length) {
+ *              wait_for_flash(); // paused
+ *          }
+ *      }
+ *
+ * This does not affect `ihex_read_byte`, which reads only one character.
+ *
+ *
  *      CONSERVING MEMORY
  *      -----------------
  *
@@ -60,10 +81,22 @@ void ihex_read_at_address(struct ihex_state *ihex,
 // Read a single character
 void ihex_read_byte(struct ihex_state *ihex, char chr);
 
-// Read `count` bytes from `data`
-void ihex_read_bytes(struct ihex_state * restrict ihex,
-                     const char * restrict data,
-                     ihex_count_t count);
+// Read `count` bytes from `data`, returns the number of bytes read, which
+// is less than `count` only if `ihex_pause_read` was called (see above)
+ihex_count_t ihex_read_bytes(struct ihex_state * restrict ihex,
+                             const char * restrict data,
+                             ihex_count_t count);
+
+// Read `count` bytes from `data` as `ihex_read_bytes` does, but with the
+// count as `size_t`, e.g., for a whole file mapped into memory
+size_t ihex_read_block(struct ihex_state * restrict ihex,
+                       const char * restrict data,
+                       size_t count);
+
+// Pause reading after the current record, i.e., make `ihex_read_bytes`
+// return without reading the rest of its input; this may be called from
+// `ihex_data_read`, and the next call of `ihex_read_bytes` resumes
+void ihex_pause_read(struct ihex_state *ihex);
 
 // End reading (may call `ihex_data_read` if there is data waiting)
 void ihex_end_read(struct ihex_state *ihex);
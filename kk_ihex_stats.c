@@ -0,0 +1,81 @@
+/*
+ * kk_ihex_stats.c: Print the statistics counted by the IHEX library.
+ *
+ * See the header `kk_ihex_stats.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_ihex_stats.h"
+
+#ifdef IHEX_ENABLE_STATS
+
+static const char * const record_names[] = {
+    "data",
+    "end_of_file",
+    "extended_segment_address",
+    "start_segment_address",
+    "extended_linear_address",
+    "start_linear_address",
+    "other"
+};
+
+#define RECORD_NAME_COUNT (sizeof(record_names) / sizeof(record_names[0]))
+
+ihex_bool_t
+ihex_stats_print (const struct ihex_state * const ihex, FILE *file,
+                  const ihex_bool_t json) {
+    const struct ihex_stats * const stats = &ihex->stats;
+    const struct {
+        const char          *name;
+        unsigned long long  value;
+    } counters[] = {
+        { "data_bytes",         stats->data_bytes },
+        { "checksum_errors",    stats->checksum_errors },
+        { "length_errors",      stats->length_errors },
+        { "junk_bytes",         stats->junk_bytes },
+        { "address_changes",    stats->address_changes },
+        { "callbacks",          stats->callbacks },
+        { "flushes",            stats->flushes },
+#ifdef IHEX_STATS_CLOCK
+        { "callback_time",      stats->callback_time },
+#endif
+    };
+    unsigned i;
+
+    for (i = 0; i < RECORD_NAME_COUNT; ++i) {
+        // the unknown types 6 and 7 are counted together as "other"
+        const unsigned long long count = stats->records[i] +
+            ((i == RECORD_NAME_COUNT - 1U) ? stats->records[i + 1U] : 0U);
+        if (json) {
+            (void) fprintf(file, "%s\"%s\":%llu", i ? "," : "{\"records\":{",
+                           record_names[i], count);
+        } else {
+            (void) fprintf(file, "records_%s: %llu\n", record_names[i], count);
+        }
+    }
+    for (i = 0; i < sizeof(counters) / sizeof(counters[0]); ++i) {
+        (void) fprintf(file, json ? "%s\"%s\":%llu" : "%s%s: %llu\n",
+                       json ? (i ? "," : "},") : "",
+                       counters[i].name, counters[i].value);
+    }
+    if (json) {
+        (void) fputs("}\n", file);
+    }
+    return 1;
+}
+
+#else // !IHEX_ENABLE_STATS
+
+ihex_bool_t
+ihex_stats_print (const struct ihex_state * const ihex, FILE *file,
+                  const ihex_bool_t json) {
+    (void) ihex;
+    (void) file;
+    (void) json;
+    return 0;
+}
+
+#endif // IHEX_ENABLE_STATS
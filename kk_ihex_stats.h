@@ -0,0 +1,49 @@
+/*
+ * kk_ihex_stats.h: Print the statistics counted by the IHEX library when
+ * it is built with `IHEX_ENABLE_STATS` (see `kk_ihex.h`).
+ *
+ * The statistics of a `struct ihex_state`, used either for reading or for
+ * writing, are printed after the last call of `ihex_end_read` or
+ * `ihex_end_write` with:
+ *
+ *      ihex_stats_print(&ihex, stderr, false);
+ *
+ * which prints one `name: value` line per counter, e.g.:
+ *
+ *      records_data: 2048
+ *      records_end_of_file: 1
+ *      data_bytes: 65536
+ *      checksum_errors: 0
+ *
+ * or, with `json` true, the same counters as one line of JSON, with the
+ * records by type as an object, e.g.:
+ *
+ *      {"records":{"data":2048,"end_of_file":1,...},"data_bytes":65536,...}
+ *
+ * The counter `callback_time` is only present if `IHEX_STATS_CLOCK` is
+ * defined.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_IHEX_STATS_H
+#define KK_IHEX_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "kk_ihex.h"
+#include <stdio.h>
+
+// Print the statistics of `ihex` to `file`, as JSON if `json` is true.
+// Returns false if the statistics are not enabled (nothing is printed).
+ihex_bool_t ihex_stats_print(const struct ihex_state *ihex, FILE *file,
+                             ihex_bool_t json);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_IHEX_STATS_H
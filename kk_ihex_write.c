@@ -9,22 +9,117 @@
  */
 
 #include "kk_ihex_write.h"
+#include "kk_hex_codec.h"
+#include "kk_ihex_probe.h"
 
 #define IHEX_START ':'
 
 #define ADDRESS_HIGH_MASK ((ihex_address_t) 0xFFFF0000U)
 #define ADDRESS_HIGH_BYTES(addr) ((addr) >> 16)
 
-#define HEX_DIGIT(n) ((char)((n) + (((n) < 10) ? '0' : ('A' - 10))))
-
+#ifdef IHEX_REENTRANT_WRITE
+#ifdef IHEX_EXTERNAL_WRITE_BUFFER
+#error "IHEX_REENTRANT_WRITE and IHEX_EXTERNAL_WRITE_BUFFER are exclusive"
+#endif
+// each function that writes a line has its own buffer on the stack
+#define IHEX_LOCAL_WRITE_BUFFER char ihex_write_buffer[IHEX_WRITE_BUFFER_LENGTH];
+#else
+#define IHEX_LOCAL_WRITE_BUFFER
 #ifndef IHEX_EXTERNAL_WRITE_BUFFER
 static char ihex_write_buffer[IHEX_WRITE_BUFFER_LENGTH];
 #endif
+#endif
 
 #if IHEX_MAX_OUTPUT_LINE_LENGTH > IHEX_LINE_MAX_LENGTH
 #error "IHEX_MAX_OUTPUT_LINE_LENGTH > IHEX_LINE_MAX_LENGTH"
 #endif
 
+// Call `ihex_flush_buffer` with `buffer` to `eptr`, containing a record
+// of `type`, and assign the result with `result` (e.g., `sent =`), if any
+#define IHEX_FLUSH(ihex, type, buffer, eptr, result) do { \
+        IHEX_PROBE3(flush_start, ihex, type, (eptr) - (buffer)); \
+        IHEX_STATS_CALL(ihex, flushes, result ihex_flush_buffer(ihex, buffer, eptr)); \
+        IHEX_PROBE1(flush_end, ihex); \
+    } while (0)
+
+#ifdef IHEX_NONBLOCKING_WRITE
+// Record type passed to the `flush_start` probe for pending output
+#define IHEX_PENDING_OUTPUT 0xFFU
+
+// Pass the record of `type` in `ihex_write_buffer` (ending at `w`) to
+// `ihex_flush_buffer`, or queue it after any pending output
+#define IHEX_FLUSH_RECORD(ihex, type, w) do { \
+        IHEX_STATS_ADD(ihex, records[type], 1U); \
+        ihex_send(ihex, type, ihex_write_buffer, w); \
+    } while (0)
+
+// Return `result` from the calling function if there is pending output
+// that can not be sent now
+#define IHEX_RETURN_IF_BLOCKED(ihex, result) do { \
+        if ((ihex)->pending_length && !ihex_write_resume(ihex)) { \
+            return (result); \
+        } \
+    } while (0)
+
+static void
+ihex_send (struct ihex_state * const ihex, const uint8_t type,
+           char *buffer, char * const eptr) {
+    (void) type; // only used by the probe
+    if (!ihex->pending_length) {
+        ihex_count_t sent;
+        IHEX_FLUSH(ihex, type, buffer, eptr, sent =);
+        if (sent > 0) {
+            buffer = (sent < eptr - buffer) ? buffer + sent : eptr;
+        }
+    }
+    // keep the unsent part, a write function can not generate more
+    // than `IHEX_PENDING_LENGTH` characters of output in one call
+    {
+        char * restrict w = ihex->pending + ihex->pending_length;
+        ihex->pending_length += (uint16_t) (eptr - buffer);
+        while (buffer != eptr) {
+            *w++ = *buffer++;
+        }
+    }
+}
+
+ihex_bool_t
+ihex_write_resume (struct ihex_state * const ihex) {
+    const ihex_count_t length = ihex->pending_length;
+    ihex_count_t sent;
+
+    if (!length) {
+        return 1;
+    }
+    IHEX_FLUSH(ihex, IHEX_PENDING_OUTPUT, ihex->pending, ihex->pending + length, sent =);
+    if (sent <= 0) {
+        return 0;
+    }
+    if (sent < length) {
+        // move the rest to the beginning
+        const char * restrict r = ihex->pending + sent;
+        char * restrict w = ihex->pending;
+        sent = length - sent;
+        ihex->pending_length = (uint16_t) sent;
+        do {
+            *w++ = *r++;
+        } while (--sent);
+        return 0;
+    }
+    ihex->pending_length = 0;
+    return 1;
+}
+#else
+// Pass the record of `type` in `ihex_write_buffer` (ending at `w`) to
+// `ihex_flush_buffer`
+#define IHEX_FLUSH_RECORD(ihex, type, w) do { \
+        IHEX_STATS_ADD(ihex, records[type], 1U); \
+        IHEX_FLUSH(ihex, type, ihex_write_buffer, w, ); \
+    } while (0)
+
+#define IHEX_RETURN_IF_BLOCKED(ihex, result) ((void) 0)
+#endif
+
 void
 ihex_init (struct ihex_state * const ihex) {
     ihex->address = 0;
@@ -34,16 +129,13 @@ ihex_init (struct ihex_state * const ihex) {
     ihex->flags = 0;
     ihex->line_length = IHEX_DEFAULT_OUTPUT_LINE_LENGTH;
     ihex->length = 0;
+#ifdef IHEX_NONBLOCKING_WRITE
+    ihex->pending_length = 0;
+#endif
+    IHEX_STATS_RESET(ihex);
 }
 
-static char *
-ihex_buffer_byte (char * restrict w, const uint8_t byte) {
-    uint8_t n = (byte & 0xF0U) >> 4; // high nybble
-    *w++ = HEX_DIGIT(n);
-    n = byte & 0x0FU; // low nybble
-    *w++ = HEX_DIGIT(n);
-    return w;
-}
+#define ihex_buffer_byte hex_buffer_byte
 
 static char *
 ihex_buffer_word (char * restrict w, const uint_fast16_t word,
@@ -67,6 +159,7 @@ ihex_buffer_newline (char * restrict w) {
 
 static void
 ihex_write_end_of_file (struct ihex_state * const ihex) {
+    IHEX_LOCAL_WRITE_BUFFER
     char * restrict w = ihex_write_buffer;
     *w++ = IHEX_START; // :
 #if 1
@@ -82,13 +175,14 @@ ihex_write_end_of_file (struct ihex_state * const ihex) {
     w = ihex_buffer_byte(w, (uint8_t)~IHEX_END_OF_FILE_RECORD + 1U); // checksum
 #endif
     w = ihex_buffer_newline(w);
-    ihex_flush_buffer(ihex, ihex_write_buffer, w);
+    IHEX_FLUSH_RECORD(ihex, IHEX_END_OF_FILE_RECORD, w);
 }
 
 static void
 ihex_write_extended_address (struct ihex_state * const ihex,
                              const ihex_segment_t address,
                              const uint8_t type) {
+    IHEX_LOCAL_WRITE_BUFFER
     char * restrict w = ihex_write_buffer;
     uint8_t sum = type + 2U;
 
@@ -100,13 +194,37 @@ ihex_write_extended_address (struct ihex_state * const ihex,
     w = ihex_buffer_word(w, address, &sum); // high bytes of address
     w = ihex_buffer_byte(w, (uint8_t)~sum + 1U); // checksum
     w = ihex_buffer_newline(w);
-    ihex_flush_buffer(ihex, ihex_write_buffer, w);
+    IHEX_STATS_ADD(ihex, address_changes, 1U);
+    IHEX_PROBE3(address_change, ihex, type, address);
+    IHEX_FLUSH_RECORD(ihex, type, w);
+}
+
+static void
+ihex_write_start_record (struct ihex_state * const ihex,
+                         const uint_fast16_t high,
+                         const uint_fast16_t low,
+                         const uint8_t type) {
+    IHEX_LOCAL_WRITE_BUFFER
+    char * restrict w = ihex_write_buffer;
+    uint8_t sum = type + 4U;
+
+    *w++ = IHEX_START;              // :
+    w = ihex_buffer_byte(w, 4U);    // length
+    w = ihex_buffer_byte(w, 0);     // 16-bit address msb
+    w = ihex_buffer_byte(w, 0);     // 16-bit address lsb
+    w = ihex_buffer_byte(w, type);  // record type
+    w = ihex_buffer_word(w, high, &sum); // segment or high bytes of address
+    w = ihex_buffer_word(w, low, &sum);  // offset or low bytes of address
+    w = ihex_buffer_byte(w, (uint8_t)~sum + 1U); // checksum
+    w = ihex_buffer_newline(w);
+    IHEX_FLUSH_RECORD(ihex, type, w);
 }
 
 // Write out `ihex->data`
 //
 static void
 ihex_write_data (struct ihex_state * const ihex) {
+    IHEX_LOCAL_WRITE_BUFFER
     uint_fast8_t len = ihex->length;
     uint8_t sum = len;
     char * restrict w = ihex_write_buffer;
@@ -114,6 +232,8 @@ ihex_write_data (struct ihex_state * const ihex) {
     if (!len) {
         return;
     }
+    IHEX_STATS_ADD(ihex, data_bytes, len);
+    IHEX_PROBE3(write_data_start, ihex, ihex->address, len);
 
     if (ihex->flags & IHEX_FLAG_ADDRESS_OVERFLOW) {
         ihex_write_extended_address(ihex, ADDRESS_HIGH_BYTES(ihex->address),
@@ -157,11 +277,13 @@ ihex_write_data (struct ihex_state * const ihex) {
     w = ihex_buffer_byte(w, ~sum + 1U);
 
     w = ihex_buffer_newline(w);
-    ihex_flush_buffer(ihex, ihex_write_buffer, w);
+    IHEX_FLUSH_RECORD(ihex, IHEX_DATA_RECORD, w);
+    IHEX_PROBE1(write_data_end, ihex);
 }
 
-void
+ihex_bool_t
 ihex_write_at_address (struct ihex_state * const ihex, ihex_address_t address) {
+    IHEX_RETURN_IF_BLOCKED(ihex, 0);
     if (ihex->length) {
         // flush any existing data
         ihex_write_data(ihex);
@@ -177,6 +299,7 @@ ihex_write_at_address (struct ihex_state * const ihex, ihex_address_t address) {
 
     ihex->address = address;
     ihex_set_output_line_length(ihex, ihex->line_length);
+    return 1;
 }
 
 void
@@ -194,51 +317,103 @@ ihex_set_output_line_length (struct ihex_state * const ihex,
 }
 
 #ifndef IHEX_DISABLE_SEGMENTS
-void
+ihex_bool_t
 ihex_write_at_segment (struct ihex_state * const ihex,
                        ihex_segment_t segment,
                        ihex_address_t address) {
-    ihex_write_at_address(ihex, address);
+    if (!ihex_write_at_address(ihex, address)) {
+        return 0;
+    }
     if (ihex->segment != segment) {
         // clear segment
         ihex_write_extended_address(ihex, (ihex->segment = segment),
                                     IHEX_EXTENDED_SEGMENT_ADDRESS_RECORD);
     }
+    return 1;
 }
 #endif
 
-void
+ihex_bool_t
 ihex_write_byte (struct ihex_state * const ihex, const int byte) {
     if (ihex->line_length <= ihex->length) {
+        IHEX_RETURN_IF_BLOCKED(ihex, 0);
         ihex_write_data(ihex);
     }
     ihex->data[(ihex->length)++] = (uint8_t) byte;
+    return 1;
 }
 
-void
-ihex_write_bytes (struct ihex_state * restrict const ihex,
+size_t
+ihex_write_block (struct ihex_state * restrict const ihex,
                   const void * restrict buf,
-                  ihex_count_t count) {
+                  size_t count) {
     const uint8_t *r = (const uint8_t *) buf;
-    while (count > 0) {
+    const size_t total = count;
+    while (count) {
         if (ihex->line_length > ihex->length) {
             uint_fast8_t i = ihex->line_length - ihex->length;
             uint8_t *w = ihex->data + ihex->length;
-            i = ((ihex_count_t) i > count) ? (uint_fast8_t) count : i;
+            i = ((size_t) i > count) ? (uint_fast8_t) count : i;
             count -= i;
             ihex->length += i;
             do {
                 *w++ = *r++;
             } while (--i);
         } else {
+            IHEX_RETURN_IF_BLOCKED(ihex, total - count);
             ihex_write_data(ihex);
         }
     }
+    return total;
 }
 
-void
+ihex_count_t
+ihex_write_bytes (struct ihex_state * restrict const ihex,
+                  const void * restrict buf,
+                  ihex_count_t count) {
+    return (count > 0) ? (ihex_count_t) ihex_write_block(ihex, buf, (size_t) count) : 0;
+}
+
+ihex_bool_t
+ihex_write_start_address (struct ihex_state * const ihex,
+                          const ihex_address_t address) {
+    IHEX_RETURN_IF_BLOCKED(ihex, 0);
+    ihex_write_data(ihex); // flush any pending data
+    ihex_write_start_record(ihex, ADDRESS_HIGH_BYTES(address),
+                            address & 0xFFFFU,
+                            IHEX_START_LINEAR_ADDRESS_RECORD);
+    return 1;
+}
+
+#ifndef IHEX_DISABLE_SEGMENTS
+ihex_bool_t
+ihex_write_start_segment_address (struct ihex_state * const ihex,
+                                  const ihex_segment_t segment,
+                                  const uint_least16_t offset) {
+    IHEX_RETURN_IF_BLOCKED(ihex, 0);
+    ihex_write_data(ihex); // flush any pending data
+    ihex_write_start_record(ihex, segment, offset,
+                            IHEX_START_SEGMENT_ADDRESS_RECORD);
+    return 1;
+}
+#endif
+
+ihex_bool_t
 ihex_end_write (struct ihex_state * const ihex) {
+#ifdef IHEX_NONBLOCKING_WRITE
+    if (ihex->flags & IHEX_FLAG_END_WRITTEN) {
+        // called again to send the rest
+        return ihex_write_resume(ihex);
+    }
+    IHEX_RETURN_IF_BLOCKED(ihex, 0);
     ihex_write_data(ihex); // flush any remaining data
     ihex_write_end_of_file(ihex);
+    ihex->flags |= IHEX_FLAG_END_WRITTEN;
+    return !ihex->pending_length;
+#else
+    ihex_write_data(ihex); // flush any remaining data
+    ihex_write_end_of_file(ihex);
+    return 1;
+#endif
 }
 
@@ -39,6 +39,21 @@
  * used for writing, i.e., multiple threads must not write simultaneously
  * (but multiple writes may be interleaved).
  *
+ * Each output has its own `struct ihex_state`, so any number of outputs
+ * can be written at the same time, e.g., one for each ROM chip. To tell
+ * them apart in `ihex_flush_buffer`, the state can be embedded as the
+ * first member of a larger struct, such as:
+ *
+ *      struct hex_output {
+ *          struct ihex_state ihex;
+ *          FILE *file;
+ *      };
+ *
+ *      void ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+ *          *eptr = '\0';
+ *          (void) fputs(buffer, ((struct hex_output *) ihex)->file);
+ *      }
+ *
  *
  *      CONSERVING MEMORY
  *      -----------------
@@ -58,6 +73,12 @@
  * no advantage to this unless something else, mutually exclusive with
  * IHEX writing, can share the memory.
  *
+ * To write from several threads at the same time (each with its own
+ * `struct ihex_state`), define `IHEX_REENTRANT_WRITE`, and the buffer is
+ * allocated on the stack of each write function instead, i.e., this costs
+ * `IHEX_WRITE_BUFFER_LENGTH` bytes of stack during writing but no static
+ * memory. This can not be combined with `IHEX_EXTERNAL_WRITE_BUFFER`.
+ *
  * If you are reading IHEX as well, then you'll end up limiting the
  * maximum length of line that can be read. In that case you may wish to
  * define `IHEX_MAX_OUTPUT_LINE_LENGTH` as smaller to decrease the
@@ -65,6 +86,49 @@
  * reading any IHEX file.
  *
  *
+ *      NON-BLOCKING OUTPUT
+ *      -------------------
+ *
+ * Normally `ihex_flush_buffer` must consume the entire buffer before it
+ * returns, i.e., it blocks if the output is slow. If the library is built
+ * with `IHEX_NONBLOCKING_WRITE` defined, `ihex_flush_buffer` instead
+ * returns the number of characters it actually sent, which may be less
+ * than the length of the buffer, or even zero (e.g., when `write` on a
+ * non-blocking file descriptor fails with `EAGAIN`). The unsent part is
+ * kept as pending output in the `struct ihex_state`, and output that is
+ * produced while something is pending is appended to it.
+ *
+ * Each write function first tries to send any pending output, and if
+ * some of it still remains unsent, the function does nothing and returns
+ * false, i.e., the call must be repeated later (such as when the output
+ * is writable again). The exception is `ihex_write_bytes`, which returns
+ * the number of bytes it accepted: data is accepted as long as it fits
+ * the current line, so the rest must be written again later starting from
+ * the returned offset. `ihex_write_resume` sends the pending output without
+ * writing anything new, and `ihex_end_write` returns true only once all
+ * output, including the end of file record, has been sent; it may be
+ * called repeatedly until then. For example, with an event loop:
+ *
+ *      // when the output is writable:
+ *      done += ihex_write_bytes(&ihex, data + done, length - done);
+ *      if (done == length && ihex_end_write(&ihex)) {
+ *          // finished
+ *      }
+ *
+ *      ihex_count_t ihex_flush_buffer(struct ihex_state *ihex,
+ *                                     char *buffer, char *eptr) {
+ *          ssize_t sent = write(((struct hex_output *) ihex)->fd,
+ *                               buffer, eptr - buffer);
+ *          return (sent < 0) ? 0 : (ihex_count_t) sent;
+ *      }
+ *
+ * The pending output costs `IHEX_PENDING_LENGTH` bytes in every
+ * `struct ihex_state` (a data record and two short records), and all
+ * modules need to be built with the same option. Note that while output
+ * is pending, `buffer` may point to the pending output rather than to the
+ * write buffer.
+ *
+ *
  * Copyright (c) 2013-2019 Kimmo Kulovesi, https://arkku.com/
  * Provided with absolutely no warranty, use at your own risk only.
  * Use and distribute freely, mark modified copies as such.
@@ -113,18 +177,34 @@ void ihex_init(struct ihex_state *ihex);
 // This can also be used to skip to a new address without calling
 // `ihex_end_write`; this allows writing sparse output.
 //
-void ihex_write_at_address(struct ihex_state *ihex, ihex_address_t address);
+// The write functions return true, unless non-blocking output (see above)
+// is blocked, in which case nothing is done and the call must be repeated.
+//
+ihex_bool_t ihex_write_at_address(struct ihex_state *ihex, ihex_address_t address);
 
 // Write a single byte
-void ihex_write_byte(struct ihex_state *ihex, int b);
+ihex_bool_t ihex_write_byte(struct ihex_state *ihex, int b);
+
+// Write `count` bytes from `data`, returns the number of bytes accepted,
+// which is less than `count` only if non-blocking output is blocked
+ihex_count_t ihex_write_bytes(struct ihex_state * restrict ihex,
+                              const void * restrict data,
+                              ihex_count_t count);
+
+// Write `count` bytes from `data` as `ihex_write_bytes` does, but with the
+// count as `size_t`, e.g., for a whole file mapped into memory
+size_t ihex_write_block(struct ihex_state * restrict ihex,
+                        const void * restrict data,
+                        size_t count);
 
-// Write `count` bytes from `data`
-void ihex_write_bytes(struct ihex_state * restrict ihex,
-                      const void * restrict data,
-                      ihex_count_t count);
+// End writing (flush buffers, write end of file record), returns true
+// once all of the output has been passed to `ihex_flush_buffer`
+ihex_bool_t ihex_end_write(struct ihex_state *ihex);
 
-// End writing (flush buffers, write end of file record)
-void ihex_end_write(struct ihex_state *ihex);
+// Write a start linear address record (e.g., the entry point of a program)
+// with the 32-bit `address`, after writing any pending data. This should
+// be done at most once, usually right before `ihex_end_write`.
+ihex_bool_t ihex_write_start_address(struct ihex_state *ihex, ihex_address_t address);
 
 // Called whenever the global, internal write buffer needs to be flushed by
 // the write functions. The implementation is NOT provided by this library;
@@ -143,8 +223,20 @@ void ihex_end_write(struct ihex_state *ihex);
 // Note that the contents of `buffer` can become invalid immediately after
 // this function returns - the data must be copied if it needs to be preserved!
 //
+#ifdef IHEX_NONBLOCKING_WRITE
+// With `IHEX_NONBLOCKING_WRITE`, the number of characters actually sent
+// from the beginning of `buffer` is returned (see "NON-BLOCKING OUTPUT"
+// above). The character at `eptr` may still be modified.
+extern ihex_count_t ihex_flush_buffer(struct ihex_state *ihex,
+                                      char *buffer, char *eptr);
+
+// Try to send the pending output without writing anything new, returns
+// true if there is no more output pending
+ihex_bool_t ihex_write_resume(struct ihex_state *ihex);
+#else
 extern void ihex_flush_buffer(struct ihex_state *ihex,
                               char *buffer, char *eptr);
+#endif
 
 // As `ihex_write_at_address`, but specify a segment selector. Note that
 // segments are not automatically incremented when the 16-bit address
@@ -154,9 +246,15 @@ extern void ihex_flush_buffer(struct ihex_state *ihex,
 // segment needs to be changed.
 //
 #ifndef IHEX_DISABLE_SEGMENTS
-void ihex_write_at_segment(struct ihex_state *ihex,
-                           ihex_segment_t segment,
-                           ihex_address_t address);
+ihex_bool_t ihex_write_at_segment(struct ihex_state *ihex,
+                                  ihex_segment_t segment,
+                                  ihex_address_t address);
+
+// As `ihex_write_start_address`, but write a start segment address record,
+// i.e., the 80x86 CS:IP register values `segment` and `offset`.
+ihex_bool_t ihex_write_start_segment_address(struct ihex_state *ihex,
+                                             ihex_segment_t segment,
+                                             uint_least16_t offset);
 #endif
 
 // Set the output line length to `length` - may be safely called only right
@@ -0,0 +1,412 @@
+/*
+ * kk_lanes.c: Split data into byte lanes and merge them back.
+ *
+ * See the header `kk_lanes.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_lanes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+void
+lanes_deinterleave (uint8_t * const *lane, const uint8_t *input,
+                    const size_t group_count,
+                    const unsigned lane_count, const unsigned lane_width) {
+    size_t i;
+
+    if (lane_width == 1) {
+        switch (lane_count) {
+        case 2: {
+            uint8_t * restrict l0 = lane[0];
+            uint8_t * restrict l1 = lane[1];
+            const uint8_t * restrict r = input;
+            for (i = 0; i < group_count; ++i) {
+                l0[i] = r[0];
+                l1[i] = r[1];
+                r += 2;
+            }
+            return;
+        }
+        case 4: {
+            uint8_t * restrict l0 = lane[0];
+            uint8_t * restrict l1 = lane[1];
+            uint8_t * restrict l2 = lane[2];
+            uint8_t * restrict l3 = lane[3];
+            const uint8_t * restrict r = input;
+            for (i = 0; i < group_count; ++i) {
+                l0[i] = r[0];
+                l1[i] = r[1];
+                l2[i] = r[2];
+                l3[i] = r[3];
+                r += 4;
+            }
+            return;
+        }
+        case 8: {
+            uint8_t * restrict l0 = lane[0];
+            uint8_t * restrict l1 = lane[1];
+            uint8_t * restrict l2 = lane[2];
+            uint8_t * restrict l3 = lane[3];
+            uint8_t * restrict l4 = lane[4];
+            uint8_t * restrict l5 = lane[5];
+            uint8_t * restrict l6 = lane[6];
+            uint8_t * restrict l7 = lane[7];
+            const uint8_t * restrict r = input;
+            for (i = 0; i < group_count; ++i) {
+                l0[i] = r[0];
+                l1[i] = r[1];
+                l2[i] = r[2];
+                l3[i] = r[3];
+                l4[i] = r[4];
+                l5[i] = r[5];
+                l6[i] = r[6];
+                l7[i] = r[7];
+                r += 8;
+            }
+            return;
+        }
+        default:
+            break;
+        }
+    } else if (lane_width == 2 && lane_count == 2) {
+        uint8_t * restrict l0 = lane[0];
+        uint8_t * restrict l1 = lane[1];
+        const uint8_t * restrict r = input;
+        for (i = 0; i < group_count * 2; i += 2) {
+            l0[i] = r[0];
+            l0[i + 1] = r[1];
+            l1[i] = r[2];
+            l1[i + 1] = r[3];
+            r += 4;
+        }
+        return;
+    }
+
+    {
+        // generic lane count and width
+        const size_t group_size = (size_t) lane_count * lane_width;
+        unsigned n;
+        for (n = 0; n < lane_count; ++n) {
+            uint8_t * restrict w = lane[n];
+            const uint8_t * restrict r = input + (size_t) n * lane_width;
+            for (i = 0; i < group_count; ++i) {
+                (void) memcpy(w, r, lane_width);
+                w += lane_width;
+                r += group_size;
+            }
+        }
+    }
+}
+
+void
+lanes_interleave (uint8_t *output, const uint8_t * const *lane,
+                  const size_t group_count,
+                  const unsigned lane_count, const unsigned lane_width) {
+    size_t i;
+
+    if (lane_width == 1) {
+        switch (lane_count) {
+        case 2: {
+            const uint8_t * restrict l0 = lane[0];
+            const uint8_t * restrict l1 = lane[1];
+            uint8_t * restrict w = output;
+            for (i = 0; i < group_count; ++i) {
+                w[0] = l0[i];
+                w[1] = l1[i];
+                w += 2;
+            }
+            return;
+        }
+        case 4: {
+            const uint8_t * restrict l0 = lane[0];
+            const uint8_t * restrict l1 = lane[1];
+            const uint8_t * restrict l2 = lane[2];
+            const uint8_t * restrict l3 = lane[3];
+            uint8_t * restrict w = output;
+            for (i = 0; i < group_count; ++i) {
+                w[0] = l0[i];
+                w[1] = l1[i];
+                w[2] = l2[i];
+                w[3] = l3[i];
+                w += 4;
+            }
+            return;
+        }
+        case 8: {
+            const uint8_t * restrict l0 = lane[0];
+            const uint8_t * restrict l1 = lane[1];
+            const uint8_t * restrict l2 = lane[2];
+            const uint8_t * restrict l3 = lane[3];
+            const uint8_t * restrict l4 = lane[4];
+            const uint8_t * restrict l5 = lane[5];
+            const uint8_t * restrict l6 = lane[6];
+            const uint8_t * restrict l7 = lane[7];
+            uint8_t * restrict w = output;
+            for (i = 0; i < group_count; ++i) {
+                w[0] = l0[i];
+                w[1] = l1[i];
+                w[2] = l2[i];
+                w[3] = l3[i];
+                w[4] = l4[i];
+                w[5] = l5[i];
+                w[6] = l6[i];
+                w[7] = l7[i];
+                w += 8;
+            }
+            return;
+        }
+        default:
+            break;
+        }
+    } else if (lane_width == 2 && lane_count == 2) {
+        const uint8_t * restrict l0 = lane[0];
+        const uint8_t * restrict l1 = lane[1];
+        uint8_t * restrict w = output;
+        for (i = 0; i < group_count * 2; i += 2) {
+            w[0] = l0[i];
+            w[1] = l0[i + 1];
+            w[2] = l1[i];
+            w[3] = l1[i + 1];
+            w += 4;
+        }
+        return;
+    }
+
+    {
+        // generic lane count and width
+        const size_t group_size = (size_t) lane_count * lane_width;
+        unsigned n;
+        for (n = 0; n < lane_count; ++n) {
+            const uint8_t * restrict r = lane[n];
+            uint8_t * restrict w = output + (size_t) n * lane_width;
+            for (i = 0; i < group_count; ++i) {
+                (void) memcpy(w, r, lane_width);
+                r += lane_width;
+                w += group_size;
+            }
+        }
+    }
+}
+
+// Read up to `size` bytes into `buffer`, stopping short only at the end
+// of input or on error.
+//
+static size_t
+read_block (FILE *file, uint8_t *buffer, const size_t size) {
+    size_t count = 0;
+    do {
+        size_t n_read = fread(buffer + count, 1, size - count, file);
+        if (!n_read) {
+            break;
+        }
+        count += n_read;
+    } while (count < size);
+    return count;
+}
+
+// The number of bytes in lane `n` of a partial group of `remainder` bytes.
+//
+static size_t
+partial_length (const size_t remainder, const unsigned n, const unsigned lane_width) {
+    const size_t offset = (size_t) n * lane_width;
+    if (remainder <= offset) {
+        return 0;
+    }
+    return (remainder - offset < lane_width) ? (remainder - offset) : lane_width;
+}
+
+bool
+lanes_split (FILE *infile, FILE * const *outfile,
+             const unsigned lane_count, const unsigned lane_width,
+             const enum swap_mode swap) {
+    const size_t group_size = (size_t) lane_count * lane_width;
+    const size_t block_size = LANES_BLOCK_SIZE * group_size;
+    uint8_t *input;
+    uint8_t *lane[LANES_MAX_COUNT];
+    bool success = true;
+    unsigned n;
+
+    if (!lane_count || lane_count > LANES_MAX_COUNT ||
+        !lane_width || lane_width > LANES_MAX_WIDTH) {
+        errno = EINVAL;
+        return false;
+    }
+    if (!(input = malloc(block_size * 2))) {
+        return false;
+    }
+    for (n = 0; n < lane_count; ++n) {
+        lane[n] = input + block_size + (size_t) n * LANES_BLOCK_SIZE * lane_width;
+    }
+
+    for (;;) {
+        const size_t count = read_block(infile, input, block_size);
+        size_t groups;
+        size_t remainder;
+
+        if (ferror(infile)) {
+            success = false;
+            break;
+        }
+        if (!count) {
+            break;
+        }
+
+        swap_bytes(input, count, swap);
+        groups = count / group_size;
+        remainder = count % group_size;
+        lanes_deinterleave(lane, input, groups, lane_count, lane_width);
+        for (n = 0; n < lane_count; ++n) {
+            size_t length = groups * lane_width;
+            if (remainder) {
+                // partial group at the end of input
+                const size_t part = partial_length(remainder, n, lane_width);
+                (void) memcpy(lane[n] + length,
+                              input + groups * group_size + (size_t) n * lane_width,
+                              part);
+                length += part;
+            }
+            if (length && fwrite(lane[n], 1, length, outfile[n]) != length) {
+                success = false;
+                break;
+            }
+        }
+        if (!success || count < block_size) {
+            break;
+        }
+    }
+
+    free(input);
+    return success;
+}
+
+// Check that the final block of lanes, `count[n]` bytes in each, is a
+// valid end of input without padding, i.e., either all lanes have the same
+// length or they end in a partial group. Returns the number of bytes of
+// output, or `(size_t) -1` if the lengths are not valid.
+//
+static size_t
+merge_length (FILE * const *infile, const size_t *count, const size_t lane_size,
+              const unsigned lane_count, const unsigned lane_width) {
+    const size_t group_size = (size_t) lane_count * lane_width;
+    size_t total = 0;
+    size_t groups;
+    size_t remainder;
+    unsigned n;
+
+    for (n = 0; n < lane_count; ++n) {
+        total += count[n];
+    }
+    groups = total / group_size;
+    remainder = total % group_size;
+    for (n = 0; n < lane_count; ++n) {
+        if (count[n] != groups * lane_width + partial_length(remainder, n, lane_width)) {
+            return (size_t) -1;
+        }
+        if (count[n] == lane_size) {
+            // a full lane must not continue past this block
+            const int c = getc(infile[n]);
+            if (c != EOF) {
+                (void) ungetc(c, infile[n]);
+                return (size_t) -1;
+            }
+        }
+    }
+    return total;
+}
+
+enum lanes_merge_result
+lanes_merge (FILE * const *infile, FILE *outfile,
+             const unsigned lane_count, const unsigned lane_width,
+             const int fill, const enum swap_mode swap) {
+    const size_t lane_size = LANES_BLOCK_SIZE * lane_width;
+    const size_t block_size = lane_size * lane_count;
+    enum lanes_merge_result result = LANES_MERGE_OK;
+    uint8_t *output;
+    uint8_t *lane[LANES_MAX_COUNT];
+    size_t count[LANES_MAX_COUNT];
+    unsigned n;
+
+    if (!lane_count || lane_count > LANES_MAX_COUNT ||
+        !lane_width || lane_width > LANES_MAX_WIDTH) {
+        errno = EINVAL;
+        return LANES_MERGE_ERROR;
+    }
+    if (!(output = malloc(block_size * 2))) {
+        return LANES_MERGE_ERROR;
+    }
+    for (n = 0; n < lane_count; ++n) {
+        lane[n] = output + block_size + (size_t) n * lane_size;
+    }
+
+    for (;;) {
+        size_t longest = 0;
+        size_t length;
+        bool is_full = true;
+
+        for (n = 0; n < lane_count; ++n) {
+            count[n] = read_block(infile[n], lane[n], lane_size);
+            if (ferror(infile[n])) {
+                result = LANES_MERGE_ERROR;
+                goto end_merge;
+            }
+            if (count[n] > longest) {
+                longest = count[n];
+            }
+            is_full = is_full && (count[n] == lane_size);
+        }
+
+        if (is_full) {
+            length = block_size;
+            lanes_interleave(output, (const uint8_t * const *) lane,
+                             LANES_BLOCK_SIZE, lane_count, lane_width);
+        } else if (fill != LANES_NO_FILL) {
+            // pad every lane to the longest, rounded up to the lane width
+            const size_t groups = (longest + lane_width - 1) / lane_width;
+            for (n = 0; n < lane_count; ++n) {
+                (void) memset(lane[n] + count[n], fill,
+                              groups * lane_width - count[n]);
+            }
+            length = groups * lane_count * lane_width;
+            lanes_interleave(output, (const uint8_t * const *) lane,
+                             groups, lane_count, lane_width);
+        } else {
+            const size_t group_size = (size_t) lane_count * lane_width;
+            size_t groups;
+            size_t remainder;
+
+            length = merge_length(infile, count, lane_size, lane_count, lane_width);
+            if (length == (size_t) -1) {
+                result = LANES_MERGE_UNEQUAL;
+                goto end_merge;
+            }
+            groups = length / group_size;
+            remainder = length % group_size;
+            lanes_interleave(output, (const uint8_t * const *) lane,
+                             groups, lane_count, lane_width);
+            for (n = 0; n < lane_count; ++n) {
+                // partial group at the end of input
+                (void) memcpy(output + groups * group_size + (size_t) n * lane_width,
+                              lane[n] + groups * lane_width,
+                              partial_length(remainder, n, lane_width));
+            }
+        }
+
+        swap_bytes(output, length, swap);
+        if (length && fwrite(output, 1, length, outfile) != length) {
+            result = LANES_MERGE_ERROR;
+            break;
+        }
+        if (!is_full && (fill == LANES_NO_FILL || !longest || longest < lane_size)) {
+            break;
+        }
+    }
+
+end_merge:
+    free(output);
+    return result;
+}
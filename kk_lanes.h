@@ -0,0 +1,91 @@
+/*
+ * kk_lanes.h: Split data into byte lanes and merge them back, e.g., for
+ * ROM images of a 16- or 32-bit bus that are programmed into separate
+ * 8-bit (or 16-bit) ROM chips.
+ *
+ * The data consists of groups of `lane_count` lanes, each `lane_width`
+ * bytes wide, the lowest address being in lane 0. For example, a 32-bit
+ * bus built from four 8-bit ROMs has 4 lanes of width 1, and a 32-bit bus
+ * built from two 16-bit ROMs has 2 lanes of width 2.
+ *
+ * The data is processed in large blocks, and the interleaving of lanes
+ * is done by loops specialised for the common lane counts and widths,
+ * which the compiler can vectorise.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_LANES_H
+#define KK_LANES_H
+
+#ifdef __cplusplus
+#ifndef restrict
+#define restrict
+#endif
+extern "C" {
+#endif
+
+#include "kk_swap.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Maximum number of lanes
+#define LANES_MAX_COUNT 8
+
+// Maximum width of a lane, in bytes
+#define LANES_MAX_WIDTH 2
+
+// Size of the blocks read and written (per lane)
+#define LANES_BLOCK_SIZE (64UL * 1024UL)
+
+// De-interleave `group_count` groups of lanes from `input` into the buffers
+// `lane[0]` to `lane[lane_count - 1]`.
+void lanes_deinterleave(uint8_t * const *lane, const uint8_t *input,
+                        size_t group_count,
+                        unsigned lane_count, unsigned lane_width);
+
+// Interleave `group_count` groups of lanes from the buffers `lane[0]` to
+// `lane[lane_count - 1]` into `output`, i.e., the inverse of
+// `lanes_deinterleave`.
+void lanes_interleave(uint8_t *output, const uint8_t * const *lane,
+                      size_t group_count,
+                      unsigned lane_count, unsigned lane_width);
+
+// Read all of `infile` and write each of its lanes into the corresponding
+// file of `outfile`. A partial group at the end of input is split as far
+// as it goes, i.e., the last lanes may be shorter. The input is swapped
+// according to `swap` (see `kk_swap.h`) before splitting. Returns false on
+// error (see `errno`).
+bool lanes_split(FILE *infile, FILE * const *outfile,
+                 unsigned lane_count, unsigned lane_width,
+                 enum swap_mode swap);
+
+// Pass as `fill` to `lanes_merge` to require the inputs to have
+// matching lengths instead of padding them
+#define LANES_NO_FILL (-1)
+
+enum lanes_merge_result {
+    LANES_MERGE_OK,
+    LANES_MERGE_ERROR,          // I/O error (see `errno`)
+    LANES_MERGE_UNEQUAL         // the inputs have different lengths
+};
+
+// Read the files of `infile` as lanes and write them interleaved into
+// `outfile`, i.e., the inverse of `lanes_split`. The lengths of the inputs
+// must be the same, except that they may end in a partial group as written
+// by `lanes_split`. If `fill` is not `LANES_NO_FILL`, shorter inputs are
+// instead padded with the byte `fill` to the length of the longest input,
+// rounded up to a full lane. The output is swapped according to `swap`
+// (see `kk_swap.h`) after merging.
+enum lanes_merge_result lanes_merge(FILE * const *infile, FILE *outfile,
+                                    unsigned lane_count, unsigned lane_width,
+                                    int fill, enum swap_mode swap);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_LANES_H
@@ -0,0 +1,135 @@
+/*
+ * kk_manifest.c: Per-block hash manifest of an image.
+ *
+ * See the header `kk_manifest.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_manifest.h"
+#include "kk_crc32.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+bool
+manifest_init (struct manifest * const manifest, FILE *file,
+               const unsigned long block_size, const uint8_t fill) {
+    manifest->file = file;
+    manifest->block_size = block_size;
+    manifest->block_address = 0;
+    manifest->block_used = false;
+    manifest->fill = fill;
+    manifest->entries = NULL;
+    manifest->entry_count = 0;
+    manifest->entry_capacity = 0;
+    if (!block_size) {
+        errno = EINVAL;
+        return false;
+    }
+    return (manifest->block = malloc(block_size)) != NULL;
+}
+
+static bool
+manifest_end_block (struct manifest * const manifest) {
+    struct manifest_entry *entry;
+
+    if (!manifest->block_used) {
+        return true;
+    }
+    if (manifest->entry_count == manifest->entry_capacity) {
+        size_t capacity = manifest->entry_capacity ? manifest->entry_capacity * 2 : 256;
+        entry = realloc(manifest->entries, capacity * sizeof(*entry));
+        if (!entry) {
+            return false;
+        }
+        manifest->entries = entry;
+        manifest->entry_capacity = capacity;
+    }
+    entry = manifest->entries + manifest->entry_count++;
+    entry->address = manifest->block_address;
+    entry->crc = crc32_final(crc32_update(CRC32_INITIAL, manifest->block,
+                                          manifest->block_size));
+    manifest->block_used = false;
+    return true;
+}
+
+bool
+manifest_write (struct manifest * const manifest, unsigned long address,
+                const uint8_t *data, size_t length) {
+    while (length) {
+        unsigned long offset = address - manifest->block_address;
+        size_t count;
+
+        if (!manifest->block_used || offset >= manifest->block_size) {
+            if (!manifest_end_block(manifest)) {
+                return false;
+            }
+            offset = address % manifest->block_size;
+            manifest->block_address = address - offset;
+            manifest->block_used = true;
+            (void) memset(manifest->block, manifest->fill, manifest->block_size);
+        }
+
+        count = manifest->block_size - offset;
+        if (count > length) {
+            count = length;
+        }
+        (void) memcpy(manifest->block + offset, data, count);
+        data += count;
+        address += count;
+        length -= count;
+    }
+    return true;
+}
+
+static int
+compare_entries (const void *a, const void *b) {
+    const unsigned long x = ((const struct manifest_entry *) a)->address;
+    const unsigned long y = ((const struct manifest_entry *) b)->address;
+    return (x > y) - (x < y);
+}
+
+bool
+manifest_end (struct manifest * const manifest) {
+    bool success = manifest_end_block(manifest);
+    size_t i;
+
+    free(manifest->block);
+    manifest->block = NULL;
+
+    if (success) {
+        qsort(manifest->entries, manifest->entry_count,
+              sizeof(*manifest->entries), compare_entries);
+        for (i = 1; i < manifest->entry_count; ++i) {
+            if (manifest->entries[i].address == manifest->entries[i - 1].address) {
+                (void) fprintf(stderr, "Manifest block 0x%08lx revisited, "
+                               "data is not in ascending order\n",
+                               manifest->entries[i].address);
+                errno = EINVAL;
+                success = false;
+                break;
+            }
+        }
+    }
+
+    if (success) {
+        (void) fprintf(manifest->file,
+                       "# kk_ihex manifest block_size %lu fill 0x%02X crc32\n",
+                       manifest->block_size, (unsigned) manifest->fill);
+        for (i = 0; i < manifest->entry_count; ++i) {
+            (void) fprintf(manifest->file, "%08lX %08lX\n",
+                           manifest->entries[i].address,
+                           (unsigned long) manifest->entries[i].crc);
+        }
+        success = !ferror(manifest->file);
+    }
+
+    free(manifest->entries);
+    manifest->entries = NULL;
+    manifest->entry_count = 0;
+    manifest->entry_capacity = 0;
+    return success;
+}
@@ -0,0 +1,74 @@
+/*
+ * kk_manifest.h: Per-block hash manifest of an image, for incremental
+ * (delta) flashing. The image address space is divided into blocks of
+ * `block_size` bytes (e.g., the flash sector size), and for every block
+ * that contains any data a line with the block address and the CRC-32
+ * of the whole block is output. Any bytes of the block not present in
+ * the data are hashed as the `fill` byte (i.e., the erased value of the
+ * flash). A programmer can then compare the manifests of the old and the
+ * new image, and erase and write only the blocks that differ.
+ *
+ * The manifest is computed while streaming, from the same data that is
+ * passed to `ihex_write_bytes` or received in `ihex_data_read`:
+ *      struct manifest manifest;
+ *      manifest_init(&manifest, manifest_file, 4096, 0xFF);
+ *      manifest_write(&manifest, address, data, length);
+ *      manifest_end(&manifest);
+ *
+ * Only one block is buffered at a time, so the data should be in
+ * ascending address order at least by block. A block that is revisited
+ * after another block has been written is detected as an error by
+ * `manifest_end`, since its hash would not describe the whole block.
+ *
+ * The output format is a comment line describing the parameters,
+ * followed by one line per block:
+ *      # kk_ihex manifest block_size 4096 fill 0xFF crc32
+ *      08000000 1C291CA3
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_MANIFEST_H
+#define KK_MANIFEST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define MANIFEST_DEFAULT_BLOCK_SIZE 4096UL
+#define MANIFEST_DEFAULT_FILL 0xFFU
+
+struct manifest_entry {
+    unsigned long   address;
+    uint_least32_t  crc;
+};
+
+struct manifest {
+    FILE                    *file;
+    uint8_t                 *block;
+    unsigned long           block_size;
+    unsigned long           block_address;
+    bool                    block_used;
+    uint8_t                 fill;
+    struct manifest_entry   *entries;
+    size_t                  entry_count;
+    size_t                  entry_capacity;
+};
+
+// Initialise `manifest` to write to `file` with the given block size and
+// fill byte. Returns false if memory could not be allocated.
+bool manifest_init(struct manifest *manifest, FILE *file,
+                   unsigned long block_size, uint8_t fill);
+
+// Add `length` bytes of `data` at `address` to the manifest
+bool manifest_write(struct manifest *manifest, unsigned long address,
+                    const uint8_t *data, size_t length);
+
+// Finish the last block and write the manifest to its file. Returns
+// false on error (see `errno`), e.g., if a block was revisited.
+bool manifest_end(struct manifest *manifest);
+
+#endif // !KK_MANIFEST_H
@@ -0,0 +1,311 @@
+/*
+ * kk_overlap.c: Detect data written more than once at the same address.
+ *
+ * See the header `kk_overlap.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_overlap.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OFFSET_MASK (OVERLAP_PAGE_SIZE - 1UL)
+#define BITMAP_SIZE (OVERLAP_PAGE_SIZE / 8U)
+#define TAG_COUNT (OVERLAP_PAGE_SIZE / OVERLAP_TAG_GRANULE)
+
+void
+overlap_init (struct overlap_map * const map) {
+    (void) memset(map, 0, sizeof(*map));
+}
+
+void
+overlap_free (struct overlap_map * const map) {
+    size_t i;
+    for (i = 0; i < map->page_count; ++i) {
+        free(map->pages[i].runs);
+        free(map->pages[i].bitmap);
+        free(map->pages[i].tags);
+    }
+    free(map->pages);
+    overlap_init(map);
+}
+
+// Report the overlap of `count` bytes of `data` at `address`, previously
+// written with `tag`, joining it with the previous one if they are adjacent
+// and have the same tag.
+//
+static void
+report_tagged (struct overlap_map * const map, const unsigned long address,
+               const uint8_t *data, const size_t count, const unsigned long tag) {
+    if (map->overlap_count && map->overlap_tag == tag &&
+        map->overlap_address + map->overlap_count == address) {
+        map->overlap_count += count;
+        return;
+    }
+    if (map->overlap_count) {
+        overlap_found(map, map->overlap_address, map->overlap_data,
+                      map->overlap_count, map->overlap_tag);
+    }
+    map->overlap_address = address;
+    map->overlap_data = data;
+    map->overlap_count = count;
+    map->overlap_tag = tag;
+}
+
+// Report the overlap of `count` bytes of `data` at the offset `first` of
+// `page`, split where the tags of the earlier writes change.
+//
+static void
+report (struct overlap_map * const map, const struct overlap_page * const page,
+        unsigned first, const uint8_t *data, size_t count) {
+    while (count) {
+        const unsigned long tag = (unsigned long) page->tags[first / OVERLAP_TAG_GRANULE];
+        size_t n = OVERLAP_TAG_GRANULE - (first % OVERLAP_TAG_GRANULE);
+        while (n < count && page->tags[(first + n) / OVERLAP_TAG_GRANULE] == tag) {
+            n += OVERLAP_TAG_GRANULE;
+        }
+        n = (n < count) ? n : count;
+        report_tagged(map, page->address + first, data, n, tag);
+        first += (unsigned) n;
+        data += n;
+        count -= n;
+    }
+}
+
+// Returns the page of `map` at `address`, adding it if it does not exist,
+// or NULL if memory could not be allocated.
+//
+static struct overlap_page *
+find_page (struct overlap_map * const map, const unsigned long address) {
+    size_t low = 0;
+    size_t high = map->page_count;
+
+    if (high && map->pages[map->last_page].address == address) {
+        return map->pages + map->last_page;
+    }
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2U;
+        if (map->pages[mid].address < address) {
+            low = mid + 1U;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == map->page_count || map->pages[low].address != address) {
+        struct overlap_page *page;
+        uint_least32_t *tags;
+        if (!(tags = calloc(TAG_COUNT, sizeof(*tags)))) {
+            return NULL;
+        }
+        if (map->page_count == map->page_capacity) {
+            const size_t capacity = map->page_capacity ? map->page_capacity * 2U : 16U;
+            if (!(page = realloc(map->pages, capacity * sizeof(*page)))) {
+                free(tags);
+                return NULL;
+            }
+            map->pages = page;
+            map->page_capacity = capacity;
+        }
+        page = map->pages + low;
+        (void) memmove(page + 1, page, (map->page_count - low) * sizeof(*page));
+        (void) memset(page, 0, sizeof(*page));
+        page->address = address;
+        page->tags = tags;
+        ++map->page_count;
+    }
+    map->last_page = low;
+    return map->pages + low;
+}
+
+// Mark the offsets `first` to `last` of the bitmap of `page` as written,
+// where `data` is the data at `first`.
+//
+static void
+mark_bitmap (struct overlap_map * const map, struct overlap_page * const page,
+             const unsigned first, const unsigned last, const uint8_t *data) {
+    unsigned offset = first;
+    unsigned overlap_first = 0;
+    bool overlap = false;
+
+    while (offset <= last) {
+        uint8_t * const byte = page->bitmap + (offset >> 3);
+        const unsigned bit = offset & 7U;
+        const unsigned n = (last - offset < 8U - bit) ? last - offset + 1U : 8U - bit;
+        const uint8_t mask = (uint8_t) (((1U << n) - 1U) << bit);
+        const uint8_t written = *byte & mask;
+        *byte |= mask;
+        if (written == mask) {
+            if (!overlap) {
+                overlap = true;
+                overlap_first = offset;
+            }
+        } else if (written) {
+            unsigned i;
+            for (i = 0; i < n; ++i) {
+                if (written & (1U << (bit + i))) {
+                    if (!overlap) {
+                        overlap = true;
+                        overlap_first = offset + i;
+                    }
+                } else if (overlap) {
+                    overlap = false;
+                    report(map, page, overlap_first,
+                           data + (overlap_first - first),
+                           offset + i - overlap_first);
+                }
+            }
+        } else if (overlap) {
+            overlap = false;
+            report(map, page, overlap_first,
+                   data + (overlap_first - first),
+                   offset - overlap_first);
+        }
+        offset += n;
+    }
+    if (overlap) {
+        report(map, page, overlap_first,
+               data + (overlap_first - first),
+               last + 1U - overlap_first);
+    }
+}
+
+// Convert the runs of `page` to a bitmap, returns false on error.
+//
+static bool
+convert_to_bitmap (struct overlap_page * const page) {
+    unsigned i;
+
+    if (!(page->bitmap = calloc(BITMAP_SIZE, 1))) {
+        return false;
+    }
+    for (i = 0; i < page->run_count; ++i) {
+        unsigned offset;
+        for (offset = page->runs[2 * i]; offset <= page->runs[2 * i + 1]; ++offset) {
+            page->bitmap[offset >> 3] |= (uint8_t) (1U << (offset & 7U));
+        }
+    }
+    free(page->runs);
+    page->runs = NULL;
+    page->run_count = page->run_capacity = 0;
+    return true;
+}
+
+// Mark the offsets `first` to `last` of the runs of `page` as written,
+// where `data` is the data at `first`. Returns false on error.
+//
+static bool
+mark_runs (struct overlap_map * const map, struct overlap_page * const page,
+           const unsigned first, const unsigned last, const uint8_t *data) {
+    const unsigned count = page->run_count;
+    uint16_t *runs = page->runs;
+    unsigned low = 0;
+    unsigned end;
+
+    // find the first run that ends no earlier than right before `first`,
+    // i.e., that may overlap or be joined with the new one
+    if (count && runs[2 * (count - 1) + 1] + 1U < first) {
+        low = count; // the usual case of ascending addresses
+    } else {
+        unsigned high = count;
+        while (low < high) {
+            const unsigned mid = (low + high) / 2U;
+            if (runs[2 * mid + 1] + 1U < first) {
+                low = mid + 1U;
+            } else {
+                high = mid;
+            }
+        }
+    }
+    for (end = low; end < count && runs[2 * end] <= last + 1U; ++end) {
+        const unsigned run_first = runs[2 * end];
+        const unsigned run_last = runs[2 * end + 1];
+        if (run_first <= last && run_last >= first) {
+            const unsigned overlap_first = (run_first > first) ? run_first : first;
+            const unsigned overlap_last = (run_last < last) ? run_last : last;
+            report(map, page, overlap_first,
+                   data + (overlap_first - first),
+                   overlap_last + 1U - overlap_first);
+        }
+    }
+
+    if (end == low) {
+        // a new run between the existing ones
+        if (count == page->run_capacity) {
+            const unsigned capacity = count ? count * 2U : 4U;
+            if (count >= OVERLAP_MAX_RUNS) {
+                if (!convert_to_bitmap(page)) {
+                    return false;
+                }
+                mark_bitmap(map, page, first, last, data);
+                return true;
+            }
+            if (!(runs = realloc(runs, capacity * 2U * sizeof(*runs)))) {
+                return false;
+            }
+            page->runs = runs;
+            page->run_capacity = capacity;
+        }
+        (void) memmove(runs + 2 * (low + 1U), runs + 2 * low,
+                       (count - low) * 2U * sizeof(*runs));
+        runs[2 * low] = (uint16_t) first;
+        runs[2 * low + 1] = (uint16_t) last;
+        ++page->run_count;
+    } else {
+        // join the runs `low` to `end - 1` and the new one
+        if (runs[2 * low] > first) {
+            runs[2 * low] = (uint16_t) first;
+        }
+        runs[2 * low + 1] = (runs[2 * (end - 1) + 1] > last) ?
+                            runs[2 * (end - 1) + 1] : (uint16_t) last;
+        (void) memmove(runs + 2 * (low + 1U), runs + 2 * end,
+                       (count - end) * 2U * sizeof(*runs));
+        page->run_count -= end - low - 1U;
+    }
+    return true;
+}
+
+// Set the tags of the offsets `first` to `last` of `page` to `tag`.
+//
+static void
+mark_tags (struct overlap_page * const page, const unsigned first,
+           const unsigned last, const unsigned long tag) {
+    unsigned granule;
+    for (granule = first / OVERLAP_TAG_GRANULE;
+         granule <= last / OVERLAP_TAG_GRANULE; ++granule) {
+        page->tags[granule] = (uint_least32_t) tag;
+    }
+}
+
+bool
+overlap_write (struct overlap_map * const map, unsigned long address,
+               const uint8_t *data, size_t count, const unsigned long tag) {
+    while (count) {
+        const unsigned first = (unsigned) (address & OFFSET_MASK);
+        const size_t n = (count < OVERLAP_PAGE_SIZE - first) ?
+                         count : OVERLAP_PAGE_SIZE - first;
+        struct overlap_page * const page = find_page(map, address - first);
+        if (!page) {
+            map->overlap_count = 0;
+            return false;
+        }
+        if (page->bitmap) {
+            mark_bitmap(map, page, first, first + (unsigned) n - 1U, data);
+        } else if (!mark_runs(map, page, first, first + (unsigned) n - 1U, data)) {
+            map->overlap_count = 0;
+            return false;
+        }
+        mark_tags(page, first, first + (unsigned) n - 1U, tag);
+        address += (unsigned long) n;
+        data += n;
+        count -= n;
+    }
+    if (map->overlap_count) {
+        overlap_found(map, map->overlap_address, map->overlap_data,
+                      map->overlap_count, map->overlap_tag);
+        map->overlap_count = 0;
+    }
+    return true;
+}
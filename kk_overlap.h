@@ -0,0 +1,104 @@
+/*
+ * kk_overlap.h: Detect data written more than once at the same address,
+ * e.g., overlapping records in an IHEX file.
+ *
+ * The set of addresses written is kept per 64 KiB page, in the manner of
+ * roaring bitmaps: each page that has been written has a container that
+ * is a sorted array of runs of consecutive addresses, or, once the page
+ * has too many runs for that to be smaller, a bitmap of its 65536 bytes.
+ * Hence data written in ascending order takes only a few bytes per page,
+ * and even a sparse image spread over the whole 32-bit address space only
+ * needs memory for the pages that have data.
+ *
+ * Each write has a tag, e.g., the line number of the input, and the tag
+ * of the last write is also kept for every `OVERLAP_TAG_GRANULE` bytes of
+ * each page. Each range of a write that had already been written is passed
+ * to `overlap_found`, which is implemented by the caller, along with the
+ * tag of the earlier write, e.g., to report the line numbers of both, and
+ * to compare the data with what was written before. If more than one write
+ * falls within the same granule, the tag of the last one is reported.
+ *
+ * The sequence to use an overlap map is:
+ *      struct overlap_map map;
+ *      overlap_init(&map);
+ *      overlap_write(&map, address, data, count, tag); // any number of times
+ *      overlap_free(&map);
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_OVERLAP_H
+#define KK_OVERLAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The size of the pages that have their own container
+#define OVERLAP_PAGE_SIZE 0x10000UL
+
+// The number of runs above which a page is converted to a bitmap (at
+// 4 bytes per run, this is the size of the bitmap)
+#define OVERLAP_MAX_RUNS (OVERLAP_PAGE_SIZE / 8U / 4U)
+
+// The number of bytes that share the tag of the last write to them (the
+// usual length of an IHEX data record)
+#define OVERLAP_TAG_GRANULE 16U
+
+struct overlap_page {
+    unsigned long   address;        // the address of the page
+    uint16_t        *runs;          // pairs of first and last offset
+    uint8_t         *bitmap;        // a bit per offset, instead of `runs`
+    uint_least32_t  *tags;          // the last tag written per granule
+    unsigned        run_count;
+    unsigned        run_capacity;
+};
+
+struct overlap_map {
+    struct overlap_page *pages;     // in ascending order of address
+    size_t              page_count;
+    size_t              page_capacity;
+    size_t              last_page;  // the index of the page last written
+    // the overlap found but not yet reported, to join it with the next
+    const uint8_t       *overlap_data;
+    unsigned long       overlap_address;
+    size_t              overlap_count;
+    unsigned long       overlap_tag;
+};
+
+// Initialise `map` as empty
+void overlap_init(struct overlap_map *map);
+
+// Mark `count` bytes at `address` as written with `tag` (at most 32 bits),
+// and pass each range of them that had already been written to
+// `overlap_found`. The `data` is only passed on to `overlap_found`.
+// Returns false on error (see `errno`), i.e., if memory could not be
+// allocated.
+bool overlap_write(struct overlap_map *map, unsigned long address,
+                   const uint8_t *data, size_t count, unsigned long tag);
+
+// Free the memory used by `map`
+void overlap_free(struct overlap_map *map);
+
+// Called with each range of `count` bytes at `address` that had already
+// been written, in ascending order of address, during `overlap_write`
+// (adjacent ranges with the same `previous_tag` are joined, even across
+// pages). The `data` is the part of the data of that write at `address`,
+// and `previous_tag` is the tag of the earlier write. The implementation
+// is NOT provided by this library.
+extern void overlap_found(struct overlap_map *map,
+                          unsigned long address,
+                          const uint8_t *data,
+                          size_t count,
+                          unsigned long previous_tag);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_OVERLAP_H
@@ -0,0 +1,278 @@
+/*
+ * kk_ring.c: A single-producer, single-consumer ring buffer of blocks.
+ *
+ * See the header `kk_ring.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#if !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "kk_ring.h"
+#include <stdlib.h>
+
+#if (defined(__unix__) || defined(__APPLE__)) && defined(__GNUC__)
+#include <pthread.h>
+#define RING_THREADS
+#endif
+
+#ifdef RING_THREADS
+
+struct ring_thread {
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    bool            running;
+};
+
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define INCREMENT(x) ((void) __atomic_add_fetch(&(x), 1U, __ATOMIC_SEQ_CST))
+#define DECREMENT(x) ((void) __atomic_sub_fetch(&(x), 1U, __ATOMIC_SEQ_CST))
+
+bool
+ring_init (struct ring * const ring, const unsigned block_count) {
+    ring->blocks = malloc(block_count * sizeof(*ring->blocks));
+    ring->thread = malloc(sizeof(*ring->thread));
+    if (!block_count || !ring->blocks || !ring->thread) {
+        free(ring->blocks);
+        free(ring->thread);
+        return false;
+    }
+    if (pthread_mutex_init(&ring->thread->mutex, NULL)) {
+        free(ring->blocks);
+        free(ring->thread);
+        return false;
+    }
+    if (pthread_cond_init(&ring->thread->cond, NULL)) {
+        (void) pthread_mutex_destroy(&ring->thread->mutex);
+        free(ring->blocks);
+        free(ring->thread);
+        return false;
+    }
+    ring->thread->running = false;
+    ring->file = NULL;
+    ring->context = NULL;
+    ring->count = block_count;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->sequence = 0;
+    ring->waiting = 0;
+    ring->closed = false;
+    ring->error = false;
+    return true;
+}
+
+void
+ring_free (struct ring * const ring) {
+    (void) pthread_cond_destroy(&ring->thread->cond);
+    (void) pthread_mutex_destroy(&ring->thread->mutex);
+    free(ring->thread);
+    free(ring->blocks);
+    ring->thread = NULL;
+    ring->blocks = NULL;
+}
+
+// Wake up the other end of `ring` if it is waiting for a change.
+//
+static void
+ring_wake (struct ring * const ring) {
+    INCREMENT(ring->sequence);
+    if (LOAD(ring->waiting)) {
+        (void) pthread_mutex_lock(&ring->thread->mutex);
+        (void) pthread_cond_broadcast(&ring->thread->cond);
+        (void) pthread_mutex_unlock(&ring->thread->mutex);
+    }
+}
+
+// Sleep until `ring` has changed since `ring->sequence` was `sequence`.
+//
+static void
+ring_wait (struct ring * const ring, const unsigned sequence) {
+    (void) pthread_mutex_lock(&ring->thread->mutex);
+    INCREMENT(ring->waiting);
+    while (LOAD(ring->sequence) == sequence) {
+        (void) pthread_cond_wait(&ring->thread->cond, &ring->thread->mutex);
+    }
+    DECREMENT(ring->waiting);
+    (void) pthread_mutex_unlock(&ring->thread->mutex);
+}
+
+struct ring_block *
+ring_acquire (struct ring * const ring) {
+    for (;;) {
+        const unsigned sequence = LOAD(ring->sequence);
+        if (ring->head - LOAD(ring->tail) < ring->count) {
+            return &ring->blocks[ring->head % ring->count];
+        }
+        ring_wait(ring, sequence);
+    }
+}
+
+void
+ring_commit (struct ring * const ring) {
+    STORE(ring->head, ring->head + 1U);
+    ring_wake(ring);
+}
+
+void
+ring_close (struct ring * const ring) {
+    STORE(ring->closed, true);
+    ring_wake(ring);
+}
+
+struct ring_block *
+ring_next (struct ring * const ring) {
+    for (;;) {
+        const unsigned sequence = LOAD(ring->sequence);
+        const bool closed = LOAD(ring->closed);
+        if (LOAD(ring->head) != ring->tail) {
+            return &ring->blocks[ring->tail % ring->count];
+        } else if (closed) {
+            return NULL;
+        }
+        ring_wait(ring, sequence);
+    }
+}
+
+void
+ring_release (struct ring * const ring) {
+    STORE(ring->tail, ring->tail + 1U);
+    ring_wake(ring);
+}
+
+static void *
+ring_reader (void *argument) {
+    struct ring * const ring = (struct ring *) argument;
+    for (;;) {
+        struct ring_block * const block = ring_acquire(ring);
+        block->address = 0;
+        block->length = fread(block->data, 1, RING_BLOCK_SIZE, ring->file);
+        if (!block->length) {
+            break;
+        }
+        ring_commit(ring);
+    }
+    if (ferror(ring->file)) {
+        ring->error = true;
+    }
+    ring_close(ring);
+    return NULL;
+}
+
+static void *
+ring_writer (void *argument) {
+    struct ring * const ring = (struct ring *) argument;
+    struct ring_block *block;
+    while ((block = ring_next(ring))) {
+        ring_block_output(ring, block);
+        ring_release(ring);
+    }
+    return NULL;
+}
+
+bool
+ring_start_thread (struct ring * const ring, void *(*run)(void *)) {
+    if (pthread_create(&ring->thread->thread, NULL, run, ring)) {
+        return false;
+    }
+    ring->thread->running = true;
+    return true;
+}
+
+bool
+ring_start_reader (struct ring * const ring, FILE *file) {
+    ring->file = file;
+    return ring_start_thread(ring, ring_reader);
+}
+
+bool
+ring_start_writer (struct ring * const ring) {
+    return ring_start_thread(ring, ring_writer);
+}
+
+bool
+ring_join (struct ring * const ring) {
+    if (!ring->thread->running) {
+        return !ring->error;
+    }
+    ring->thread->running = false;
+    if (pthread_join(ring->thread->thread, NULL)) {
+        return false;
+    }
+    return !ring->error;
+}
+
+#else // !RING_THREADS
+
+bool
+ring_init (struct ring * const ring, const unsigned block_count) {
+    (void) block_count;
+    ring->blocks = NULL;
+    ring->thread = NULL;
+    return false;
+}
+
+void
+ring_free (struct ring * const ring) {
+    (void) ring;
+}
+
+struct ring_block *
+ring_acquire (struct ring * const ring) {
+    (void) ring;
+    return NULL;
+}
+
+void
+ring_commit (struct ring * const ring) {
+    (void) ring;
+}
+
+void
+ring_close (struct ring * const ring) {
+    (void) ring;
+}
+
+struct ring_block *
+ring_next (struct ring * const ring) {
+    (void) ring;
+    return NULL;
+}
+
+void
+ring_release (struct ring * const ring) {
+    (void) ring;
+}
+
+bool
+ring_start_reader (struct ring * const ring, FILE *file) {
+    (void) ring;
+    (void) file;
+    return false;
+}
+
+bool
+ring_start_writer (struct ring * const ring) {
+    (void) ring;
+    return false;
+}
+
+bool
+ring_start_thread (struct ring * const ring, void *(*run)(void *)) {
+    (void) ring;
+    (void) run;
+    return false;
+}
+
+bool
+ring_join (struct ring * const ring) {
+    (void) ring;
+    return false;
+}
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * kk_ring.h: A single-producer, single-consumer ring buffer of large blocks
+ * for passing data between threads, e.g., to run the input, the conversion,
+ * and the output of a command-line tool concurrently as a pipeline.
+ *
+ * The producer fills a free block obtained from `ring_acquire` and passes
+ * it on with `ring_commit`, and the consumer obtains the filled blocks in
+ * order from `ring_next` and frees them with `ring_release`. The positions
+ * are updated without locking; a thread only sleeps when the ring is full
+ * (producer) or empty (consumer).
+ *
+ * Either end can be run in a thread of its own: `ring_start_reader` starts
+ * a thread that fills the ring from a file, and `ring_start_writer` starts
+ * a thread that passes each block to `ring_block_output`. Other producers
+ * and consumers can be run with `ring_start_thread` (e.g., the codecs of
+ * `kk_zpipe.h`).
+ *
+ * The sequence to read a file through a ring is:
+ *      struct ring ring;
+ *      struct ring_block *block;
+ *      ring_init(&ring, RING_DEFAULT_BLOCK_COUNT);
+ *      ring_start_reader(&ring, file);
+ *      while ((block = ring_next(&ring))) {
+ *          process(block->data, block->length);
+ *          ring_release(&ring);
+ *      }
+ *      ring_join(&ring); // false on read error
+ *      ring_free(&ring);
+ *
+ * Threads are supported on POSIX systems with a GCC-compatible compiler;
+ * elsewhere `ring_init` fails, and the caller should fall back to doing
+ * the I/O itself.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_RING_H
+#define KK_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define RING_BLOCK_SIZE (64UL * 1024UL)
+#define RING_DEFAULT_BLOCK_COUNT 8
+
+typedef struct ring_block {
+    unsigned long   address;    // for use by the producer and consumer
+    size_t          length;
+    uint8_t         data[RING_BLOCK_SIZE];
+} kk_ring_block_t;
+
+struct ring_thread;
+
+typedef struct ring {
+    struct ring_block   *blocks;
+    struct ring_thread  *thread;
+    FILE                *file;
+    void                *context;   // for the thread of `ring_start_thread`
+    unsigned            count;
+    unsigned            head;       // number of blocks committed
+    unsigned            tail;       // number of blocks released
+    unsigned            sequence;   // incremented on every change
+    unsigned            waiting;    // number of threads sleeping
+    bool                closed;
+    bool                error;
+} kk_ring_t;
+
+// Initialise `ring` with `block_count` blocks, returns false on error
+// (e.g., out of memory, or threads not supported)
+bool ring_init(struct ring *ring, unsigned block_count);
+
+// Free the memory of `ring` (after joining its thread, if any)
+void ring_free(struct ring *ring);
+
+// Producer: returns a free block to fill, waiting while the ring is full
+struct ring_block *ring_acquire(struct ring *ring);
+
+// Producer: pass the block obtained from `ring_acquire` to the consumer
+void ring_commit(struct ring *ring);
+
+// Producer: end the stream of blocks
+void ring_close(struct ring *ring);
+
+// Consumer: returns the next filled block, waiting while the ring is
+// empty, or NULL when the ring has been closed and all blocks consumed
+struct ring_block *ring_next(struct ring *ring);
+
+// Consumer: free the block obtained from `ring_next`
+void ring_release(struct ring *ring);
+
+// Start a thread that reads `file` into blocks of `ring` until the end of
+// the file, and then closes the ring. Returns false on error.
+bool ring_start_reader(struct ring *ring, FILE *file);
+
+// Start a thread that passes each block of `ring` to `ring_block_output`,
+// until the ring is closed. Returns false on error.
+bool ring_start_writer(struct ring *ring);
+
+// Start a thread that runs `run` with `ring` as the argument, e.g., to
+// produce or consume the blocks with its own state in `ring->context`.
+// The thread should set `ring->error` on failure. Returns false on error.
+bool ring_start_thread(struct ring *ring, void *(*run)(void *));
+
+// Wait for the thread of `ring` to finish, returns false if the thread
+// failed (e.g., a read error) or could not be joined
+bool ring_join(struct ring *ring);
+
+// Called by the writer thread of `ring` with each `block` of data. The
+// implementation is NOT provided by this module. Note that it runs in
+// its own thread, concurrently with the producer.
+extern void ring_block_output(struct ring *ring, struct ring_block *block);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_RING_H
@@ -0,0 +1,128 @@
+/*
+ * kk_srec.h: Reading and writing the Motorola S-record format (also known
+ * as SREC, S19, S28 or S37), with the same design as the Intel HEX library
+ * of `kk_ihex.h`: the caller does the actual input and output, and the
+ * library calls back with each record read or each line to write.
+ *
+ *      USAGE
+ *      -----
+ *
+ * As with IHEX, the library is split into read and write parts, which use
+ * a common data structure (`struct srec_state`), but each can be used
+ * independently. Include the header `kk_srec_read.h` for reading, and/or
+ * the header `kk_srec_write.h` for writing (and link with their respective
+ * object files). The S-record and IHEX modules do not depend on each other,
+ * but both may be linked into the same program, e.g., for conversion.
+ *
+ *
+ *      READING S-RECORDS
+ *      -----------------
+ *
+ * The bytes read are passed to `srec_read_byte` and/or `srec_read_bytes`,
+ * which call `srec_data_read` for each complete record. See the header
+ * `kk_srec_read.h` for details and an example implementation.
+ *
+ * The sequence to read data in S-record format is:
+ *      struct srec_state srec;
+ *      srec_begin_read(&srec);
+ *      srec_read_bytes(&srec, my_input_bytes, length_of_my_input_bytes);
+ *      srec_end_read(&srec);
+ *
+ *
+ *      WRITING BINARY DATA AS S-RECORDS
+ *      --------------------------------
+ *
+ * The width of the addresses (16, 24, or 32 bits, i.e., S1, S2, or S3 data
+ * records) is chosen with `srec_set_address_width`, the data location is
+ * set with `srec_write_at_address`, and the data is written with
+ * `srec_write_byte` and/or `srec_write_bytes`. The function
+ * `srec_flush_buffer` is called with each line of output. Finally
+ * `srec_end_write` writes the termination record (S9, S8, or S7, matching
+ * the data records) with the start address of the program.
+ *
+ * The sequence to write data in S-record format is:
+ *      struct srec_state srec;
+ *      srec_init(&srec);
+ *      srec_write_at_address(&srec, 0);
+ *      srec_write_bytes(&srec, my_data, length_of_my_data);
+ *      srec_end_write(&srec, 0);
+ *
+ * Unlike IHEX, every S-record carries its full address, so there are no
+ * extended address records, and the address of a record must fit in the
+ * chosen width (the higher bits are silently discarded).
+ *
+ * The same `struct srec_state` may be used either for reading or writing,
+ * but NOT both at the same time. As with IHEX, a global output buffer is
+ * used for writing, i.e., multiple threads must not write simultaneously.
+ *
+ *
+ *      CONSERVING MEMORY
+ *      -----------------
+ *
+ * The maximum number of bytes per record can be limited by defining
+ * `SREC_LINE_MAX_LENGTH` as something less than 255. This is the count
+ * field of the record, i.e., it includes the address and the checksum
+ * as well as the data bytes, so the default S3 records of 32 data bytes
+ * need a maximum of 37.
+ *
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_SREC_H
+#define KK_SREC_H
+
+#include "kk_ihex.h"
+
+typedef ihex_bool_t srec_bool_t;
+typedef uint_least32_t srec_address_t;
+typedef int srec_count_t;
+
+// Maximum number of bytes per record, including the address and checksum
+// (applies to both reading and writing!); specify 255 to support reading
+// all possible records
+#ifndef SREC_LINE_MAX_LENGTH
+#define SREC_LINE_MAX_LENGTH 255
+#endif
+
+typedef struct srec_state {
+    srec_address_t  address;
+    uint8_t         flags;
+    uint8_t         line_length;
+    uint8_t         length;
+    uint8_t         data[SREC_LINE_MAX_LENGTH + 1];
+} kk_srec_t;
+
+enum srec_record_type {
+    SREC_HEADER_RECORD,         // S0
+    SREC_DATA16_RECORD,         // S1
+    SREC_DATA24_RECORD,         // S2
+    SREC_DATA32_RECORD,         // S3
+    SREC_RESERVED_RECORD,       // S4
+    SREC_COUNT16_RECORD,        // S5
+    SREC_COUNT24_RECORD,        // S6
+    SREC_START32_RECORD,        // S7
+    SREC_START24_RECORD,        // S8
+    SREC_START16_RECORD         // S9
+};
+typedef uint8_t srec_record_type_t;
+
+// The number of address bytes in a record of `type`
+#define SREC_ADDRESS_SIZE(type) ((uint8_t) (((type) <= SREC_DATA32_RECORD) ? \
+                                 (((type) > 1U) ? (type) + 1U : 2U) : \
+                                 ((type) >= SREC_START32_RECORD) ? \
+                                 (11U - (type)) : (type) - 3U))
+
+// The termination (start address) record type matching a data record type
+#define SREC_START_RECORD_TYPE(type) ((srec_record_type_t) (10U - (type)))
+
+// The newline string (appended to every output line, e.g., "\r\n")
+#ifndef SREC_NEWLINE_STRING
+#define SREC_NEWLINE_STRING IHEX_NEWLINE_STRING
+#endif
+
+// See kk_srec_read.h and kk_srec_write.h for function declarations!
+
+#endif // !KK_SREC_H
@@ -0,0 +1,167 @@
+/*
+ * kk_srec_read.c: Reading the Motorola S-record format.
+ *
+ * See the header `kk_srec.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_srec_read.h"
+#include "kk_hex_codec.h"
+#include <string.h>
+
+#define SREC_START 'S'
+
+enum srec_read_state {
+    READ_WAIT_FOR_START = 0,
+    READ_RECORD_TYPE,
+    READ_COUNT_HIGH,
+    READ_COUNT_LOW,
+    READ_DATA_HIGH,
+    READ_DATA_LOW
+};
+
+#define SREC_READ_RECORD_TYPE_MASK 0x0F
+#define SREC_READ_STATE_MASK 0x70
+#define SREC_READ_STATE_OFFSET 4
+
+void
+srec_begin_read (struct srec_state * const srec) {
+    srec->address = 0;
+    srec->flags = 0;
+    srec->line_length = 0;
+    srec->length = 0;
+}
+
+// Complete the record of `srec->length` bytes (address, data and checksum)
+// read into `srec->data` after the count field `srec->line_length`.
+//
+static void
+srec_end_record (struct srec_state * const srec) {
+    const uint_fast8_t type = srec->flags & SREC_READ_RECORD_TYPE_MASK;
+    const uint_fast8_t address_size = SREC_ADDRESS_SIZE(type);
+    const uint_fast8_t count = srec->line_length;
+    uint_fast8_t len = srec->length;
+    const srec_bool_t truncated = (len != count);
+    uint_fast8_t error = 0;
+    srec_address_t address = 0;
+
+    if (len == count) {
+        // compute and validate checksum
+        const uint8_t * const eptr = srec->data + --len;
+        const uint8_t *r = srec->data;
+        uint8_t sum = (uint8_t) count;
+        while (r != eptr) {
+            sum += *r++;
+        }
+        error = (uint8_t) ~sum ^ *eptr; // *eptr is the received checksum
+    }
+    if (len >= address_size) {
+        const uint8_t *r = srec->data;
+        const uint8_t * const eptr = r + address_size;
+        do {
+            address = (address << 8) | *r;
+        } while (++r != eptr);
+        len -= address_size;
+        (void) memmove(srec->data, eptr, len);
+    } else {
+        len = 0;
+    }
+    srec->address = address;
+    srec->length = (uint8_t) len;
+    srec->line_length = (count > address_size) ? (uint8_t) (count - address_size - 1U) : 1U;
+    if (truncated && srec->length >= srec->line_length) {
+        // only the checksum is missing, but that is still truncated
+        srec->line_length = (uint8_t) (srec->length + 1U);
+    }
+    (void) srec_data_read(srec, type, (uint8_t) error);
+    srec->length = 0;
+    srec->flags = 0;
+}
+
+void
+srec_end_read (struct srec_state * const srec) {
+    if ((srec->flags & SREC_READ_STATE_MASK) >= (READ_DATA_HIGH << SREC_READ_STATE_OFFSET)) {
+        // truncated record
+        srec_end_record(srec);
+    }
+    srec->flags = 0;
+}
+
+void
+srec_read_byte (struct srec_state * const srec, const char byte) {
+    uint_fast8_t b = (uint_fast8_t) byte;
+    uint_fast8_t state = (srec->flags & SREC_READ_STATE_MASK) >> SREC_READ_STATE_OFFSET;
+    uint_fast8_t len = srec->length;
+
+    if (state == READ_RECORD_TYPE) {
+        if (b >= '0' && b <= '9') {
+            srec->flags = (uint8_t) ((b - '0') | (READ_COUNT_HIGH << SREC_READ_STATE_OFFSET));
+        } else {
+            srec->flags = 0;
+        }
+        return;
+    }
+    if ((b = hex_digit_value(b)) == HEX_INVALID_DIGIT) {
+        if (byte == SREC_START || byte == 's') {
+            if (state >= READ_DATA_HIGH) {
+                // a new record before the end of the previous one
+                srec_end_record(srec);
+            }
+            srec->flags = READ_RECORD_TYPE << SREC_READ_STATE_OFFSET;
+            srec->length = 0;
+        }
+        // ignore unknown characters (e.g., extra whitespace)
+        return;
+    }
+
+    switch (state) {
+    default:
+        // remain in initial state while waiting for S
+        return;
+    case READ_COUNT_HIGH:
+        srec->line_length = (uint8_t) (b << 4);
+        break;
+    case READ_COUNT_LOW:
+        b |= srec->line_length;
+        srec->line_length = (uint8_t) b;
+        srec->length = 0;
+        if (!b) {
+            srec->flags = 0;
+            return;
+        }
+#if SREC_LINE_MAX_LENGTH < 255
+        if (b > SREC_LINE_MAX_LENGTH) {
+            srec_end_record(srec);
+            return;
+        }
+#endif
+        break;
+    case READ_DATA_HIGH:
+        srec->data[len] = (uint8_t) (b << 4);
+        break;
+    case READ_DATA_LOW:
+        srec->data[len] |= (uint8_t) b;
+        srec->length = (uint8_t) ++len;
+        if (len == srec->line_length) {
+            srec_end_record(srec);
+            return;
+        }
+        state = READ_DATA_HIGH - 1;
+        break;
+    }
+    srec->flags = (uint8_t) ((srec->flags & SREC_READ_RECORD_TYPE_MASK) |
+                             ((state + 1U) << SREC_READ_STATE_OFFSET));
+}
+
+void
+srec_read_bytes (struct srec_state * restrict srec,
+                 const char * restrict data,
+                 srec_count_t count) {
+    while (count > 0) {
+        srec_read_byte(srec, *data++);
+        --count;
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * kk_srec_read.h: Reading Motorola S-record data. See the accompanying
+ * kk_srec_write.h for write support, and kk_srec.h for the shared parts.
+ *
+ *
+ *      READING S-RECORDS
+ *      -----------------
+ *
+ * As with `kk_ihex_read.h`, the actual reading of bytes is done by other
+ * means, and the bytes read are passed to `srec_read_byte` and/or
+ * `srec_read_bytes`. The reading functions call `srec_data_read` for each
+ * record, at which stage the `struct srec_state` contains its address and
+ * data. See below for details and an example implementation.
+ *
+ * The sequence to read data in S-record format is:
+ *      struct srec_state srec;
+ *      srec_begin_read(&srec);
+ *      srec_read_bytes(&srec, my_input_bytes, length_of_my_input_bytes);
+ *      srec_end_read(&srec);
+ *
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_SREC_READ_H
+#define KK_SREC_READ_H
+
+#ifdef __cplusplus
+#ifndef restrict
+#define restrict
+#endif
+extern "C" {
+#endif
+
+#include "kk_srec.h"
+
+// Begin reading
+void srec_begin_read(struct srec_state *srec);
+
+// Read a single character
+void srec_read_byte(struct srec_state *srec, char chr);
+
+// Read `count` bytes from `data`
+void srec_read_bytes(struct srec_state * restrict srec,
+                     const char * restrict data,
+                     srec_count_t count);
+
+// End reading (may call `srec_data_read` if there is a truncated record)
+void srec_end_read(struct srec_state *srec);
+
+// Called when a complete record has been read, the type of which is passed
+// as `type` (the digit after the `S`). The `srec` structure has its field
+// `address` set to the address field of the record (i.e., the address of
+// the data, the start address of the program for S7, S8 and S9 records, or
+// the number of data records for S5 and S6 records), and `data` contains
+// the `length` bytes that follow the address (e.g., the data bytes of S1,
+// S2 and S3 records, or the header text of an S0 record).
+//
+// Possible error cases include checksum mismatch (which is indicated as
+// an argument), and a truncated record or one that does not fit in
+// `SREC_LINE_MAX_LENGTH`, which are indicated by `line_length` greater
+// than `length`. As with IHEX, the return value is currently unused, but
+// should be false on error.
+//
+// Example implementation:
+//
+//      srec_bool_t srec_data_read(struct srec_state *srec,
+//                                 srec_record_type_t type,
+//                                 srec_bool_t error) {
+//          error = error || (srec->length < srec->line_length);
+//          if (type >= SREC_DATA16_RECORD && type <= SREC_DATA32_RECORD && !error) {
+//              (void) fseek(outfile, srec->address, SEEK_SET);
+//              (void) fwrite(srec->data, 1, srec->length, outfile);
+//          }
+//          return !error;
+//      }
+//
+extern srec_bool_t srec_data_read(struct srec_state *srec,
+                                  srec_record_type_t type,
+                                  srec_bool_t error);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_SREC_READ_H
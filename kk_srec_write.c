@@ -0,0 +1,170 @@
+/*
+ * kk_srec_write.c: Writing the Motorola S-record format.
+ *
+ * See the header `kk_srec.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_srec_write.h"
+#include "kk_hex_codec.h"
+
+#define SREC_START 'S'
+
+// The data record type is kept in the low bits of `flags`
+#define SREC_WRITE_RECORD_TYPE_MASK 0x0F
+
+#ifndef IHEX_REENTRANT_WRITE
+static char srec_write_buffer[SREC_WRITE_BUFFER_LENGTH];
+#endif
+
+#if SREC_MAX_OUTPUT_LINE_LENGTH + 5 > SREC_LINE_MAX_LENGTH
+#error "SREC_MAX_OUTPUT_LINE_LENGTH + 5 > SREC_LINE_MAX_LENGTH"
+#endif
+
+void
+srec_init (struct srec_state * const srec) {
+    srec->address = 0;
+    srec->flags = SREC_DATA32_RECORD;
+    srec->line_length = SREC_DEFAULT_OUTPUT_LINE_LENGTH;
+    srec->length = 0;
+}
+
+void
+srec_set_address_width (struct srec_state * const srec,
+                        const srec_record_type_t type) {
+    if (type >= SREC_DATA16_RECORD && type <= SREC_DATA32_RECORD) {
+        srec->flags = (uint8_t) ((srec->flags & ~SREC_WRITE_RECORD_TYPE_MASK) | type);
+    }
+}
+
+void
+srec_set_output_line_length (struct srec_state * const srec,
+                             uint8_t line_length) {
+    if (line_length > SREC_MAX_OUTPUT_LINE_LENGTH) {
+        line_length = SREC_MAX_OUTPUT_LINE_LENGTH;
+    } else if (!line_length) {
+        line_length = SREC_DEFAULT_OUTPUT_LINE_LENGTH;
+    }
+    srec->line_length = line_length;
+}
+
+static char *
+srec_buffer_newline (char * restrict w) {
+    const char * restrict r = SREC_NEWLINE_STRING;
+    do {
+        *w++ = *r++;
+    } while (*r);
+    return w;
+}
+
+// Write a record of `type` with `address` and `len` bytes from `data`.
+//
+static void
+srec_write_record (struct srec_state * const srec,
+                   const srec_record_type_t type,
+                   const srec_address_t address,
+                   const uint8_t * restrict data,
+                   uint_fast8_t len) {
+#ifdef IHEX_REENTRANT_WRITE
+    char srec_write_buffer[SREC_WRITE_BUFFER_LENGTH];
+#endif
+    char * restrict w = srec_write_buffer;
+    uint_fast8_t shift = SREC_ADDRESS_SIZE(type) * 8U;
+    uint8_t sum = (uint8_t) (len + SREC_ADDRESS_SIZE(type) + 1U);
+
+    *w++ = SREC_START;
+    *w++ = (char) ('0' + type);
+    w = hex_buffer_byte(w, sum); // count
+
+    do {
+        const uint8_t byte = (uint8_t) (address >> (shift -= 8U));
+        sum += byte;
+        w = hex_buffer_byte(w, byte);
+    } while (shift);
+
+    while (len--) {
+        const uint8_t byte = *data++;
+        sum += byte;
+        w = hex_buffer_byte(w, byte);
+    }
+
+    w = hex_buffer_byte(w, (uint8_t) ~sum);
+    w = srec_buffer_newline(w);
+    srec_flush_buffer(srec, srec_write_buffer, w);
+}
+
+// Write out `srec->data`
+//
+static void
+srec_write_data (struct srec_state * const srec) {
+    const uint_fast8_t len = srec->length;
+    if (!len) {
+        return;
+    }
+    srec_write_record(srec, srec->flags & SREC_WRITE_RECORD_TYPE_MASK,
+                      srec->address, srec->data, len);
+    srec->address += len;
+    srec->length = 0;
+}
+
+void
+srec_write_header (struct srec_state * restrict const srec,
+                   const void * restrict data,
+                   srec_count_t count) {
+    if (count > SREC_MAX_OUTPUT_LINE_LENGTH) {
+        count = SREC_MAX_OUTPUT_LINE_LENGTH;
+    } else if (count < 0) {
+        count = 0;
+    }
+    srec_write_data(srec);
+    srec_write_record(srec, SREC_HEADER_RECORD, 0, (const uint8_t *) data,
+                      (uint_fast8_t) count);
+}
+
+void
+srec_write_at_address (struct srec_state * const srec,
+                       const srec_address_t address) {
+    srec_write_data(srec); // flush any existing data
+    srec->address = address;
+}
+
+void
+srec_write_byte (struct srec_state * const srec, const int byte) {
+    if (srec->line_length <= srec->length) {
+        srec_write_data(srec);
+    }
+    srec->data[(srec->length)++] = (uint8_t) byte;
+}
+
+void
+srec_write_bytes (struct srec_state * restrict const srec,
+                  const void * restrict buf,
+                  srec_count_t count) {
+    const uint8_t *r = (const uint8_t *) buf;
+    while (count > 0) {
+        if (srec->line_length > srec->length) {
+            uint_fast8_t i = srec->line_length - srec->length;
+            uint8_t *w = srec->data + srec->length;
+            i = ((srec_count_t) i > count) ? (uint_fast8_t) count : i;
+            count -= i;
+            srec->length += i;
+            do {
+                *w++ = *r++;
+            } while (--i);
+        } else {
+            srec_write_data(srec);
+        }
+    }
+}
+
+void
+srec_end_write (struct srec_state * const srec,
+                const srec_address_t start_address) {
+    srec_write_data(srec); // flush any remaining data
+    srec_write_record(srec,
+                      SREC_START_RECORD_TYPE(srec->flags & SREC_WRITE_RECORD_TYPE_MASK),
+                      start_address, srec->data, 0);
+}
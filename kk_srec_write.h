@@ -0,0 +1,128 @@
+/*
+ * kk_srec_write.h: Writing Motorola S-record data. See the accompanying
+ * kk_srec_read.h for read support, and kk_srec.h for the shared parts.
+ *
+ *
+ *      WRITING BINARY DATA AS S-RECORDS
+ *      --------------------------------
+ *
+ * As with `kk_ihex_write.h`, the data location is set with
+ * `srec_write_at_address`, the bytes are written with `srec_write_byte`
+ * and/or `srec_write_bytes`, and the function `srec_flush_buffer` is
+ * called to output each complete line. See below for an example
+ * implementation.
+ *
+ * The sequence to write data in S-record format is:
+ *      struct srec_state srec;
+ *      srec_init(&srec);
+ *      srec_set_address_width(&srec, SREC_DATA24_RECORD); // optional
+ *      srec_write_header(&srec, "name", 4); // optional
+ *      srec_write_at_address(&srec, 0);
+ *      srec_write_bytes(&srec, my_data, length_of_my_data);
+ *      srec_end_write(&srec, start_address);
+ *
+ * The data records are S3 records with 32-bit addresses by default, and
+ * the termination record always matches the data records, i.e., S7 for
+ * S3, S8 for S2, and S9 for S1. No record count (S5/S6) is written, as
+ * it is optional.
+ *
+ * Gaps in the data may be created by calling `srec_write_at_address` with
+ * the new starting address without calling `srec_end_write` in between.
+ *
+ * Like the IHEX writer, a static write buffer is used unless the library
+ * is built with `IHEX_REENTRANT_WRITE` defined.
+ *
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_SREC_WRITE_H
+#define KK_SREC_WRITE_H
+
+#ifdef __cplusplus
+#ifndef restrict
+#define restrict
+#endif
+extern "C" {
+#endif
+
+#include "kk_srec.h"
+
+// Maximum number of data bytes per output record (the count field also
+// includes up to 4 address bytes and the checksum)
+#if SREC_LINE_MAX_LENGTH >= 255
+#define SREC_MAX_OUTPUT_LINE_LENGTH 250
+#else
+#define SREC_MAX_OUTPUT_LINE_LENGTH (SREC_LINE_MAX_LENGTH - 5)
+#endif
+
+// Default number of data bytes written per line
+#if SREC_MAX_OUTPUT_LINE_LENGTH >= 32
+#define SREC_DEFAULT_OUTPUT_LINE_LENGTH 32
+#else
+#define SREC_DEFAULT_OUTPUT_LINE_LENGTH SREC_MAX_OUTPUT_LINE_LENGTH
+#endif
+
+// Length of the write buffer required
+#define SREC_WRITE_BUFFER_LENGTH (1+1+2+8+(SREC_MAX_OUTPUT_LINE_LENGTH*2)+2+sizeof(SREC_NEWLINE_STRING))
+
+// Initialise the structure `srec` for writing (S3 records, 32-bit addresses)
+void srec_init(struct srec_state *srec);
+
+// Set the type of data records to write as `SREC_DATA16_RECORD` (S1),
+// `SREC_DATA24_RECORD` (S2), or `SREC_DATA32_RECORD` (S3), i.e., the
+// address width of 16, 24, or 32 bits. This must be done before any
+// data is written.
+void srec_set_address_width(struct srec_state *srec, srec_record_type_t type);
+
+// Set the number of data bytes written per line (at most
+// `SREC_MAX_OUTPUT_LINE_LENGTH`, or 0 for the default)
+void srec_set_output_line_length(struct srec_state *srec, uint8_t line_length);
+
+// Write an S0 header record containing `count` bytes from `data` (at most
+// `SREC_MAX_OUTPUT_LINE_LENGTH`); this should be done at most once, before
+// any data is written
+void srec_write_header(struct srec_state * restrict srec,
+                       const void * restrict data,
+                       srec_count_t count);
+
+// Begin writing at `address` after writing any pending data at the
+// current address
+void srec_write_at_address(struct srec_state *srec, srec_address_t address);
+
+// Write a single byte
+void srec_write_byte(struct srec_state *srec, int b);
+
+// Write `count` bytes from `data`
+void srec_write_bytes(struct srec_state * restrict srec,
+                      const void * restrict data,
+                      srec_count_t count);
+
+// End writing (flush buffers, write the termination record with the
+// start address of the program, or 0 if there is none)
+void srec_end_write(struct srec_state *srec, srec_address_t start_address);
+
+// Called with each line of output, `(eptr - buffer)` bytes from `buffer`
+// (which is not NUL-terminated, but may be modified to make it thus). The
+// implementation is NOT provided by this library.
+//
+// Example implementation:
+//
+//      void srec_flush_buffer(struct srec_state *srec,
+//                             char *buffer, char *eptr) {
+//          *eptr = '\0';
+//          (void) fputs(buffer, stdout);
+//      }
+//
+// Note that the contents of `buffer` can become invalid immediately after
+// this function returns - the data must be copied if it needs to be preserved!
+//
+extern void srec_flush_buffer(struct srec_state *srec,
+                              char *buffer, char *eptr);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_SREC_WRITE_H
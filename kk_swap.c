@@ -0,0 +1,143 @@
+/*
+ * kk_swap.c: Byte order and word swapping of data.
+ *
+ * See the header `kk_swap.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#include "kk_swap.h"
+#include <string.h>
+
+void
+swap_bytes (uint8_t * restrict data, size_t count, const enum swap_mode mode) {
+    size_t i;
+
+    // the loops are simple enough for the compiler to vectorise
+    count &= ~((size_t) SWAP_WORD_SIZE(mode) - 1U);
+    switch (mode) {
+    case SWAP_16:
+        for (i = 0; i < count; i += 2) {
+            const uint8_t b0 = data[i];
+            data[i] = data[i + 1];
+            data[i + 1] = b0;
+        }
+        break;
+    case SWAP_WORDS:
+        for (i = 0; i < count; i += 4) {
+            const uint8_t b0 = data[i];
+            const uint8_t b1 = data[i + 1];
+            data[i] = data[i + 2];
+            data[i + 1] = data[i + 3];
+            data[i + 2] = b0;
+            data[i + 3] = b1;
+        }
+        break;
+    case SWAP_32:
+        for (i = 0; i < count; i += 4) {
+            const uint8_t b0 = data[i];
+            const uint8_t b1 = data[i + 1];
+            data[i] = data[i + 3];
+            data[i + 1] = data[i + 2];
+            data[i + 2] = b1;
+            data[i + 3] = b0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+enum swap_mode
+swap_option (const char *arg) {
+    if (!strcmp(arg, "--swap16")) {
+        return SWAP_16;
+    } else if (!strcmp(arg, "--swap32")) {
+        return SWAP_32;
+    } else if (!strcmp(arg, "--swapwords")) {
+        return SWAP_WORDS;
+    }
+    return SWAP_NONE;
+}
+
+void
+swap_stage_init (struct swap_stage * const stage, const enum swap_mode mode) {
+    stage->word_address = 0;
+    stage->mode = (uint8_t) mode;
+    stage->present = 0;
+}
+
+void
+swap_stage_flush (struct swap_stage * const stage) {
+    const unsigned size = SWAP_WORD_SIZE(stage->mode);
+    unsigned i = 0;
+
+    // output each run of bytes of the partial word unswapped, in order
+    while (stage->present) {
+        unsigned n = 0;
+        while (!(stage->present & (1U << i))) {
+            ++i;
+        }
+        while (i + n < size && (stage->present & (1U << (i + n)))) {
+            stage->buffer[n] = stage->word[i + n];
+            ++n;
+        }
+        stage->present &= (uint8_t) ~(((1U << n) - 1U) << i);
+        swap_stage_output(stage, stage->word_address + i, stage->buffer, n);
+        i += n;
+    }
+}
+
+void
+swap_stage_write (struct swap_stage * restrict const stage,
+                  unsigned long address,
+                  const uint8_t * restrict data,
+                  size_t count) {
+    const unsigned mask = stage->mode;
+    const size_t size = SWAP_WORD_SIZE(mask);
+    const uint8_t complete = (uint8_t) ((1U << size) - 1U);
+
+    if (!mask) {
+        swap_stage_output(stage, address, data, count);
+        return;
+    }
+
+    while (count) {
+        const unsigned offset = (unsigned) (address & (size - 1U));
+
+        if (stage->present && (address - offset != stage->word_address ||
+                               (stage->present & (1U << offset)))) {
+            // not a continuation of the pending word
+            swap_stage_flush(stage);
+        }
+
+        if (offset || stage->present || count < size) {
+            // add a byte to the pending word
+            stage->word_address = address - offset;
+            stage->word[offset] = *data++;
+            stage->present |= (uint8_t) (1U << offset);
+            ++address;
+            --count;
+            if (stage->present == complete) {
+                unsigned i;
+                for (i = 0; i < size; ++i) {
+                    stage->buffer[i] = stage->word[i ^ mask];
+                }
+                stage->present = 0;
+                swap_stage_output(stage, stage->word_address, stage->buffer, size);
+            }
+        } else {
+            // whole words at an aligned address
+            size_t n = (count < SWAP_BUFFER_SIZE) ? count : SWAP_BUFFER_SIZE;
+            n &= ~(size - 1U);
+            (void) memcpy(stage->buffer, data, n);
+            swap_bytes(stage->buffer, n, (enum swap_mode) mask);
+            swap_stage_output(stage, address, stage->buffer, n);
+            address += (unsigned long) n;
+            data += n;
+            count -= n;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * kk_swap.h: Byte order and word swapping of data, e.g., for ROM images
+ * of a big endian processor that are programmed as little endian words.
+ *
+ * The swaps are defined by address: in a 16-bit byte swap the byte at
+ * address `x` moves to the address `x ^ 1`, in a 32-bit byte swap to
+ * `x ^ 3`, and in a 16-bit word swap (the halves of each 32-bit word)
+ * to `x ^ 2`. Hence the swap mode is the XOR mask of the address.
+ *
+ * For contiguous data starting at an aligned address, the function
+ * `swap_bytes` swaps the words in place. A partial word at the end is
+ * left unchanged, like `dd conv=swab` does.
+ *
+ * For data that is written in pieces at arbitrary addresses, such as the
+ * records of an IHEX file, a `struct swap_stage` can be inserted between
+ * the source and the sink of the data. It passes the swapped data to
+ * `swap_stage_output`, joining the pieces of words that are split between
+ * consecutive writes. The bytes of a word that is not complete (e.g.,
+ * due to a gap in the data, or at the end) are output unswapped at their
+ * own addresses, just as `swap_bytes` leaves a partial word unchanged.
+ *
+ * The sequence to use a swap stage is:
+ *      struct swap_stage stage;
+ *      swap_stage_init(&stage, SWAP_32);
+ *      swap_stage_write(&stage, address, data, count); // any number of times
+ *      swap_stage_flush(&stage);
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_SWAP_H
+#define KK_SWAP_H
+
+#ifdef __cplusplus
+#ifndef restrict
+#define restrict
+#endif
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum swap_mode {
+    SWAP_NONE = 0,
+    SWAP_16 = 1,        // swap the bytes of each 16-bit word
+    SWAP_WORDS = 2,     // swap the 16-bit halves of each 32-bit word
+    SWAP_32 = 3         // swap the bytes of each 32-bit word
+};
+
+// The size of the word swapped in `mode`, in bytes
+#define SWAP_WORD_SIZE(mode) ((mode) == SWAP_16 ? 2U : ((mode) ? 4U : 1U))
+
+// The size of the data buffer in a `struct swap_stage`
+#ifndef SWAP_BUFFER_SIZE
+#define SWAP_BUFFER_SIZE 1024
+#endif
+
+struct swap_stage {
+    unsigned long   word_address;   // address of the pending word
+    uint8_t         mode;
+    uint8_t         present;        // bitmask of pending bytes, 0 if none
+    uint8_t         word[4];        // the pending word, unswapped
+    uint8_t         buffer[SWAP_BUFFER_SIZE];
+};
+
+// Swap the bytes of each whole word of `count` bytes of `data` in place,
+// where `data` begins at an aligned address. Any bytes of a partial word
+// at the end are left unchanged.
+void swap_bytes(uint8_t *data, size_t count, enum swap_mode mode);
+
+// Returns the swap mode for the command-line option `arg` (`--swap16`,
+// `--swap32`, or `--swapwords`), or `SWAP_NONE` if it is not a swap option.
+enum swap_mode swap_option(const char *arg);
+
+// Initialise `stage` to swap in `mode`
+void swap_stage_init(struct swap_stage *stage, enum swap_mode mode);
+
+// Write `count` bytes of `data` at `address`
+void swap_stage_write(struct swap_stage * restrict stage,
+                      unsigned long address,
+                      const uint8_t * restrict data,
+                      size_t count);
+
+// Output any pending partial word (i.e., call this after the last write)
+void swap_stage_flush(struct swap_stage *stage);
+
+// Called with the swapped data, `count` bytes from `data` at `address`.
+// The implementation is NOT provided by this library. Note that `data`
+// is reused as soon as this function returns.
+extern void swap_stage_output(struct swap_stage *stage,
+                              unsigned long address,
+                              const uint8_t *data,
+                              size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_SWAP_H
@@ -0,0 +1,530 @@
+/*
+ * kk_zpipe.c: Transparent compression and decompression in a codec thread.
+ *
+ * See the header `kk_zpipe.h` for instructions.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#if !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "kk_zpipe.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef ZPIPE_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef ZPIPE_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef ZPIPE_ENABLE_LZMA
+#include <lzma.h>
+#endif
+
+#define ZPIPE_BUFFER_SIZE (64UL * 1024UL)
+
+static const struct {
+    const char      *name;
+    unsigned char   magic_length;
+    unsigned char   magic[ZPIPE_MAGIC_MAX_LENGTH];
+} zpipe_codecs[] = {
+    { "", 0, { 0 } },
+    { "gzip", 2, { 0x1F, 0x8B } },
+    { "zstd", 4, { 0x28, 0xB5, 0x2F, 0xFD } },
+    { "xz", 6, { 0xFD, 0x37, 0x7A, 0x58, 0x5A, 0x00 } }
+};
+
+#define ZPIPE_CODEC_COUNT ((int) (sizeof(zpipe_codecs) / sizeof(zpipe_codecs[0])))
+
+enum zpipe_format
+zpipe_format_option (const char *arg) {
+    int i;
+    for (i = ZPIPE_GZIP; i < ZPIPE_CODEC_COUNT; ++i) {
+        if (!strcmp(arg, zpipe_codecs[i].name)) {
+            return (enum zpipe_format) i;
+        }
+    }
+    return ZPIPE_NONE;
+}
+
+bool
+zpipe_format_supported (const enum zpipe_format format) {
+    switch (format) {
+    case ZPIPE_NONE:
+        return true;
+#ifdef ZPIPE_ENABLE_ZLIB
+    case ZPIPE_GZIP:
+        return true;
+#endif
+#ifdef ZPIPE_ENABLE_ZSTD
+    case ZPIPE_ZSTD:
+        return true;
+#endif
+#ifdef ZPIPE_ENABLE_LZMA
+    case ZPIPE_XZ:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+int
+zpipe_open_read (struct zpipe * const zpipe, FILE *file) {
+    unsigned char * const magic = zpipe->prefix;
+    size_t length = 0;
+    int format = ZPIPE_NONE;
+    bool partial;
+
+    zpipe->file = file;
+    zpipe->error = 0;
+
+    // match the magic bytes one at a time, so that only the first byte
+    // needs to be put back for uncompressed input (e.g., all IHEX input)
+    do {
+        const int c = getc(file);
+        int i;
+        if (c == EOF) {
+            break;
+        }
+        magic[length++] = (unsigned char) c;
+        partial = false;
+        for (i = ZPIPE_GZIP; i < ZPIPE_CODEC_COUNT; ++i) {
+            if (!memcmp(magic, zpipe_codecs[i].magic, length)) {
+                if (length == zpipe_codecs[i].magic_length) {
+                    format = i;
+                }
+                partial = true;
+            }
+        }
+    } while (partial && format == ZPIPE_NONE && length < ZPIPE_MAGIC_MAX_LENGTH);
+
+    zpipe->format = (enum zpipe_format) format;
+    zpipe->prefix_length = length;
+    if (!zpipe_format_supported(zpipe->format)) {
+        errno = ENOTSUP;
+        return -1;
+    }
+    if (format == ZPIPE_NONE && length <= 1U) {
+        if (length) {
+            (void) ungetc(magic[0], file);
+        }
+        zpipe->prefix_length = 0;
+        return 0;
+    }
+    if (fseek(file, -(long) length, SEEK_CUR) == 0) {
+        zpipe->prefix_length = 0;
+        return (format != ZPIPE_NONE);
+    }
+    // a pipe: the codec thread passes on the bytes already read
+    clearerr(file);
+    return 1;
+}
+
+// Read up to `size` bytes of the input of `zpipe` into `buffer`, starting
+// with the bytes read by `zpipe_open_read`. Returns the number of bytes
+// read, zero at the end of the input or on error.
+//
+static size_t
+read_input (struct zpipe * const zpipe, unsigned char *buffer, const size_t size) {
+    size_t count = zpipe->prefix_length;
+    if (count) {
+        (void) memcpy(buffer, zpipe->prefix, count);
+        zpipe->prefix_length = 0;
+    }
+    count += fread(buffer + count, 1, size - count, zpipe->file);
+    if (!count && ferror(zpipe->file)) {
+        zpipe->error = errno ? errno : EIO;
+    }
+    return count;
+}
+
+#if defined(ZPIPE_ENABLE_ZLIB) || defined(ZPIPE_ENABLE_ZSTD) || defined(ZPIPE_ENABLE_LZMA)
+// Write `count` bytes from `data` to the output of `zpipe`, returns false
+// on error.
+//
+static bool
+write_output (struct zpipe * const zpipe, const void *data, const size_t count) {
+    if (count && !fwrite(data, count, 1, zpipe->file)) {
+        zpipe->error = errno ? errno : EIO;
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Returns the block of `ring` being filled by the reader, acquiring a new
+// one if `*block` is NULL.
+//
+static struct ring_block *
+output_block (struct ring * const ring, struct ring_block **block) {
+    if (!*block) {
+        *block = ring_acquire(ring);
+        (*block)->address = 0;
+        (*block)->length = 0;
+    }
+    return *block;
+}
+
+// Pass `*block` on to the consumer of `ring` if it is full (or `force`
+// and it is not empty).
+//
+static void
+commit_block (struct ring * const ring, struct ring_block **block, const bool force) {
+    if (*block && ((*block)->length == RING_BLOCK_SIZE || (force && (*block)->length))) {
+        ring_commit(ring);
+        *block = NULL;
+    }
+}
+
+// Each codec reads or writes the stream of `zpipe`, from or to the blocks
+// of `ring`, using `buffer` of `ZPIPE_BUFFER_SIZE` bytes for the
+// compressed data. Returns false on error (`zpipe->error` may be set).
+
+static bool
+copy_read (struct zpipe * const zpipe, struct ring * const ring, unsigned char *buffer) {
+    struct ring_block *block = NULL;
+    size_t count;
+    (void) buffer;
+    do {
+        output_block(ring, &block);
+        count = read_input(zpipe, block->data + block->length,
+                           RING_BLOCK_SIZE - block->length);
+        block->length += count;
+        commit_block(ring, &block, false);
+    } while (count);
+    commit_block(ring, &block, true);
+    return !zpipe->error;
+}
+
+#ifdef ZPIPE_ENABLE_ZLIB
+static bool
+gzip_read (struct zpipe * const zpipe, struct ring * const ring, unsigned char *buffer) {
+    struct ring_block *block = NULL;
+    z_stream stream;
+    int status = Z_OK;
+    bool full = false;
+
+    (void) memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        zpipe->error = ENOMEM;
+        return false;
+    }
+    for (;;) {
+        if (!stream.avail_in && !full) {
+            stream.next_in = buffer;
+            stream.avail_in = (uInt) read_input(zpipe, buffer, ZPIPE_BUFFER_SIZE);
+            if (!stream.avail_in) {
+                break;
+            }
+        }
+        if (status == Z_STREAM_END) {
+            // another gzip member follows
+            (void) inflateReset(&stream);
+        }
+        output_block(ring, &block);
+        stream.next_out = block->data + block->length;
+        stream.avail_out = (uInt) (RING_BLOCK_SIZE - block->length);
+        status = inflate(&stream, Z_NO_FLUSH);
+        block->length = RING_BLOCK_SIZE - stream.avail_out;
+        full = (stream.avail_out == 0 && status != Z_STREAM_END);
+        commit_block(ring, &block, false);
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+            break;
+        }
+    }
+    commit_block(ring, &block, true);
+    (void) inflateEnd(&stream);
+    if (status != Z_STREAM_END && !zpipe->error) {
+        zpipe->error = (status == Z_MEM_ERROR) ? ENOMEM : EIO;
+    }
+    return !zpipe->error;
+}
+
+static bool
+gzip_write (struct zpipe * const zpipe, struct ring * const ring, unsigned char *buffer) {
+    struct ring_block *block;
+    z_stream stream;
+    int flush = Z_NO_FLUSH;
+    int status;
+
+    (void) memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        zpipe->error = ENOMEM;
+        return false;
+    }
+    do {
+        if ((block = ring_next(ring))) {
+            stream.next_in = block->data;
+            stream.avail_in = (uInt) block->length;
+        } else {
+            flush = Z_FINISH;
+        }
+        do {
+            stream.next_out = buffer;
+            stream.avail_out = (uInt) ZPIPE_BUFFER_SIZE;
+            if ((status = deflate(&stream, flush)) == Z_BUF_ERROR) {
+                status = Z_OK; // an empty block
+            }
+            if (!write_output(zpipe, buffer, ZPIPE_BUFFER_SIZE - stream.avail_out)) {
+                status = Z_ERRNO;
+            }
+        } while (status == Z_OK && (stream.avail_in || !stream.avail_out));
+        if (block) {
+            ring_release(ring);
+        }
+    } while (block && status == Z_OK);
+    (void) deflateEnd(&stream);
+    if (status != Z_STREAM_END && !zpipe->error) {
+        zpipe->error = EIO;
+    }
+    return !zpipe->error;
+}
+#endif
+
+#ifdef ZPIPE_ENABLE_ZSTD
+static bool
+zstd_read (struct zpipe * const zpipe, struct ring * const ring, unsigned char *buffer) {
+    struct ring_block *block = NULL;
+    ZSTD_DStream * const stream = ZSTD_createDStream();
+    ZSTD_inBuffer input = { NULL, 0, 0 };
+    size_t status = 1;
+    bool full = false;
+
+    if (!stream) {
+        zpipe->error = ENOMEM;
+        return false;
+    }
+    (void) ZSTD_initDStream(stream);
+    input.src = buffer;
+    for (;;) {
+        ZSTD_outBuffer output;
+        if (input.pos == input.size && !full) {
+            input.pos = 0;
+            input.size = read_input(zpipe, buffer, ZPIPE_BUFFER_SIZE);
+            if (!input.size) {
+                break;
+            }
+        }
+        output_block(ring, &block);
+        output.dst = block->data;
+        output.size = RING_BLOCK_SIZE;
+        output.pos = block->length;
+        status = ZSTD_decompressStream(stream, &output, &input);
+        block->length = output.pos;
+        full = (output.pos == output.size);
+        commit_block(ring, &block, false);
+        if (ZSTD_isError(status)) {
+            break;
+        }
+    }
+    commit_block(ring, &block, true);
+    (void) ZSTD_freeDStream(stream);
+    if (status != 0 && !zpipe->error) {
+        // an error, or the last frame is incomplete
+        zpipe->error = EIO;
+    }
+    return !zpipe->error;
+}
+
+static bool
+zstd_write (struct zpipe * const zpipe, struct ring * const ring, unsigned char *buffer) {
+    struct ring_block *block;
+    ZSTD_CStream * const stream = ZSTD_createCStream();
+    size_t status = 0;
+
+    if (!stream) {
+        zpipe->error = ENOMEM;
+        return false;
+    }
+    (void) ZSTD_initCStream(stream, ZSTD_CLEVEL_DEFAULT);
+    do {
+        ZSTD_inBuffer input = { NULL, 0, 0 };
+        ZSTD_EndDirective mode = ZSTD_e_end;
+        if ((block = ring_next(ring))) {
+            input.src = block->data;
+            input.size = block->length;
+            mode = ZSTD_e_continue;
+        }
+        do {
+            ZSTD_outBuffer output;
+            output.dst = buffer;
+            output.size = ZPIPE_BUFFER_SIZE;
+            output.pos = 0;
+            status = ZSTD_compressStream2(stream, &output, &input, mode);
+            if (ZSTD_isError(status)) {
+                break;
+            }
+            if (!write_output(zpipe, buffer, output.pos)) {
+                break;
+            }
+        } while (input.pos < input.size || (mode == ZSTD_e_end && status));
+        if (block) {
+            ring_release(ring);
+        }
+    } while (block && !ZSTD_isError(status) && !zpipe->error);
+    (void) ZSTD_freeCStream(stream);
+    if ((status || block) && !zpipe->error) {
+        zpipe->error = EIO;
+    }
+    return !zpipe->error;
+}
+#endif
+
+#ifdef ZPIPE_ENABLE_LZMA
+static bool
+xz_read (struct zpipe * const zpipe, struct ring * const ring, unsigned char *buffer) {
+    struct ring_block *block = NULL;
+    lzma_stream stream = LZMA_STREAM_INIT;
+    lzma_action action = LZMA_RUN;
+    lzma_ret status;
+
+    if (lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+        zpipe->error = ENOMEM;
+        return false;
+    }
+    do {
+        if (!stream.avail_in && action == LZMA_RUN) {
+            stream.next_in = buffer;
+            stream.avail_in = read_input(zpipe, buffer, ZPIPE_BUFFER_SIZE);
+            if (!stream.avail_in) {
+                action = LZMA_FINISH;
+            }
+        }
+        output_block(ring, &block);
+        stream.next_out = block->data + block->length;
+        stream.avail_out = RING_BLOCK_SIZE - block->length;
+        status = lzma_code(&stream, action);
+        block->length = RING_BLOCK_SIZE - stream.avail_out;
+        commit_block(ring, &block, false);
+    } while (status == LZMA_OK);
+    commit_block(ring, &block, true);
+    lzma_end(&stream);
+    if (status != LZMA_STREAM_END && !zpipe->error) {
+        zpipe->error = (status == LZMA_MEM_ERROR) ? ENOMEM : EIO;
+    }
+    return !zpipe->error;
+}
+
+static bool
+xz_write (struct zpipe * const zpipe, struct ring * const ring, unsigned char *buffer) {
+    struct ring_block *block;
+    lzma_stream stream = LZMA_STREAM_INIT;
+    lzma_action action = LZMA_RUN;
+    lzma_ret status;
+
+    if (lzma_easy_encoder(&stream, LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC64) != LZMA_OK) {
+        zpipe->error = ENOMEM;
+        return false;
+    }
+    do {
+        if ((block = ring_next(ring))) {
+            stream.next_in = block->data;
+            stream.avail_in = block->length;
+        } else {
+            action = LZMA_FINISH;
+        }
+        do {
+            stream.next_out = buffer;
+            stream.avail_out = ZPIPE_BUFFER_SIZE;
+            status = lzma_code(&stream, action);
+            if (!write_output(zpipe, buffer, ZPIPE_BUFFER_SIZE - stream.avail_out)) {
+                status = LZMA_PROG_ERROR;
+            }
+        } while (status == LZMA_OK && (stream.avail_in || !stream.avail_out));
+        if (block) {
+            ring_release(ring);
+        }
+    } while (block && status == LZMA_OK);
+    lzma_end(&stream);
+    if (status != LZMA_STREAM_END && !zpipe->error) {
+        zpipe->error = EIO;
+    }
+    return !zpipe->error;
+}
+#endif
+
+// Run the codec of `ring->context` in the thread of `ring`.
+//
+static void *
+zpipe_run (void *argument) {
+    struct ring * const ring = (struct ring *) argument;
+    struct zpipe * const zpipe = (struct zpipe *) ring->context;
+    const bool writer = zpipe->compress;
+    unsigned char *buffer = malloc(ZPIPE_BUFFER_SIZE);
+    bool (*codec)(struct zpipe *, struct ring *, unsigned char *) = NULL;
+
+    switch (zpipe->format) {
+    case ZPIPE_NONE:
+        codec = writer ? NULL : copy_read;
+        break;
+#ifdef ZPIPE_ENABLE_ZLIB
+    case ZPIPE_GZIP:
+        codec = writer ? gzip_write : gzip_read;
+        break;
+#endif
+#ifdef ZPIPE_ENABLE_ZSTD
+    case ZPIPE_ZSTD:
+        codec = writer ? zstd_write : zstd_read;
+        break;
+#endif
+#ifdef ZPIPE_ENABLE_LZMA
+    case ZPIPE_XZ:
+        codec = writer ? xz_write : xz_read;
+        break;
+#endif
+    default:
+        break;
+    }
+
+    if (!buffer || !codec) {
+        zpipe->error = buffer ? ENOTSUP : ENOMEM;
+    } else if (!codec(zpipe, ring, buffer) && !zpipe->error) {
+        zpipe->error = EIO;
+    }
+    if (writer) {
+        if (!zpipe->error && fflush(zpipe->file)) {
+            zpipe->error = errno ? errno : EIO;
+        }
+        // drain the ring after an error, so that the producer can finish
+        while (ring_next(ring)) {
+            ring_release(ring);
+        }
+    } else {
+        ring_close(ring);
+    }
+    free(buffer);
+    ring->error = (zpipe->error != 0);
+    return NULL;
+}
+
+bool
+zpipe_start_reader (struct zpipe * const zpipe, struct ring * const ring) {
+    zpipe->compress = false;
+    ring->context = zpipe;
+    return ring_start_thread(ring, zpipe_run);
+}
+
+bool
+zpipe_start_writer (struct zpipe * const zpipe, struct ring * const ring,
+                    FILE *file, const enum zpipe_format format) {
+    if (!zpipe_format_supported(format)) {
+        errno = ENOTSUP;
+        return false;
+    }
+    zpipe->file = file;
+    zpipe->format = format;
+    zpipe->error = 0;
+    zpipe->prefix_length = 0;
+    zpipe->compress = true;
+    ring->context = zpipe;
+    return ring_start_thread(ring, zpipe_run);
+}
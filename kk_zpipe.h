@@ -0,0 +1,102 @@
+/*
+ * kk_zpipe.h: Transparent compression and decompression of the input and
+ * output files of the command-line tools, in gzip, zstd, or xz format.
+ *
+ * An input file is recognised as compressed by the magic bytes at its
+ * beginning, in which case a codec thread reads and decompresses it into
+ * the blocks of a ring buffer (see `kk_ring.h`), from which the converter
+ * takes them just as with `--pipeline`. Likewise a codec thread can take
+ * the blocks of output from a ring buffer and write them compressed. The
+ * codec thus runs concurrently with the conversion, in the same process.
+ *
+ * Each format needs its library, enabled when building `kk_zpipe.c` with
+ * the respective flag: `ZPIPE_ENABLE_ZLIB` (gzip, link with `-lz`),
+ * `ZPIPE_ENABLE_ZSTD` (zstd, link with `-lzstd`), and `ZPIPE_ENABLE_LZMA`
+ * (xz, link with `-llzma`).
+ * Threads are required for all of them (see `kk_ring.h`).
+ *
+ * The sequence to read a possibly compressed file is:
+ *      struct zpipe zpipe;
+ *      struct ring ring;
+ *      switch (zpipe_open_read(&zpipe, file)) {
+ *      case 0: // read `file` normally
+ *      case 1: // read the blocks of `ring`, see `kk_ring.h`:
+ *          ring_init(&ring, RING_DEFAULT_BLOCK_COUNT);
+ *          zpipe_start_reader(&zpipe, &ring);
+ *          // ring_next, ring_release, ring_join, ring_free
+ *      default: // error, see errno
+ *      }
+ *
+ * The sequence to write a compressed file is:
+ *      ring_init(&ring, RING_DEFAULT_BLOCK_COUNT);
+ *      zpipe_start_writer(&zpipe, &ring, file, ZPIPE_GZIP);
+ *      // ring_acquire, ring_commit, ring_close, ring_join, ring_free
+ *
+ * If `ring_join` returns false, the codec failed and `zpipe.error` is the
+ * `errno` of the failure (`EIO` for corrupt or truncated compressed data).
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com/
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Use and distribute freely, mark modified copies as such.
+ */
+
+#ifndef KK_ZPIPE_H
+#define KK_ZPIPE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "kk_ring.h"
+
+#define ZPIPE_MAGIC_MAX_LENGTH 6
+
+enum zpipe_format {
+    ZPIPE_NONE = 0,
+    ZPIPE_GZIP,
+    ZPIPE_ZSTD,
+    ZPIPE_XZ
+};
+
+typedef struct zpipe {
+    FILE                *file;
+    enum zpipe_format   format;
+    int                 error;          // `errno` of a failure of the codec
+    bool                compress;       // whether the codec is a writer
+    size_t              prefix_length;  // bytes read to detect the format
+    unsigned char       prefix[ZPIPE_MAGIC_MAX_LENGTH];
+} kk_zpipe_t;
+
+// Returns the format named by `arg` ("gzip", "zstd", or "xz"), or
+// `ZPIPE_NONE` if it is not recognised
+enum zpipe_format zpipe_format_option(const char *arg);
+
+// Returns whether `format` is supported by this build
+bool zpipe_format_supported(enum zpipe_format format);
+
+// Detect the format of the input `file` from its first bytes. Returns 0
+// if `file` is not compressed and can be read directly, or 1 if it must
+// be read with `zpipe_start_reader`, i.e., it is compressed, or the bytes
+// read to detect the format could not be put back (e.g., a pipe). Returns
+// -1 on error, e.g., if the format is not supported (see `errno`).
+int zpipe_open_read(struct zpipe *zpipe, FILE *file);
+
+// Start a thread that reads the file given to `zpipe_open_read`,
+// decompressing it as needed, into the blocks of `ring` (which must be
+// initialised), and closes `ring` at the end. Returns false on error.
+bool zpipe_start_reader(struct zpipe *zpipe, struct ring *ring);
+
+// Start a thread that writes the blocks of `ring` (which must be
+// initialised) to `file`, compressed in `format`, until `ring` is closed.
+// The blocks are written in order, i.e., their `address` is ignored.
+// The file is flushed but not closed. Returns false on error.
+bool zpipe_start_writer(struct zpipe *zpipe, struct ring *ring,
+                        FILE *file, enum zpipe_format format);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !KK_ZPIPE_H
@@ -7,11 +7,24 @@
  * `-o` specifies the output file, which will be a 16-bit ROM image.
  * Output is to `stdout` by default.
  *
+ * The option `-w 2` makes each half 16 bits wide instead of 8, i.e., it
+ * merges two 16-bit images into a 32-bit image. The inputs must have the
+ * same length, unless the option `-f` is given to pad the shorter input
+ * with the specified fill byte.
+ *
+ * The option `-x` makes the inputs and the output Intel HEX instead of
+ * binary, with the addresses of the inputs doubled (see `kk_ihex_lanes.h`).
+ * Gaps in the inputs then remain gaps in the output, and the option `-f`
+ * has no effect.
+ *
  * Copyright (c) 2019 Kimmo Kulovesi, https://arkku.com
  * Provided with absolutely no warranty, use at your own risk only.
  * Distribute freely, mark modified copies as such.
  */
 
+#include "kk_lanes.h"
+#include "kk_ihex_lanes.h"
+#include "kk_swap.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,6 +36,13 @@ main (int argc, char *argv[]) {
     FILE *outfile = stdout;
     FILE *inhigh = NULL;
     FILE *inlow = NULL;
+    FILE *infile[2];
+    const char *inname[2] = { NULL };
+    unsigned lane_width = 1;
+    bool ihex_mode = false;
+    enum swap_mode swap = SWAP_NONE;
+    int fill = LANES_NO_FILL;
+    int status = EXIT_SUCCESS;
     char *arg = NULL;
 
     while (--argc) {
@@ -46,6 +66,7 @@ main (int argc, char *argv[]) {
                 if (!(inhigh = fopen(*argv, "rb"))) {
                     goto argument_error;
                 }
+                inname[1] = *argv;
                 break;
             case 'l':
                 if (--argc == 0) {
@@ -55,6 +76,40 @@ main (int argc, char *argv[]) {
                 if (!(inlow = fopen(*argv, "rb"))) {
                     goto argument_error;
                 }
+                inname[0] = *argv;
+                break;
+            case 'w': {
+                unsigned long width;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                width = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !width || width > LANES_MAX_WIDTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                lane_width = (unsigned) width;
+                break;
+            }
+            case 'f': {
+                unsigned long byte;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                byte = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || byte > 0xFFUL) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                fill = (int) byte;
+                break;
+            }
+            case 'x':
+                ihex_mode = true;
                 break;
             case '?':
                 arg = NULL;
@@ -63,12 +118,15 @@ main (int argc, char *argv[]) {
                 goto invalid_argument;
             }
             continue;
+        } else if ((swap = swap_option(arg)) != SWAP_NONE) {
+            continue;
         }
 invalid_argument:
         (void) fprintf(stderr, "Invalid argument: %s\n", arg);
 usage:
         (void) fprintf(stderr, "merge16bit - Copyright (c) 2019 Kimmo Kulovesi\n");
-        (void) fprintf(stderr, "Usage: merge16bit [-o <out.bin>] <-h highfile> <-l lowfile>\n");
+        (void) fprintf(stderr, "Usage: merge16bit [-o <out.bin>] [-w <width>] [-f <fill>] [-x]\n"
+                               "                  [--swap16|--swap32|--swapwords] <-h highfile> <-l lowfile>\n");
         return arg ? EXIT_FAILURE : EXIT_SUCCESS;
 argument_error:
         perror(*argv);
@@ -80,33 +138,34 @@ argument_error:
         goto usage;
     }
 
-    errno = 0;
-    for (;;) {
-        int byte = fgetc(inlow);
-        if (byte == EOF) {
-            break;
+    infile[0] = inlow;
+    infile[1] = inhigh;
+    if (ihex_mode) {
+        if (!ihex_lanes_merge(infile, inname, outfile, 2, lane_width, swap)) {
+            status = EXIT_FAILURE;
         }
-        if (fputc(byte, outfile) == EOF) {
+    } else {
+        switch (lanes_merge(infile, outfile, 2, lane_width, fill, swap)) {
+        case LANES_MERGE_OK:
             break;
-        }
-        byte = fgetc(inhigh);
-        if (byte == EOF) {
+        case LANES_MERGE_UNEQUAL:
+            (void) fprintf(stderr, "Input files have different lengths"
+                                   " (use -f to pad them)\n");
+            status = EXIT_FAILURE;
             break;
-        }
-        if (fputc(byte, outfile) == EOF) {
+        default:
+            perror("Error");
+            status = EXIT_FAILURE;
             break;
         }
     }
 
-    if (errno) {
-        perror("Error");
-    }
-
     (void) fclose(inlow);
     (void) fclose(inhigh);
-    if (outfile != stdout) {
-        (void) fclose(outfile);
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("Error");
+        status = EXIT_FAILURE;
     }
 
-    return errno ? EXIT_FAILURE : EXIT_SUCCESS;
+    return status;
 }
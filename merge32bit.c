@@ -7,11 +7,24 @@
  * be used to merge a 32-bit ROM image that has been split into four 8-bit
  * images into a a single 32-bit file.
  *
+ * The option `-w 2` makes each input 16 bits wide instead of 8, i.e., it
+ * merges four 16-bit images into a 64-bit image. The inputs must have the
+ * same length, unless the option `-f` is given to pad the shorter inputs
+ * with the specified fill byte.
+ *
+ * The option `-x` makes the inputs and the output Intel HEX instead of
+ * binary, with the addresses of the inputs multiplied by four (see
+ * `kk_ihex_lanes.h`). Gaps in the inputs then remain gaps in the output,
+ * and the option `-f` has no effect.
+ *
  * Copyright (c) 2019 Kimmo Kulovesi, https://arkku.com
  * Provided with absolutely no warranty, use at your own risk only.
  * Distribute freely, mark modified copies as such.
  */
 
+#include "kk_lanes.h"
+#include "kk_ihex_lanes.h"
+#include "kk_swap.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,6 +36,12 @@ main (int argc, char *argv[]) {
     int i;
     FILE *outfile = stdout;
     FILE *infile[4] = { NULL };
+    const char *inname[4] = { NULL };
+    unsigned lane_width = 1;
+    bool ihex_mode = false;
+    enum swap_mode swap = SWAP_NONE;
+    int fill = LANES_NO_FILL;
+    int status = EXIT_SUCCESS;
     char *arg = NULL;
 
     while (--argc) {
@@ -50,8 +69,42 @@ main (int argc, char *argv[]) {
                 if (!(infile[byte_number] = fopen(*argv, "rb"))) {
                     goto argument_error;
                 }
+                inname[byte_number] = *argv;
+                break;
+            }
+            case 'w': {
+                unsigned long width;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                width = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !width || width > LANES_MAX_WIDTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                lane_width = (unsigned) width;
                 break;
             }
+            case 'f': {
+                unsigned long byte;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                byte = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || byte > 0xFFUL) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                fill = (int) byte;
+                break;
+            }
+            case 'x':
+                ihex_mode = true;
+                break;
             case '?':
                 arg = NULL;
                 goto usage;
@@ -59,12 +112,15 @@ main (int argc, char *argv[]) {
                 goto invalid_argument;
             }
             continue;
+        } else if ((swap = swap_option(arg)) != SWAP_NONE) {
+            continue;
         }
 invalid_argument:
         (void) fprintf(stderr, "Invalid argument: %s\n", arg);
 usage:
         (void) fprintf(stderr, "merge32bit - Copyright (c) 2019 Kimmo Kulovesi\n");
-        (void) fprintf(stderr, "Usage: merge32bit [-o <out.bin>] <-{0,1,2,3} inN.bin>\n");
+        (void) fprintf(stderr, "Usage: merge32bit [-o <out.bin>] [-w <width>] [-f <fill>] [-x]\n"
+                               "                  [--swap16|--swap32|--swapwords] <-{0,1,2,3} inN.bin>\n");
         return arg ? EXIT_FAILURE : EXIT_SUCCESS;
 argument_error:
         perror(*argv);
@@ -76,30 +132,33 @@ argument_error:
         goto usage;
     }
 
-    errno = 0;
-    for (;;) {
-        for (i = 0; i < 4; ++i) {
-            int byte = fgetc(infile[i]);
-            if (byte == EOF) {
-                goto end_read;
-            }
-            if (fputc(byte, outfile) == EOF) {
-                goto end_read;
-            }
+    if (ihex_mode) {
+        if (!ihex_lanes_merge(infile, inname, outfile, 4, lane_width, swap)) {
+            status = EXIT_FAILURE;
+        }
+    } else {
+        switch (lanes_merge(infile, outfile, 4, lane_width, fill, swap)) {
+        case LANES_MERGE_OK:
+            break;
+        case LANES_MERGE_UNEQUAL:
+            (void) fprintf(stderr, "Input files have different lengths"
+                                   " (use -f to pad them)\n");
+            status = EXIT_FAILURE;
+            break;
+        default:
+            perror("Error");
+            status = EXIT_FAILURE;
+            break;
         }
-    }
-end_read:
-
-    if (errno) {
-        perror("Error");
     }
 
     for (i = 0; i < 4; ++i) {
         (void) fclose(infile[i]);
     }
-    if (outfile != stdin) {
-        (void) fclose(outfile);
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("Error");
+        status = EXIT_FAILURE;
     }
 
-    return errno ? EXIT_FAILURE : EXIT_SUCCESS;
+    return status;
 }
@@ -6,11 +6,20 @@
  * `-l` specify the high and low output files, respectively. Input is
  * read from `stdin` by default.
  *
+ * The option `-w 2` makes each half 16 bits wide instead of 8, i.e., it
+ * splits a 32-bit ROM image into two 16-bit images.
+ *
+ * The option `-x` makes the input and the outputs Intel HEX instead of
+ * binary, with the addresses of the outputs halved (see `kk_ihex_lanes.h`).
+ *
  * Copyright (c) 2019 Kimmo Kulovesi, https://arkku.com
  * Provided with absolutely no warranty, use at your own risk only.
  * Distribute freely, mark modified copies as such.
  */
 
+#include "kk_lanes.h"
+#include "kk_ihex_lanes.h"
+#include "kk_swap.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,8 +29,14 @@
 int
 main (int argc, char *argv[]) {
     FILE *infile = stdin;
+    const char *inname = "stdin";
     FILE *outhigh = NULL;
     FILE *outlow = NULL;
+    FILE *outfile[2];
+    unsigned lane_width = 1;
+    bool ihex_mode = false;
+    enum swap_mode swap = SWAP_NONE;
+    int status = EXIT_SUCCESS;
     char *arg = NULL;
 
     while (--argc) {
@@ -36,6 +51,7 @@ main (int argc, char *argv[]) {
                 if (!(infile = fopen(*argv, "rb"))) {
                     goto argument_error;
                 }
+                inname = *argv;
                 break;
             case 'h':
                 if (--argc == 0) {
@@ -55,6 +71,24 @@ main (int argc, char *argv[]) {
                     goto argument_error;
                 }
                 break;
+            case 'w': {
+                unsigned long width;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                width = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !width || width > LANES_MAX_WIDTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                lane_width = (unsigned) width;
+                break;
+            }
+            case 'x':
+                ihex_mode = true;
+                break;
             case '?':
                 arg = NULL;
                 goto usage;
@@ -62,12 +96,15 @@ main (int argc, char *argv[]) {
                 goto invalid_argument;
             }
             continue;
+        } else if ((swap = swap_option(arg)) != SWAP_NONE) {
+            continue;
         }
 invalid_argument:
         (void) fprintf(stderr, "Invalid argument: %s\n", arg);
 usage:
         (void) fprintf(stderr, "split16bit - Copyright (c) 2019 Kimmo Kulovesi\n");
-        (void) fprintf(stderr, "Usage: split16bit [-i <in.bin>] <-h highfile> <-l lowfile>\n");
+        (void) fprintf(stderr, "Usage: split16bit [-i <in.bin>] [-w <width>] [-x]\n"
+                               "                  [--swap16|--swap32|--swapwords] <-h highfile> <-l lowfile>\n");
         return arg ? EXIT_FAILURE : EXIT_SUCCESS;
 argument_error:
         perror(*argv);
@@ -79,33 +116,24 @@ argument_error:
         goto usage;
     }
 
-    errno = 0;
-    for (;;) {
-        int byte = fgetc(infile);
-        if (byte == EOF) {
-            break;
-        }
-        if (fputc(byte, outlow) == EOF) {
-            break;
-        }
-        byte = fgetc(infile);
-        if (byte == EOF) {
-            break;
+    outfile[0] = outlow;
+    outfile[1] = outhigh;
+    if (ihex_mode) {
+        if (!ihex_lanes_split(infile, inname, outfile, 2, lane_width, swap)) {
+            status = EXIT_FAILURE;
         }
-        if (fputc(byte, outhigh) == EOF) {
-            break;
-        }
-    }
-
-    if (errno) {
+    } else if (!lanes_split(infile, outfile, 2, lane_width, swap)) {
         perror("Error");
+        status = EXIT_FAILURE;
     }
 
-    (void) fclose(outhigh);
-    (void) fclose(outlow);
+    if (fclose(outhigh) | fclose(outlow)) {
+        perror("fclose");
+        status = EXIT_FAILURE;
+    }
     if (infile != stdin) {
         (void) fclose(infile);
     }
 
-    return errno ? EXIT_FAILURE : EXIT_SUCCESS;
+    return status;
 }
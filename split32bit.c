@@ -6,11 +6,21 @@
  * `-2`, and `-3` specify the output files for each of the four bytes
  * that make up the 32-bit dword.
  *
+ * The option `-w 2` makes each part 16 bits wide instead of 8, i.e., it
+ * splits a 64-bit ROM image into four 16-bit images.
+ *
+ * The option `-x` makes the input and the outputs Intel HEX instead of
+ * binary, with the addresses of the outputs divided by four (see
+ * `kk_ihex_lanes.h`).
+ *
  * Copyright (c) 2019 Kimmo Kulovesi, https://arkku.com
  * Provided with absolutely no warranty, use at your own risk only.
  * Distribute freely, mark modified copies as such.
  */
 
+#include "kk_lanes.h"
+#include "kk_ihex_lanes.h"
+#include "kk_swap.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,7 +31,12 @@ int
 main (int argc, char *argv[]) {
     int i;
     FILE *infile = stdin;
+    const char *inname = "stdin";
     FILE *outfile[4] = { NULL };
+    unsigned lane_width = 1;
+    bool ihex_mode = false;
+    enum swap_mode swap = SWAP_NONE;
+    int status = EXIT_SUCCESS;
     char *arg = NULL;
 
     while (--argc) {
@@ -33,9 +48,10 @@ main (int argc, char *argv[]) {
                     goto invalid_argument;
                 }
                 ++argv;
-                if (!(infile = fopen(*argv, "r"))) {
+                if (!(infile = fopen(*argv, "rb"))) {
                     goto argument_error;
                 }
+                inname = *argv;
                 break;
             case '3':
             case '2':
@@ -51,6 +67,24 @@ main (int argc, char *argv[]) {
                 }
                 break;
             }
+            case 'w': {
+                unsigned long width;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                width = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !width || width > LANES_MAX_WIDTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                lane_width = (unsigned) width;
+                break;
+            }
+            case 'x':
+                ihex_mode = true;
+                break;
             case '?':
                 arg = NULL;
                 goto usage;
@@ -58,12 +92,15 @@ main (int argc, char *argv[]) {
                 goto invalid_argument;
             }
             continue;
+        } else if ((swap = swap_option(arg)) != SWAP_NONE) {
+            continue;
         }
 invalid_argument:
         (void) fprintf(stderr, "Invalid argument: %s\n", arg);
 usage:
         (void) fprintf(stderr, "split32bit - Copyright (c) 2019 Kimmo Kulovesi\n");
-        (void) fprintf(stderr, "Usage: split32bit [-i <in.bin>] <-{0,1,2,3} outN.bin>\n");
+        (void) fprintf(stderr, "Usage: split32bit [-i <in.bin>] [-w <width>] [-x]\n"
+                               "                  [--swap16|--swap32|--swapwords] <-{0,1,2,3} outN.bin>\n");
         return arg ? EXIT_FAILURE : EXIT_SUCCESS;
 argument_error:
         perror(*argv);
@@ -75,30 +112,24 @@ argument_error:
         goto usage;
     }
 
-    errno = 0;
-    for (;;) {
-        for (i = 0; i < 4; ++i) {
-            int byte = fgetc(infile);
-            if (byte == EOF) {
-                goto end_read;
-            }
-            if (fputc(byte, outfile[i]) == EOF) {
-                goto end_read;
-            }
+    if (ihex_mode) {
+        if (!ihex_lanes_split(infile, inname, outfile, 4, lane_width, swap)) {
+            status = EXIT_FAILURE;
         }
-    }
-end_read:
-
-    if (errno) {
+    } else if (!lanes_split(infile, outfile, 4, lane_width, swap)) {
         perror("Error");
+        status = EXIT_FAILURE;
     }
 
     for (i = 0; i < 4; ++i) {
-        (void) fclose(outfile[i]);
+        if (fclose(outfile[i])) {
+            perror("fclose");
+            status = EXIT_FAILURE;
+        }
     }
     if (infile != stdin) {
         (void) fclose(infile);
     }
 
-    return errno ? EXIT_FAILURE : EXIT_SUCCESS;
+    return status;
 }
@@ -0,0 +1,217 @@
+/*
+ * srec2ihex.c: Convert Motorola S-records to Intel HEX.
+ *
+ * Usage: srec2ihex [-i <in.srec>] [-o <out.hex>] [-b <length>] [-v]
+ *
+ * The input is converted record by record in a single pass, without
+ * converting it to binary, i.e., gaps in the data are preserved and the
+ * conversion takes time in proportion to the data and not the address
+ * range it spans. The data records (S1, S2, and S3) may have any address
+ * width, and may be mixed. Contiguous data is joined into full output
+ * records of the number of bytes set with the option `-b` (default 32).
+ *
+ * A non-zero start address in the termination record (S7, S8, or S9) is
+ * written as a start linear address record. The header record (S0) is
+ * shown with the option `-v`, and a record count (S5 or S6) is checked
+ * against the number of data records read.
+ *
+ * Copyright (c) 2026 Kimmo Kulovesi, https://arkku.com
+ * Provided with absolutely no warranty, use at your own risk only.
+ * Distribute freely, mark modified copies as such.
+ */
+
+#include "kk_srec_read.h"
+#include "kk_ihex_write.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+static FILE *outfile;
+static struct ihex_state output;
+static unsigned long line_number = 1L;
+static unsigned long record_count = 0;
+static bool debug_enabled = false;
+static bool end_of_file = false;
+
+// The address at which the next byte would be written without changing
+// the address
+static unsigned long long output_address = ~0ULL;
+
+int
+main (int argc, char *argv[]) {
+    struct srec_state srec;
+    FILE *infile = stdin;
+    uint8_t line_length = IHEX_DEFAULT_OUTPUT_LINE_LENGTH;
+    srec_count_t count;
+    char buf[256];
+    char *arg = NULL;
+
+    outfile = stdout;
+
+    while (--argc) {
+        arg = *(++argv);
+        if (arg[0] == '-' && arg[1] && arg[2] == '\0') {
+            switch (arg[1]) {
+            case 'i':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(infile = fopen(*argv, "r"))) {
+                    goto argument_error;
+                }
+                break;
+            case 'o':
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                if (!(outfile = fopen(*argv, "w"))) {
+                    goto argument_error;
+                }
+                break;
+            case 'b': {
+                unsigned long length;
+                if (--argc == 0) {
+                    goto invalid_argument;
+                }
+                ++argv;
+                errno = 0;
+                length = strtoul(*argv, &arg, 0);
+                if (errno || arg == *argv || !length || length > IHEX_MAX_OUTPUT_LINE_LENGTH) {
+                    errno = errno ? errno : EINVAL;
+                    goto argument_error;
+                }
+                line_length = (uint8_t) length;
+                break;
+            }
+            case 'v':
+                debug_enabled = true;
+                break;
+            case 'h':
+            case '?':
+                arg = NULL;
+                goto usage;
+            default:
+                goto invalid_argument;
+            }
+            continue;
+        }
+invalid_argument:
+        (void) fprintf(stderr, "Invalid argument: %s\n", arg);
+usage:
+        (void) fprintf(stderr, "kk_ihex " KK_IHEX_VERSION
+                               " - Copyright (c) 2013-2026 Kimmo Kulovesi\n");
+        (void) fprintf(stderr, "Usage: srec2ihex [-i <in.srec>] [-o <out.hex>]"
+                               " [-b <length>] [-v]\n");
+        return arg ? EXIT_FAILURE : EXIT_SUCCESS;
+argument_error:
+        perror(*argv);
+        return EXIT_FAILURE;
+    }
+
+    ihex_init(&output);
+    ihex_set_output_line_length(&output, line_length);
+
+    srec_begin_read(&srec);
+    while (fgets(buf, sizeof(buf), infile)) {
+        count = (srec_count_t) strlen(buf);
+        srec_read_bytes(&srec, buf, count);
+        line_number += (count && buf[count - 1] == '\n');
+    }
+    srec_end_read(&srec);
+    if (ferror(infile)) {
+        perror("fgets");
+        return EXIT_FAILURE;
+    }
+    if (infile != stdin) {
+        (void) fclose(infile);
+    }
+
+    ihex_end_write(&output);
+    if (outfile != stdout ? fclose(outfile) : fflush(outfile)) {
+        perror("srec2ihex");
+        return EXIT_FAILURE;
+    }
+
+    if (debug_enabled) {
+        (void) fprintf(stderr, "%lu lines read, %lu data records\n",
+                       line_number - 1, record_count);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+srec_bool_t
+srec_data_read (struct srec_state *srec,
+                srec_record_type_t type,
+                srec_bool_t error) {
+    if (error) {
+        (void) fprintf(stderr, "Checksum error on line %lu\n", line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (srec->length < srec->line_length) {
+        (void) fprintf(stderr, "Line length error on line %lu\n", line_number);
+        exit(EXIT_FAILURE);
+    }
+    if (end_of_file) {
+        (void) fprintf(stderr, "Excess data after termination record\n");
+        exit(EXIT_FAILURE);
+    }
+    switch (type) {
+    case SREC_HEADER_RECORD:
+        if (debug_enabled) {
+            (void) fprintf(stderr, "Header: %.*s\n", (int) srec->length,
+                           (const char *) srec->data);
+        }
+        break;
+    case SREC_DATA16_RECORD:
+    case SREC_DATA24_RECORD:
+    case SREC_DATA32_RECORD:
+        ++record_count;
+        if (!srec->length) {
+            break;
+        }
+        if ((unsigned long long) srec->address != output_address) {
+            ihex_write_at_address(&output, (ihex_address_t) srec->address);
+        }
+        output_address = (unsigned long long) srec->address + srec->length;
+        ihex_write_bytes(&output, srec->data, srec->length);
+        break;
+    case SREC_COUNT16_RECORD:
+    case SREC_COUNT24_RECORD: {
+        // the count field has only 16 (S5) or 24 (S6) bits
+        const unsigned long count_mask = (type == SREC_COUNT16_RECORD) ?
+                                         0xFFFFUL : 0xFFFFFFUL;
+        if (srec->address != (srec_address_t) (record_count & count_mask)) {
+            (void) fprintf(stderr, "Warning: Record count %lu does not match"
+                                   " %lu data records read on line %lu\n",
+                           (unsigned long) srec->address, record_count,
+                           line_number);
+        }
+        break;
+    }
+    case SREC_START32_RECORD:
+    case SREC_START24_RECORD:
+    case SREC_START16_RECORD:
+        end_of_file = true;
+        if (srec->address) {
+            ihex_write_start_address(&output, (ihex_address_t) srec->address);
+        }
+        break;
+    default:
+        // ignore reserved record types
+        break;
+    }
+    return true;
+}
+
+#pragma clang diagnostic ignored "-Wunused-parameter"
+
+void
+ihex_flush_buffer(struct ihex_state *ihex, char *buffer, char *eptr) {
+    *eptr = '\0';
+    (void) fputs(buffer, outfile);
+}